@@ -31,6 +31,11 @@
 #define UIP_CONF_BUFFER_SIZE		240
 #endif
 
+/* Save RAM through fewer concurrent 6LoWPAN reassemblies */
+#ifndef SICSLOWPAN_CONF_REASS_CONTEXTS
+#define SICSLOWPAN_CONF_REASS_CONTEXTS 2
+#endif
+
 /* Platform-specific (H/W) AES implementation */
 #ifndef AES_128_CONF
 #define AES_128_CONF cc2420_aes_128_driver
@@ -61,6 +61,10 @@
 #define TSCH_QUEUE_CONF_NUM_PER_NEIGHBOR  4
 #endif
 
+#ifndef SICSLOWPAN_CONF_REASS_CONTEXTS
+#define SICSLOWPAN_CONF_REASS_CONTEXTS    2
+#endif
+
 /* Platform-specific (H/W) AES implementation */
 #ifndef AES_128_CONF
 #define AES_128_CONF cc2420_aes_128_driver
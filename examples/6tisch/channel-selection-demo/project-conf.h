@@ -86,6 +86,11 @@ extern bool tsch_cs_process(void);
 #define TSCH_CALLBACK_CHANNEL_STATS_UPDATED tsch_cs_channel_stats_updated
 #define TSCH_CALLBACK_SELECT_CHANNELS tsch_cs_process
 
+/* Defer unicast transmissions on channels that are bad towards the neighbor */
+#define TSCH_CALLBACK_SKIP_TX_CHANNEL tsch_cs_skip_tx_channel
+/* Learn per-channel P_tx for a few neighbors besides the time source */
+#define TSCH_STATS_CONF_NUM_NEIGHBORS 2
+
 /* The coordinator will update the network nodes with new hopping sequences */
 #define TSCH_PACKET_CONF_EB_WITH_HOPPING_SEQUENCE 1
 
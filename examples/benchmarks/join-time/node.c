@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmark: nodes log how long it takes them to join the network,
+ *         then leave it and measure again. Each node logs when it is
+ *         associated with TSCH, joined to the RPL DODAG, reachable from the
+ *         root, and when its first packet is echoed back by the root.
+ *         Build with CONFIG=CONFIG_FAST_JOIN (default) or CONFIG=CONFIG_DEFAULT
+ *         to compare.
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "net/mac/tsch/tsch.h"
+#include "services/deployment/deployment.h"
+
+#include <inttypes.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#define UDP_PORT 8215
+/* How often to check the join state */
+#define POLL_INTERVAL (CLOCK_SECOND / 16)
+/* How often to send data until the root echoes it */
+#define SEND_INTERVAL (CLOCK_SECOND)
+/* How long to stay in the network before leaving it and rejoining */
+#define REJOIN_DELAY (60 * CLOCK_SECOND)
+/* Number of joins to measure: the first one after boot, then rejoins */
+#define NUM_ROUNDS 3
+
+static struct simple_udp_connection udp_conn;
+static clock_time_t start_time;
+static uint32_t echoed_round;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(app_process, "App process");
+AUTOSTART_PROCESSES(&app_process);
+
+/*---------------------------------------------------------------------------*/
+static void
+log_step(uint32_t round, const char *step)
+{
+  LOG_INFO("Join-time: round %"PRIu32" %s after %lu ms\n", round, step,
+           (unsigned long)((clock_time() - start_time) * 1000 / CLOCK_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  uint32_t round;
+
+  if(datalen != sizeof(round)) {
+    return;
+  }
+  memcpy(&round, data, sizeof(round));
+
+  if(node_id == ROOT_ID) {
+    /* Echo back */
+    simple_udp_sendto(&udp_conn, &round, sizeof(round), sender_addr);
+  } else if(round > echoed_round) {
+    echoed_round = round;
+    process_poll(&app_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(app_process, ev, data)
+{
+  static struct etimer timer;
+  static uip_ipaddr_t root_ipaddr;
+  static uint32_t round;
+
+/* Check 'cond' every POLL_INTERVAL until it holds */
+#define WAIT_UNTIL_POLLED(cond) do { \
+    while(!(cond)) { \
+      etimer_set(&timer, POLL_INTERVAL); \
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer)); \
+    } \
+  } while(0)
+
+  PROCESS_BEGIN();
+
+  /* Initialize UDP connection */
+  simple_udp_register(&udp_conn, UDP_PORT, NULL,
+                      UDP_PORT, udp_rx_callback);
+
+  if(node_id == ROOT_ID) {
+    /* We are the root, start a DAG */
+    NETSTACK_ROUTING.root_start();
+    PROCESS_EXIT();
+  }
+
+  for(round = 1; round <= NUM_ROUNDS; round++) {
+    start_time = clock_time();
+    if(round > 1) {
+      LOG_INFO("Join-time: round %"PRIu32" leaving the network\n", round);
+      tsch_disassociate();
+    }
+
+    WAIT_UNTIL_POLLED(tsch_is_associated);
+    log_step(round, "tsch-associated");
+
+    WAIT_UNTIL_POLLED(NETSTACK_ROUTING.node_has_joined());
+    log_step(round, "rpl-joined");
+
+    WAIT_UNTIL_POLLED(NETSTACK_ROUTING.node_is_reachable());
+    log_step(round, "reachable");
+
+    /* Send to the root until it echoes back */
+    NETSTACK_ROUTING.get_root_ipaddr(&root_ipaddr);
+    while(echoed_round < round) {
+      simple_udp_sendto(&udp_conn, &round, sizeof(round), &root_ipaddr);
+      etimer_set(&timer, SEND_INTERVAL);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer) || ev == PROCESS_EVENT_POLL);
+    }
+    log_step(round, "data-echoed");
+
+    etimer_set(&timer, REJOIN_DELAY);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+  }
+
+  LOG_INFO("Join-time: done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,36 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Testbed configuration */
+#define ROOT_ID 1
+#if CONTIKI_TARGET_COOJA
+#define DEPLOYMENT_MAPPING deployment_cooja8
+#else /* CONTIKI_TARGET_COOJA */
+#define DEPLOYMENT_MAPPING deployment_sics_firefly
+#endif /* CONTIKI_TARGET_COOJA */
+#define IEEE802154_CONF_PANID 0x8922
+
+/* Logging */
+#define LOG_CONF_LEVEL_RPL LOG_LEVEL_WARN
+#define LOG_CONF_LEVEL_MAC LOG_LEVEL_WARN
+#define LOG_CONF_WITH_COMPACT_ADDR 1
+
+/* Provisioning */
+#define NETSTACK_MAX_ROUTE_ENTRIES 25
+#define NBR_TABLE_CONF_MAX_NEIGHBORS 8
+
+/* Scan all 16 channels when joining, while the network hops over 4 */
+#define TSCH_CONF_JOIN_HOPPING_SEQUENCE TSCH_HOPPING_SEQUENCE_16_16
+
+#if CONFIG_FAST_JOIN
+
+/* TSCH: scan where the network was last seen first */
+#define TSCH_CONF_SCAN_WITH_HINTS 1
+/* RPL: ask the time source for a DIO as soon as TSCH is joined */
+#define TSCH_RPL_CONF_DIS_ON_JOIN 1
+/* ND: addresses derived from the MAC address are usable at once */
+#define UIP_ND6_CONF_SKIP_DAD_FOR_DERIVED 1
+
+#endif /* CONFIG_FAST_JOIN */
+
+#endif /* PROJECT_CONF_H_ */
@@ -0,0 +1,38 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Workload size. Can be overridden with e.g.
+ * make DEFINES=RPL_BENCH_NUM_NEIGHBORS=64,RPL_BENCH_NUM_ROUTES=500 */
+#ifndef RPL_BENCH_NUM_NEIGHBORS
+#define RPL_BENCH_NUM_NEIGHBORS 32
+#endif /* RPL_BENCH_NUM_NEIGHBORS */
+
+#ifndef RPL_BENCH_NUM_ROUTES
+#define RPL_BENCH_NUM_ROUTES 250
+#endif /* RPL_BENCH_NUM_ROUTES */
+
+/* Number of times every DIO, DIS and DAO is processed */
+#ifndef RPL_BENCH_NUM_ROUNDS
+#define RPL_BENCH_NUM_ROUNDS 20
+#endif /* RPL_BENCH_NUM_ROUNDS */
+
+/* Number of children per node in the synthetic DODAG */
+#ifndef RPL_BENCH_FANOUT
+#define RPL_BENCH_FANOUT 4
+#endif /* RPL_BENCH_FANOUT */
+
+/* Provisioning */
+#define NBR_TABLE_CONF_MAX_NEIGHBORS (RPL_BENCH_NUM_NEIGHBORS + 2)
+#define NETSTACK_MAX_ROUTE_ENTRIES (RPL_BENCH_NUM_ROUTES + 1)
+/* Enable uip-ds6-route (unused by RPL Lite) to benchmark it as well */
+#define UIP_CONF_MAX_ROUTES RPL_BENCH_NUM_ROUTES
+
+/* Keep logging out of the measurements */
+#ifndef LOG_CONF_LEVEL_RPL
+#define LOG_CONF_LEVEL_RPL LOG_LEVEL_NONE
+#endif /* LOG_CONF_LEVEL_RPL */
+#ifndef LOG_CONF_LEVEL_IPV6
+#define LOG_CONF_LEVEL_IPV6 LOG_LEVEL_NONE
+#endif /* LOG_CONF_LEVEL_IPV6 */
+
+#endif /* PROJECT_CONF_H_ */
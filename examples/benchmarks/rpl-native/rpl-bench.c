@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Benchmark: synthesizes DIO, DIS and DAO workloads on the native
+ *         platform and measures the cost of the RPL Lite control-plane
+ *         hot paths, uip-sr and uip-ds6-route.
+ */
+
+#include "contiki.h"
+#include "net/routing/routing.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/ipv6/uip-sr.h"
+#include "net/link-stats.h"
+#include "net/packetbuf.h"
+#include "net/mac/mac.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*---------------------------------------------------------------------------*/
+PROCESS(rpl_bench_process, "RPL benchmark");
+AUTOSTART_PROCESSES(&rpl_bench_process);
+/*---------------------------------------------------------------------------*/
+static linkaddr_t nbr_lladdr[RPL_BENCH_NUM_NEIGHBORS];
+static uip_ipaddr_t nbr_ipaddr[RPL_BENCH_NUM_NEIGHBORS];
+static uip_ipaddr_t node_ipaddr[RPL_BENCH_NUM_ROUTES];
+static int failed;
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *name, unsigned ops, uint64_t start)
+{
+  uint64_t elapsed = now_ns() - start;
+  printf("%-28s %8u ops %10lu ns/op\n", name, ops,
+         (unsigned long)(ops > 0 ? elapsed / ops : 0));
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(int cond, const char *what)
+{
+  if(!cond) {
+    printf("=check-me= FAILED: %s\n", what);
+    failed = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_addresses(void)
+{
+  int i;
+
+  for(i = 0; i < RPL_BENCH_NUM_NEIGHBORS; i++) {
+    memset(&nbr_lladdr[i], 0, sizeof(linkaddr_t));
+    nbr_lladdr[i].u8[0] = 0x02;
+    nbr_lladdr[i].u8[LINKADDR_SIZE - 2] = (i + 1) >> 8;
+    nbr_lladdr[i].u8[LINKADDR_SIZE - 1] = (i + 1) & 0xff;
+    uip_ip6addr(&nbr_ipaddr[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&nbr_ipaddr[i], (uip_lladdr_t *)&nbr_lladdr[i]);
+  }
+
+  for(i = 0; i < RPL_BENCH_NUM_ROUTES; i++) {
+    uip_ip6addr(&node_ipaddr[i], UIP_DS6_DEFAULT_PREFIX, 0, 0, 0,
+                0x0200, 0, (i + 1) >> 16, (i + 1) & 0xffff);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_dio(rpl_dio_t *dio, int nbr, int round)
+{
+  memset(dio, 0, sizeof(*dio));
+  dio->instance_id = RPL_DEFAULT_INSTANCE;
+  dio->version = RPL_LOLLIPOP_INIT;
+  /* Shuffle the ranks at every round so that the preferred parent changes */
+  dio->rank = ROOT_RANK + RPL_MIN_HOPRANKINC * (1 + (nbr + round) % 4);
+  dio->grounded = 1;
+  dio->mop = RPL_MOP_DEFAULT;
+  dio->dtsn = RPL_LOLLIPOP_INIT;
+  uip_ip6addr(&dio->dag_id, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 1);
+  dio->ocp = RPL_OF_OCP;
+  dio->dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio->dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio->dag_redund = RPL_DIO_REDUNDANCY;
+  dio->default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio->lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  dio->dag_max_rankinc = RPL_MAX_RANKINC;
+  dio->dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  uip_ip6addr(&dio->prefix_info.prefix, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  dio->prefix_info.length = 64;
+  dio->prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+  dio->prefix_info.lifetime = RPL_ROUTE_INFINITE_LIFETIME;
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_dio_dis(void)
+{
+  rpl_dio_t dio;
+  uint64_t start;
+  int round;
+  int i;
+
+  /* Give every neighbor fresh link statistics, as if we had sent it a
+   * few packets already */
+  for(i = 0; i < RPL_BENCH_NUM_NEIGHBORS; i++) {
+    for(round = 0; round < 8; round++) {
+      link_stats_packet_sent(&nbr_lladdr[i], MAC_TX_OK, 1);
+    }
+  }
+
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_NEIGHBORS; i++) {
+      init_dio(&dio, i, round);
+      packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &nbr_lladdr[i]);
+      rpl_process_dio(&nbr_ipaddr[i], &dio);
+    }
+  }
+  report("rpl_process_dio", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_NEIGHBORS, start);
+  check(NETSTACK_ROUTING.node_has_joined(), "joined the DODAG");
+  check(rpl_neighbor_count() == RPL_BENCH_NUM_NEIGHBORS, "all DIO senders are RPL neighbors");
+
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_NEIGHBORS; i++) {
+      rpl_process_dis(&nbr_ipaddr[i], 0);
+    }
+  }
+  report("rpl_process_dis", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_NEIGHBORS, start);
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_ds6_route(void)
+{
+  uint64_t start;
+  int round;
+  int found;
+  int i;
+
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_ROUTES; i++) {
+      uip_ds6_route_add(&node_ipaddr[i], 128, &nbr_ipaddr[i % RPL_BENCH_NUM_NEIGHBORS]);
+    }
+  }
+  report("uip_ds6_route_add", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, start);
+  check(uip_ds6_route_num_routes() == RPL_BENCH_NUM_ROUTES, "all routes added");
+
+  found = 0;
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_ROUTES; i++) {
+      found += uip_ds6_route_lookup(&node_ipaddr[i]) != NULL;
+    }
+  }
+  report("uip_ds6_route_lookup", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, start);
+  check(found == RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, "all routes found");
+
+  while(uip_ds6_route_head() != NULL) {
+    uip_ds6_route_rm(uip_ds6_route_head());
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_dao(void)
+{
+  uip_ipaddr_t root_ipaddr;
+  rpl_dao_t dao;
+  uint64_t start;
+  int round;
+  int found;
+  int parent;
+  int i;
+
+  /* Restart as root of a new DODAG */
+  NETSTACK_ROUTING.leave_network();
+  NETSTACK_ROUTING.root_start();
+  check(NETSTACK_ROUTING.node_is_root(), "started as root");
+  NETSTACK_ROUTING.get_root_ipaddr(&root_ipaddr);
+
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_ROUTES; i++) {
+      /* Node i is a child of node i / fanout - 1, or of the root */
+      parent = i / RPL_BENCH_FANOUT - 1;
+      memset(&dao, 0, sizeof(dao));
+      dao.instance_id = RPL_DEFAULT_INSTANCE;
+      dao.lifetime = RPL_DEFAULT_LIFETIME;
+      dao.sequence = round;
+      uip_ipaddr_copy(&dao.prefix, &node_ipaddr[i]);
+      dao.prefixlen = 128;
+      uip_ipaddr_copy(&dao.parent_addr, parent < 0 ? &root_ipaddr : &node_ipaddr[parent]);
+      rpl_process_dao_target(&node_ipaddr[i], &dao);
+    }
+  }
+  report("rpl_process_dao_target", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, start);
+  check(uip_sr_num_nodes() == RPL_BENCH_NUM_ROUTES + 1, "all nodes in the source routing graph");
+
+  found = 0;
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_ROUTES; i++) {
+      found += uip_sr_get_node(NULL, &node_ipaddr[i]) != NULL;
+    }
+  }
+  report("uip_sr_get_node", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, start);
+  check(found == RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, "all nodes found");
+
+  found = 0;
+  start = now_ns();
+  for(round = 0; round < RPL_BENCH_NUM_ROUNDS; round++) {
+    for(i = 0; i < RPL_BENCH_NUM_ROUTES; i++) {
+      found += uip_sr_is_addr_reachable(NULL, &node_ipaddr[i]);
+    }
+  }
+  report("uip_sr_is_addr_reachable", RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, start);
+  check(found == RPL_BENCH_NUM_ROUNDS * RPL_BENCH_NUM_ROUTES, "all nodes reachable");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_bench_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("RPL benchmark: %u neighbors, %u routes, %u rounds, fan-out %u\n",
+         RPL_BENCH_NUM_NEIGHBORS, RPL_BENCH_NUM_ROUTES,
+         RPL_BENCH_NUM_ROUNDS, RPL_BENCH_FANOUT);
+
+  init_addresses();
+  bench_dio_dis();
+  bench_ds6_route();
+  bench_dao();
+
+  printf("=check-me= %s\n", failed ? "FAILED" : "DONE");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
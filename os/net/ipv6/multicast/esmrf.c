@@ -262,6 +262,7 @@ in()
   rpl_dag_t *d;                 /* Our DODAG */
   uip_ipaddr_t *parent_ipaddr;  /* Our pref. parent's IPv6 address */
   const uip_lladdr_t *parent_lladdr;  /* Our pref. parent's LL address */
+  uip_mcast6_route_t *route;   /* Route to our destination group */
 
   /*
    * Fetch a pointer to the LL address of our preferred parent
@@ -306,13 +307,25 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+  route = uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr);
+  if(route != NULL) {
+    UIP_MCAST6_ROUTE_STATS_ADD(route, in);
+    if(uip_mcast6_route_is_dup(route)) {
+      PRINTF("ESMRF: Duplicate, dropping\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
+    }
+  }
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
    * a higher RPL rank (somewhere down the tree) is a group member */
-  if(uip_mcast6_route_lookup(&UIP_IP_BUF->destipaddr)) {
+  if(route != NULL) {
     /* If we enter here, we will definitely forward */
     UIP_MCAST6_STATS_ADD(mcast_fwd);
+    UIP_MCAST6_ROUTE_STATS_ADD(route, fwd);
 
     /*
      * Add a delay (D) of at least ESMRF_FWD_DELAY() to compensate for how
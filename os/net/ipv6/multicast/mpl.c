@@ -52,6 +52,7 @@
 #include "os/lib/trickle-timer.h"
 #include "os/lib/list.h"
 #include "sys/ctimer.h"
+#include "lib/random.h"
 #include <string.h>
 
 #include "sys/log.h"
@@ -148,15 +149,25 @@ typedef struct seed_id_s {
 /* Buffered message set
  *  This is implemented as a linked list since the majority of operations
  *  involve finding the minimum sequence number and iterating up the list.
+ *  Messages are also indexed by seed and sequence number in a hash table.
+ *  Their trickle timers all run on a shared timer wheel: a running timer
+ *  has a non-zero i_cur, and its next event is at absolute time 'due'.
  */
 struct mpl_msg {
   struct mpl_msg *next; /* Next message in the set, or NULL if this is largest */
+  struct mpl_msg *hnext; /* Next message in the same hash bucket */
+  struct mpl_msg *wnext; /* Next message in the same timer wheel slot */
   struct mpl_seed *seed; /* The seed set this message belongs to */
-  struct trickle_timer tt; /* The trickle timer associated with this msg */
+  clock_time_t i_cur; /* Current trickle interval, 0 if stopped */
+  clock_time_t i_end; /* Absolute end time of the current interval */
+  clock_time_t due; /* Absolute time of the next trickle event */
   uip_ip6addr_t srcipaddr; /* The original ip this message was sent from */
   uint16_t size; /* Side of the data stored above */
   uint8_t seq; /* The sequence number of the message */
   uint8_t e; /* Expiration count for trickle timer */
+  uint8_t c; /* Trickle consistency counter */
+  uint8_t fired; /* Whether t has passed within the current interval */
+  uint8_t wslot; /* The timer wheel slot holding this message */
   uint8_t data[UIP_BUFSIZE]; /* Message payload */
 };
 /**
@@ -208,6 +219,14 @@ struct mpl_seed {
   uint8_t count; /* Only used for determining largest msg set during reclaim */
   LIST_STRUCT(min_seq); /* Pointer to the first msg in this seed's set */
   struct mpl_domain *domain; /* The domain this seed belongs to */
+  struct mpl_seed *hnext; /* Next seed in the same hash bucket */
+  /* Sequence numbers of the buffered messages, one bit per value. This
+   * covers the whole 8-bit sequence space, so it never needs sliding. */
+  uint8_t seq_bitmap[32];
+#if MPL_WITH_NACK
+  uint8_t nack_retries; /* NACKs left to send for the current gap */
+  uint8_t nack_heard; /* A neighbour sent the same NACK, skip a round */
+#endif
 };
 /**
  * \brief Get the state of the used flag in the buffered message set entry
@@ -219,11 +238,30 @@ struct mpl_seed {
  * h: pointer to the message set entry
  */
 #define SEED_SET_CLEAR_USED(h) ((h)->domain = NULL)
+/**
+ * \brief Check whether a message with a given sequence number is buffered
+ * h: pointer to the seed set entry
+ * q: the sequence number
+ */
+#define SEED_SEQ_IS_SET(h, q) (((h)->seq_bitmap[(q) >> 3] & (1 << ((q) & 0x07))) != 0)
+/**
+ * \brief Mark a sequence number as buffered
+ * h: pointer to the seed set entry
+ * q: the sequence number
+ */
+#define SEED_SEQ_SET(h, q) ((h)->seq_bitmap[(q) >> 3] |= (1 << ((q) & 0x07)))
+/**
+ * \brief Mark a sequence number as no longer buffered
+ * h: pointer to the seed set entry
+ * q: the sequence number
+ */
+#define SEED_SEQ_CLR(h, q) ((h)->seq_bitmap[(q) >> 3] &= ~(1 << ((q) & 0x07)))
 /*---------------------------------------------------------------------------*/
 /* Domain Set */
 struct mpl_domain {
   uip_ip6addr_t data_addr; /* Data address for this MPL domain */
   uip_ip6addr_t ctrl_addr; /* Link-local scoped version of data address */
+  struct mpl_domain *hnext; /* Next domain in the same hash bucket */
   struct trickle_timer tt;
   uint8_t e; /* Expiration count for trickle timer */
 };
@@ -405,6 +443,19 @@ static seed_id_t local_seed_id;
 static uip_ip6addr_t all_forwarders;
 #endif
 static struct ctimer lifetime_timer;
+#if MPL_WITH_NACK
+static struct ctimer nack_timer;
+#endif
+/* Hash tables over the sets above */
+static struct mpl_seed *seed_hash[MPL_SEED_HASH_SIZE];
+static struct mpl_domain *domain_hash[MPL_DOMAIN_HASH_SIZE];
+static struct mpl_msg *msg_hash[MPL_MESSAGE_HASH_SIZE];
+/* Timer wheel for data message trickle timers */
+static struct mpl_msg *timer_wheel[MPL_TIMER_WHEEL_SLOTS];
+static struct ctimer timer_wheel_timer;
+static clock_time_t timer_wheel_tick; /* Last tick processed */
+static uint16_t timer_wheel_count; /* Number of messages in the wheel */
+static clock_time_t data_imax; /* Data message Imax, in clock ticks */
 /*---------------------------------------------------------------------------*/
 /* Temporary Stores */
 /*---------------------------------------------------------------------------*/
@@ -432,12 +483,22 @@ extern uint16_t uip_slen;
  * \brief Start the trickle timer for a data message
  * t: Pointer to set that should be reset
  */
-#define mpl_data_trickle_timer_start(t) { (t)->e = 0; trickle_timer_set(&(t)->tt, data_message_expiration, (t)); }
+#define mpl_data_trickle_timer_start(t) { (t)->e = 0; msg_trickle_start(t); }
 /**
  * \brief Call inconsistency on the provided timer
  * t: Pointer to set that should be reset
  */
 #define mpl_trickle_timer_inconsistency(t) { (t)->e = 0; trickle_timer_inconsistency(&(t)->tt); }
+/**
+ * \brief Call inconsistency on the timer of a data message
+ * t: Pointer to message that should be reset
+ */
+#define mpl_data_trickle_timer_inconsistency(t) { (t)->e = 0; msg_trickle_inconsistency(t); }
+/**
+ * \brief Check whether the trickle timer of a data message is running
+ * t: Pointer to the message
+ */
+#define mpl_data_trickle_timer_is_running(t) ((t)->i_cur != TRICKLE_TIMER_IS_STOPPED)
 /**
  * \brief Reset the trickle timer and expiration count for the set
  * t: Pointer to set that should be reset
@@ -465,6 +526,269 @@ extern uint16_t uip_slen;
 /*---------------------------------------------------------------------------*/
 static void icmp_in(void);
 UIP_ICMP6_HANDLER(mpl_icmp_handler, ICMP6_MPL, 0, icmp_in);
+#if MPL_WITH_NACK
+/* ICMP code of our NACK messages, an extension to RFC7731 */
+#define MPL_ICMP_CODE_NACK 1
+static void nack_in(void);
+UIP_ICMP6_HANDLER(mpl_nack_handler, ICMP6_MPL, MPL_ICMP_CODE_NACK, nack_in);
+#endif
+static void data_message_expiration(void *ptr, uint8_t suppress);
+/*---------------------------------------------------------------------------*/
+/* Data Message Timer Wheel */
+/*---------------------------------------------------------------------------*/
+/* Whether absolute time a is not later than b, with clock wraparound */
+#define CLOCK_NOT_AFTER(a, b) ((clock_time_t)((b) - (a)) < (((clock_time_t)~0) >> 1))
+
+static void
+timer_wheel_expiration(void *ptr);
+
+static void
+timer_wheel_schedule(void)
+{
+  clock_time_t tick;
+  clock_time_t now;
+  clock_time_t delay;
+
+  /* Wake up at the end of the next tick whose slot is not empty */
+  for(tick = timer_wheel_tick + 1; tick <= timer_wheel_tick + MPL_TIMER_WHEEL_SLOTS; tick++) {
+    if(timer_wheel[tick % MPL_TIMER_WHEEL_SLOTS] != NULL) {
+      now = clock_time();
+      delay = (tick + 1) * MPL_TIMER_WHEEL_TICK - now;
+      if(delay > (((clock_time_t)~0) >> 1)) {
+        delay = 0; /* In the past */
+      }
+      ctimer_set(&timer_wheel_timer, delay, timer_wheel_expiration, NULL);
+      return;
+    }
+  }
+  ctimer_stop(&timer_wheel_timer);
+}
+static void
+timer_wheel_add(struct mpl_msg *msg)
+{
+  clock_time_t tick;
+
+  if(timer_wheel_count == 0) {
+    /* The wheel was idle, catch up with the clock */
+    timer_wheel_tick = clock_time() / MPL_TIMER_WHEEL_TICK - 1;
+  }
+
+  tick = msg->due / MPL_TIMER_WHEEL_TICK;
+  if(CLOCK_NOT_AFTER(tick, timer_wheel_tick)) {
+    /* That tick was already processed, use the next one */
+    tick = timer_wheel_tick + 1;
+  }
+
+  msg->wslot = tick % MPL_TIMER_WHEEL_SLOTS;
+  msg->wnext = timer_wheel[msg->wslot];
+  timer_wheel[msg->wslot] = msg;
+  timer_wheel_count++;
+
+  timer_wheel_schedule();
+}
+static void
+timer_wheel_remove(struct mpl_msg *msg)
+{
+  struct mpl_msg **mp;
+
+  for(mp = &timer_wheel[msg->wslot]; *mp != NULL; mp = &(*mp)->wnext) {
+    if(*mp == msg) {
+      *mp = msg->wnext;
+      msg->wnext = NULL;
+      timer_wheel_count--;
+      return;
+    }
+  }
+}
+static clock_time_t
+msg_trickle_rand(void)
+{
+  return (clock_time_t)((uint32_t)random_rand() << 16 | random_rand());
+}
+static void
+msg_trickle_new_interval(struct mpl_msg *msg, clock_time_t start)
+{
+  clock_time_t half = msg->i_cur >> 1;
+
+  /* Random t in [I/2, I) */
+  msg->c = 0;
+  msg->fired = 0;
+  msg->i_end = start + msg->i_cur;
+  msg->due = start + half + (half > 0 ? msg_trickle_rand() % half : 0);
+  timer_wheel_add(msg);
+}
+static void
+msg_trickle_stop(struct mpl_msg *msg)
+{
+  if(mpl_data_trickle_timer_is_running(msg)) {
+    timer_wheel_remove(msg);
+    msg->i_cur = TRICKLE_TIMER_IS_STOPPED;
+  }
+}
+static void
+msg_trickle_start(struct mpl_msg *msg)
+{
+  msg_trickle_stop(msg);
+  /* Random I in [Imin, Imax] */
+  msg->i_cur = MPL_DATA_MESSAGE_IMIN +
+    (msg_trickle_rand() % (data_imax - MPL_DATA_MESSAGE_IMIN + 1));
+  msg_trickle_new_interval(msg, clock_time());
+}
+static void
+msg_trickle_inconsistency(struct mpl_msg *msg)
+{
+  if(mpl_data_trickle_timer_is_running(msg) && msg->i_cur != MPL_DATA_MESSAGE_IMIN) {
+    timer_wheel_remove(msg);
+    msg->i_cur = MPL_DATA_MESSAGE_IMIN;
+    msg_trickle_new_interval(msg, clock_time());
+  }
+}
+static void
+msg_trickle_consistency(struct mpl_msg *msg)
+{
+  if(mpl_data_trickle_timer_is_running(msg) && msg->c < 0xFF) {
+    msg->c++;
+  }
+}
+static void
+msg_trickle_event(struct mpl_msg *msg)
+{
+  if(!msg->fired) {
+    /* We reached t: transmit unless suppressed, then wait for the end */
+    msg->fired = 1;
+    data_message_expiration(msg,
+                            MPL_DATA_MESSAGE_K == TRICKLE_TIMER_INFINITE_REDUNDANCY ||
+                            msg->c < MPL_DATA_MESSAGE_K ?
+                            TRICKLE_TIMER_TX_OK : TRICKLE_TIMER_TX_SUPPRESS);
+    if(mpl_data_trickle_timer_is_running(msg)) {
+      msg->due = msg->i_end;
+      timer_wheel_add(msg);
+    }
+  } else {
+    /* End of the interval: double it, up to Imax */
+    msg->i_cur = msg->i_cur <= data_imax >> 1 ? msg->i_cur << 1 : data_imax;
+    msg_trickle_new_interval(msg, msg->i_end);
+  }
+}
+static void
+timer_wheel_expiration(void *ptr)
+{
+  struct mpl_msg **mp;
+  struct mpl_msg *msg;
+  clock_time_t now;
+  clock_time_t first;
+  clock_time_t last;
+  clock_time_t tick;
+
+  /* Process all complete ticks since last time, visiting each slot once */
+  now = clock_time();
+  first = timer_wheel_tick + 1;
+  last = now / MPL_TIMER_WHEEL_TICK - 1;
+  if(!CLOCK_NOT_AFTER(first, last)) {
+    /* Woken up early, nothing to process yet */
+    timer_wheel_schedule();
+    return;
+  }
+  if((clock_time_t)(last - first) >= MPL_TIMER_WHEEL_SLOTS) {
+    first = last - MPL_TIMER_WHEEL_SLOTS + 1;
+  }
+  /* Messages re-added from here on go to later ticks */
+  timer_wheel_tick = last;
+
+  for(tick = first; CLOCK_NOT_AFTER(tick, last); tick++) {
+    mp = &timer_wheel[tick % MPL_TIMER_WHEEL_SLOTS];
+    while(*mp != NULL) {
+      msg = *mp;
+      if(CLOCK_NOT_AFTER(msg->due, now)) {
+        *mp = msg->wnext;
+        msg->wnext = NULL;
+        timer_wheel_count--;
+        msg_trickle_event(msg);
+      } else {
+        mp = &msg->wnext;
+      }
+    }
+  }
+
+  timer_wheel_schedule();
+}
+/*---------------------------------------------------------------------------*/
+/* Hash Tables */
+/*---------------------------------------------------------------------------*/
+static uint8_t
+seed_hash_index(const seed_id_t *seed_id, const struct mpl_domain *domain)
+{
+  uint16_t h;
+  uint8_t i;
+
+  h = domain - domain_set;
+  for(i = 0; i < 16; i++) {
+    h = h * 31 + seed_id->id[i];
+  }
+  return h % MPL_SEED_HASH_SIZE;
+}
+static uint8_t
+domain_hash_index(const uip_ip6addr_t *addr)
+{
+  uint16_t h;
+  uint8_t i;
+
+  /* The data and control addresses of a domain differ only by their scope,
+   * skip it so that both hash to the same bucket */
+  h = addr->u8[0];
+  for(i = 2; i < 16; i++) {
+    h = h * 31 + addr->u8[i];
+  }
+  return h % MPL_DOMAIN_HASH_SIZE;
+}
+static void
+domain_hash_remove(struct mpl_domain *domain)
+{
+  struct mpl_domain **dp;
+
+  for(dp = &domain_hash[domain_hash_index(&domain->data_addr)]; *dp != NULL; dp = &(*dp)->hnext) {
+    if(*dp == domain) {
+      *dp = domain->hnext;
+      return;
+    }
+  }
+}
+#define MSG_HASH_INDEX(seed, seq) ((((seed) - seed_set) * 31 + (seq)) % MPL_MESSAGE_HASH_SIZE)
+static struct mpl_msg *
+msg_lookup(struct mpl_seed *seed, uint8_t seq)
+{
+  struct mpl_msg *msg;
+
+  for(msg = msg_hash[MSG_HASH_INDEX(seed, seq)]; msg != NULL; msg = msg->hnext) {
+    if(msg->seed == seed && msg->seq == seq) {
+      return msg;
+    }
+  }
+  return NULL;
+}
+static void
+msg_index_add(struct mpl_msg *msg)
+{
+  uint8_t h = MSG_HASH_INDEX(msg->seed, msg->seq);
+
+  msg->hnext = msg_hash[h];
+  msg_hash[h] = msg;
+  SEED_SEQ_SET(msg->seed, msg->seq);
+}
+static void
+msg_index_remove(struct mpl_msg *msg)
+{
+  struct mpl_msg **mp;
+
+  for(mp = &msg_hash[MSG_HASH_INDEX(msg->seed, msg->seq)]; *mp != NULL; mp = &(*mp)->hnext) {
+    if(*mp == msg) {
+      *mp = msg->hnext;
+      SEED_SEQ_CLR(msg->seed, msg->seq);
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 
 static struct mpl_msg *
 buffer_allocate(void)
@@ -480,9 +804,8 @@ buffer_allocate(void)
 static void
 buffer_free(struct mpl_msg *msg)
 {
-  if(trickle_timer_is_running(&msg->tt)) {
-    trickle_timer_stop(&msg->tt);
-  }
+  msg_trickle_stop(msg);
+  msg_index_remove(msg);
   MSG_SET_CLEAR_USED(msg);
 }
 static struct mpl_msg *
@@ -495,7 +818,7 @@ buffer_reclaim(void)
   /* Reclaim the message with min_seq in the largest seed set */
   largest = NULL;
   reclaim = NULL;
-  for(ssptr = &seed_set[MPL_SEED_SET_SIZE]; ssptr >= seed_set; ssptr--) {
+  for(ssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; ssptr >= seed_set; ssptr--) {
     if(SEED_SET_IS_USED(ssptr) && (largest == NULL || ssptr->count > largest->count)) {
       largest = ssptr;
     }
@@ -512,7 +835,8 @@ buffer_reclaim(void)
     reclaim = list_pop(largest->min_seq);
     largest->min_seqno = list_item_next(reclaim) == NULL ? reclaim->seq : ((struct mpl_msg *)list_item_next(reclaim))->seq;
     largest->count--;
-    trickle_timer_stop(&reclaim->tt);
+    msg_trickle_stop(reclaim);
+    msg_index_remove(reclaim);
     mpl_trickle_timer_reset(reclaim->seed->domain);
     memset(reclaim, 0, sizeof(struct mpl_msg));
   }
@@ -564,6 +888,8 @@ domain_set_allocate(uip_ip6addr_t *address)
         DOMAIN_SET_CLEAR_USED(locdsptr);
         return NULL;
       }
+      locdsptr->hnext = domain_hash[domain_hash_index(&locdsptr->data_addr)];
+      domain_hash[domain_hash_index(&locdsptr->data_addr)] = locdsptr;
       return locdsptr;
     }
   }
@@ -573,20 +899,27 @@ domain_set_allocate(uip_ip6addr_t *address)
 static struct mpl_seed *
 seed_set_lookup(seed_id_t *seed_id, struct mpl_domain *domain)
 {
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
-    if(SEED_SET_IS_USED(locssptr) && seed_id_cmp(seed_id, &locssptr->seed_id) && locssptr->domain == domain) {
+  for(locssptr = seed_hash[seed_hash_index(seed_id, domain)]; locssptr != NULL; locssptr = locssptr->hnext) {
+    if(seed_id_cmp(seed_id, &locssptr->seed_id) && locssptr->domain == domain) {
       return locssptr;
     }
   }
   return NULL;
 }
 static struct mpl_seed *
-seed_set_allocate(void)
+seed_set_allocate(seed_id_t *seed_id, struct mpl_domain *domain)
 {
+  uint8_t h;
+
   for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
     if(!SEED_SET_IS_USED(locssptr)) {
-      locssptr->count = 0;
+      memset(locssptr, 0, sizeof(struct mpl_seed));
       LIST_STRUCT_INIT(locssptr, min_seq);
+      seed_id_cpy(&locssptr->seed_id, seed_id);
+      locssptr->domain = domain;
+      h = seed_hash_index(seed_id, domain);
+      locssptr->hnext = seed_hash[h];
+      seed_hash[h] = locssptr;
       return locssptr;
     }
   }
@@ -595,20 +928,26 @@ seed_set_allocate(void)
 static void
 seed_set_free(struct mpl_seed *s)
 {
+  struct mpl_seed **sp;
+
   while((locmmptr = list_pop(s->min_seq)) != NULL) {
     buffer_free(locmmptr);
   }
+  for(sp = &seed_hash[seed_hash_index(&s->seed_id, s->domain)]; *sp != NULL; sp = &(*sp)->hnext) {
+    if(*sp == s) {
+      *sp = s->hnext;
+      break;
+    }
+  }
   SEED_SET_CLEAR_USED(s);
 }
 static struct mpl_domain *
 domain_set_lookup(uip_ip6addr_t *domain)
 {
-  for(locdsptr = &domain_set[MPL_DOMAIN_SET_SIZE - 1]; locdsptr >= domain_set; locdsptr--) {
-    if(DOMAIN_SET_IS_USED(locdsptr)) {
-      if(uip_ip6addr_cmp(domain, &locdsptr->data_addr)
-         || uip_ip6addr_cmp(domain, &locdsptr->ctrl_addr)) {
-        return locdsptr;
-      }
+  for(locdsptr = domain_hash[domain_hash_index(domain)]; locdsptr != NULL; locdsptr = locdsptr->hnext) {
+    if(uip_ip6addr_cmp(domain, &locdsptr->data_addr)
+       || uip_ip6addr_cmp(domain, &locdsptr->ctrl_addr)) {
+      return locdsptr;
     }
   }
   return NULL;
@@ -618,7 +957,7 @@ domain_set_free(struct mpl_domain *domain)
 {
   uip_ds6_maddr_t *addr;
   /* Must include freeing seeds otherwise we leak memory */
-  for(locssptr = &seed_set[MPL_SEED_SET_SIZE]; locssptr >= seed_set; locssptr--) {
+  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
     if(SEED_SET_IS_USED(locssptr) && locssptr->domain == domain) {
       seed_set_free(locssptr);
     }
@@ -634,6 +973,7 @@ domain_set_free(struct mpl_domain *domain)
   if(trickle_timer_is_running(&domain->tt)) {
     trickle_timer_stop(&domain->tt);
   }
+  domain_hash_remove(domain);
   DOMAIN_SET_CLEAR_USED(domain);
 }
 static void
@@ -908,7 +1248,7 @@ data_message_expiration(void *ptr, uint8_t suppress)
   locmmptr = ((struct mpl_msg *)ptr);
   if(locmmptr->e > MPL_DATA_MESSAGE_TIMER_EXPIRATIONS) {
     /* Terminate the trickle timer here if we've already expired enough times */
-    trickle_timer_stop(&locmmptr->tt);
+    msg_trickle_stop(locmmptr);
     return;
   }
   if(suppress == TRICKLE_TIMER_TX_OK) { /* Only transmit if not suppressed */
@@ -1038,7 +1378,7 @@ lifetime_timer_expiration(void *ptr)
       /* Check no timers are running */
       locmmptr = list_head(locssptr->min_seq);
       while(locmmptr != NULL) {
-        if(trickle_timer_is_running(&locmmptr->tt)) {
+        if(mpl_data_trickle_timer_is_running(locmmptr)) {
           /* We must keep this seed */
           break;
         }
@@ -1115,7 +1455,7 @@ icmp_in(void)
     locdsptr = domain_set_allocate(&UIP_IP_BUF->destipaddr);
     if(!locdsptr) {
       LOG_ERR("Couldn't allocate new domain. Dropping.\n");
-      UIP_MCAST6_STATS_ADD(icmp_bad);
+      MPL_STATS_ADD(icmp_bad);
       goto discard;
     }
     mpl_control_trickle_timer_start(locdsptr);
@@ -1171,11 +1511,11 @@ icmp_in(void)
       if(list_head(locssptr->min_seq) != NULL) {
         for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
           LOG_DBG("Resetting timer for messages\n");
-          if(!trickle_timer_is_running(&locmmptr->tt)) {
+          if(!mpl_data_trickle_timer_is_running(locmmptr)) {
             LOG_DBG("Starting timer for messages\n");
             mpl_data_trickle_timer_start(locmmptr);
           }
-          mpl_trickle_timer_inconsistency(locmmptr);
+          mpl_data_trickle_timer_inconsistency(locmmptr);
         }
       }
       /* Otherwise we jump here and continute */
@@ -1271,10 +1611,10 @@ seed_present:
           /* Additionally all data message timers in set if r is behind us */
           if(list_head(locssptr->min_seq) != NULL) {
             for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-              if(!trickle_timer_is_running(&locmmptr->tt)) {
+              if(!mpl_data_trickle_timer_is_running(locmmptr)) {
                 mpl_data_trickle_timer_start(locmmptr);
               }
-              mpl_trickle_timer_inconsistency(locmmptr);
+              mpl_data_trickle_timer_inconsistency(locmmptr);
             }
           }
         } else {
@@ -1310,10 +1650,10 @@ seed_present:
         /* Local message is missing from remote set. Reset control and data timers */
         LOG_DBG("Remote is missing seq=%u\n", locmmptr->seq);
         r_missing = 1;
-        if(!trickle_timer_is_running(&locmmptr->tt)) {
+        if(!mpl_data_trickle_timer_is_running(locmmptr)) {
           mpl_data_trickle_timer_start(locmmptr);
         }
-        mpl_trickle_timer_inconsistency(locmmptr);
+        mpl_data_trickle_timer_inconsistency(locmmptr);
       }
 
       /* Now increment our pointers */
@@ -1342,10 +1682,10 @@ seed_present:
        */
       while(locmmptr != NULL) {
         LOG_DBG("Remote is missing all above seq=%u\n", locmmptr->seq);
-        if(!trickle_timer_is_running(&locmmptr->tt)) {
+        if(!mpl_data_trickle_timer_is_running(locmmptr)) {
           mpl_data_trickle_timer_start(locmmptr);
         }
-        mpl_trickle_timer_inconsistency(locmmptr);
+        mpl_data_trickle_timer_inconsistency(locmmptr);
         r_missing = 1;
         locmmptr = list_item_next(locmmptr);
       }
@@ -1387,11 +1727,283 @@ discard:
   uipbuf_clear();
   return;
 }
+#if MPL_WITH_NACK
+/*---------------------------------------------------------------------------*/
+/* NACK Repair */
+/*---------------------------------------------------------------------------*/
+static void nack_expiration(void *ptr);
+
+static void
+nack_timer_set(clock_time_t base)
+{
+  ctimer_set(&nack_timer, base + MPL_NACK_DELAY / 2 + random_rand() % (MPL_NACK_DELAY / 2 + 1),
+             nack_expiration, NULL);
+}
+/*
+ * Build the bit vector of the messages missing from a seed set: bit r is set
+ * if min_seqno + 1 + r is missing, up to the highest buffered message. Sets
+ * *first to min_seqno + 1 and returns the vector length in bytes, or 0 if
+ * there is no gap.
+ */
+static uint8_t
+nack_vector(struct mpl_seed *s, uint8_t *vector, uint8_t *first)
+{
+  struct mpl_msg *msg;
+  uint8_t max_seq;
+  uint8_t seq;
+  uint8_t r;
+  uint8_t missing;
+
+  msg = list_head(s->min_seq);
+  if(msg == NULL) {
+    return 0;
+  }
+  while(list_item_next(msg) != NULL) {
+    msg = list_item_next(msg);
+  }
+  max_seq = msg->seq;
+
+  memset(vector, 0, 32);
+  missing = 0;
+  r = 0;
+  *first = SEQ_VAL_ADD(s->min_seqno, 1);
+  for(seq = *first; seq != max_seq && seq != s->min_seqno; seq = SEQ_VAL_ADD(seq, 1)) {
+    if(!SEED_SEQ_IS_SET(s, seq)) {
+      BIT_VECTOR_SET_BIT(vector, r);
+      missing = r + 1;
+    }
+    r++;
+  }
+  return missing == 0 ? 0 : (missing - 1) / 8 + 1;
+}
+static void
+nack_schedule(struct mpl_seed *s)
+{
+  s->nack_retries = MPL_NACK_RETRIES;
+  s->nack_heard = 0;
+  if(ctimer_expired(&nack_timer)) {
+    nack_timer_set(0);
+  }
+}
+static void
+nack_out(struct mpl_domain *dom)
+{
+  uint8_t vector[32];
+  uint8_t vec_size;
+  uint8_t first;
+  uint16_t payload_len;
+  size_t seed_info_len;
+
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = MPL_IP_HOP_LIMIT;
+
+  /* Link-local only: the NACK is for our neighbours */
+  uip_ip6addr_copy(&UIP_IP_BUF->destipaddr, &dom->ctrl_addr);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    LOG_ERR("NACK out: Cannot set src ip\n");
+    uipbuf_clear();
+    return;
+  }
+
+  locsiptr = (struct seed_info *)UIP_ICMP_PAYLOAD;
+  payload_len = 0;
+
+  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
+    if(!SEED_SET_IS_USED(locssptr) || locssptr->domain != dom
+       || locssptr->nack_retries == 0) {
+      continue;
+    }
+    if(locssptr->nack_heard) {
+      /* A neighbour asked for the same messages, wait for the repair */
+      locssptr->nack_heard = 0;
+      continue;
+    }
+    vec_size = nack_vector(locssptr, vector, &first);
+    if(vec_size == 0) {
+      /* Gap filled */
+      locssptr->nack_retries = 0;
+      continue;
+    }
+    locssptr->nack_retries--;
+
+    LOG_INFO("NACK for seed ");
+    LOG_INFO_SEED(locssptr->seed_id);
+    LOG_INFO_(" from seq=%u, %u bytes\n", first, vec_size);
+
+    /* The source is not the seed, so S=0 is never used */
+    locsiptr->min_seqno = first;
+    SEED_INFO_CLR_LEN(locsiptr);
+    SEED_INFO_CLR_S(locsiptr);
+    switch(locssptr->seed_id.s) {
+    case 1:
+      seed_id_host_to_net(&((struct seed_info_s1 *)locsiptr)->seed_id, &locssptr->seed_id);
+      SEED_INFO_SET_S(locsiptr, 1);
+      seed_info_len = sizeof(struct seed_info_s1);
+      break;
+    case 2:
+      seed_id_host_to_net(&((struct seed_info_s2 *)locsiptr)->seed_id, &locssptr->seed_id);
+      SEED_INFO_SET_S(locsiptr, 2);
+      seed_info_len = sizeof(struct seed_info_s2);
+      break;
+    default:
+      seed_id_host_to_net(&((struct seed_info_s3 *)locsiptr)->seed_id, &locssptr->seed_id);
+      SEED_INFO_SET_S(locsiptr, 3);
+      seed_info_len = sizeof(struct seed_info_s3);
+      break;
+    }
+    SEED_INFO_SET_LEN(locsiptr, vec_size);
+    memcpy(((void *)locsiptr) + seed_info_len, vector, vec_size);
+    locsiptr = ((void *)locsiptr) + seed_info_len + vec_size;
+    payload_len += seed_info_len + vec_size;
+  }
+
+  if(payload_len == 0) {
+    uipbuf_clear();
+    return;
+  }
+
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + payload_len);
+  UIP_ICMP_BUF->type = ICMP6_MPL;
+  UIP_ICMP_BUF->icode = MPL_ICMP_CODE_NACK;
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + payload_len;
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  LOG_DBG("MPL NACK Out - %u bytes\n", payload_len);
+
+  tcpip_ipv6_output();
+  uipbuf_clear();
+  MPL_STATS_ADD(icmp_out);
+}
+static void
+nack_expiration(void *ptr)
+{
+  for(locdsptr = &domain_set[MPL_DOMAIN_SET_SIZE - 1]; locdsptr >= domain_set; locdsptr--) {
+    if(DOMAIN_SET_IS_USED(locdsptr)) {
+      nack_out(locdsptr);
+    }
+  }
+
+  /* Retry for the gaps that are still open, after the repair had its chance */
+  for(locssptr = &seed_set[MPL_SEED_SET_SIZE - 1]; locssptr >= seed_set; locssptr--) {
+    if(SEED_SET_IS_USED(locssptr) && locssptr->nack_retries > 0) {
+      nack_timer_set(2 * MPL_DATA_MESSAGE_IMIN);
+      return;
+    }
+  }
+}
+static void
+nack_in(void)
+{
+  static seed_id_t seed_id;
+  static uint8_t *vector;
+  static uint16_t vector_len;
+  static uint8_t first;
+  static uint16_t r;
+  static uint8_t covered;
+  static uint8_t our_vector[32];
+  static uint8_t our_first;
+  static uint8_t our_size;
+  size_t seed_info_len;
+
+  LOG_INFO("MPL NACK from ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
+  LOG_INFO_("\n");
+
+#if UIP_CONF_IPV6_CHECKS
+  if(!uip_is_addr_mcast_non_routable(&UIP_IP_BUF->destipaddr)
+     || UIP_IP_BUF->ttl != MPL_IP_HOP_LIMIT) {
+    LOG_ERR("NACK In, bad dest or TTL\n");
+    MPL_STATS_ADD(icmp_bad);
+    goto discard;
+  }
+#endif
+
+  MPL_STATS_ADD(icmp_in);
+
+  locdsptr = domain_set_lookup(&UIP_IP_BUF->destipaddr);
+  if(!locdsptr) {
+    /* Not a domain of ours, we can't hold the messages */
+    goto discard;
+  }
+
+  locsiptr = (struct seed_info *)UIP_ICMP_PAYLOAD;
+  while(locsiptr <
+        (struct seed_info *)((void *)UIP_ICMP_PAYLOAD + uip_len - uip_l3_icmp_hdr_len)) {
+    switch(SEED_INFO_GET_S(locsiptr)) {
+    case 1:
+      seed_info_len = sizeof(struct seed_info_s1);
+      break;
+    case 2:
+      seed_info_len = sizeof(struct seed_info_s2);
+      break;
+    case 3:
+      seed_info_len = sizeof(struct seed_info_s3);
+      break;
+    default:
+      LOG_ERR("NACK In, bad S\n");
+      MPL_STATS_ADD(icmp_bad);
+      goto discard;
+    }
+    seed_id_net_to_host(&seed_id, &((struct seed_info_s1 *)locsiptr)->seed_id, SEED_INFO_GET_S(locsiptr));
+    first = locsiptr->min_seqno;
+    vector = ((uint8_t *)locsiptr) + seed_info_len;
+    vector_len = SEED_INFO_GET_LEN(locsiptr) * 8;
+    locsiptr = ((void *)locsiptr) + seed_info_len + SEED_INFO_GET_LEN(locsiptr);
+
+    locssptr = seed_set_lookup(&seed_id, locdsptr);
+    if(!locssptr) {
+      continue;
+    }
+
+    /* Repair what we hold: bring those messages back to Imin */
+    covered = 1;
+    for(r = 0; r < vector_len; r++) {
+      if(BIT_VECTOR_GET_BIT(vector, r)
+         && SEED_SEQ_IS_SET(locssptr, SEQ_VAL_ADD(first, r))) {
+        locmmptr = msg_lookup(locssptr, SEQ_VAL_ADD(first, r));
+        if(locmmptr != NULL) {
+          LOG_DBG("Repairing seq=%u\n", locmmptr->seq);
+          if(!mpl_data_trickle_timer_is_running(locmmptr)) {
+            mpl_data_trickle_timer_start(locmmptr);
+          }
+          mpl_data_trickle_timer_inconsistency(locmmptr);
+        }
+      }
+    }
+
+    /* If we are waiting to NACK the same messages, this one does for us */
+    if(locssptr->nack_retries > 0) {
+      our_size = nack_vector(locssptr, our_vector, &our_first);
+      for(r = 0; r < our_size * 8 && covered; r++) {
+        if(BIT_VECTOR_GET_BIT(our_vector, r)) {
+          covered = (uint8_t)(SEQ_VAL_ADD(our_first, r) - first) < vector_len
+            && BIT_VECTOR_GET_BIT(vector, (uint8_t)(SEQ_VAL_ADD(our_first, r) - first));
+        }
+      }
+      if(covered) {
+        LOG_DBG("NACK suppressed\n");
+        locssptr->nack_heard = 1;
+      }
+    }
+  }
+
+discard:
+  uip_len = 0;
+  uipbuf_clear();
+}
+#endif /* MPL_WITH_NACK */
 static uint8_t
 accept(uint8_t in)
 {
   static seed_id_t seed_id;
   static uint16_t seq_val;
+  static uint16_t i;
   static uint8_t S;
   static struct mpl_msg *mmiterptr;
   static struct uip_ext_hdr *hptr;
@@ -1509,19 +2121,18 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    if(list_head(locssptr->min_seq) != NULL) {
-      for(locmmptr = list_head(locssptr->min_seq); locmmptr != NULL; locmmptr = list_item_next(locmmptr)) {
-        if(SEQ_VAL_IS_EQ(seq_val, locmmptr->seq)) {
-          /* Seen before , drop */
-          LOG_INFO("Seen before\n");
-          if(HBH_GET_M(lochbhmptr) && list_item_next(locmmptr) != NULL) {
-            mpl_trickle_timer_inconsistency(locmmptr);
-          } else {
-            trickle_timer_consistency(&locmmptr->tt);
-          }
-          UIP_MCAST6_STATS_ADD(mcast_dropped);
-          return UIP_MCAST6_DROP;
+    if(SEED_SEQ_IS_SET(locssptr, seq_val)) {
+      locmmptr = msg_lookup(locssptr, seq_val);
+      if(locmmptr != NULL) {
+        /* Seen before , drop */
+        LOG_INFO("Seen before\n");
+        if(HBH_GET_M(lochbhmptr) && list_item_next(locmmptr) != NULL) {
+          mpl_data_trickle_timer_inconsistency(locmmptr);
+        } else {
+          msg_trickle_consistency(locmmptr);
         }
+        UIP_MCAST6_STATS_ADD(mcast_dropped);
+        return UIP_MCAST6_DROP;
       }
     }
   }
@@ -1529,7 +2140,7 @@ accept(uint8_t in)
 
   /* Allocate a seed set if we have to */
   if(!locssptr) {
-    locssptr = seed_set_allocate();
+    locssptr = seed_set_allocate(&seed_id, locdsptr);
     LOG_INFO("New seed\n");
     if(!locssptr) {
       /* Couldn't allocate seed set, drop */
@@ -1537,10 +2148,6 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    memset(locssptr, 0, sizeof(struct mpl_seed));
-    LIST_STRUCT_INIT(locssptr, min_seq);
-    seed_id_cpy(&locssptr->seed_id, &seed_id);
-    locssptr->domain = locdsptr;
   }
 
   /* Allocate a buffer */
@@ -1579,30 +2186,39 @@ accept(uint8_t in)
   memcpy(&locmmptr->data, hptr, locmmptr->size);
   locmmptr->seq = seq_val;
   locmmptr->seed = locssptr;
-  if(!trickle_timer_config(&locmmptr->tt,
-                           MPL_DATA_MESSAGE_IMIN,
-                           MPL_DATA_MESSAGE_IMAX,
-                           MPL_DATA_MESSAGE_K)) {
-    LOG_ERR("Failed to configure timer for message. Dropping...\n");
-    buffer_free(locmmptr);
-    return UIP_MCAST6_DROP;
-  }
 
   /* Place the message into the buffered message linked list */
-  if(list_head(locssptr->min_seq) == NULL) {
+  if(list_head(locssptr->min_seq) == NULL || SEQ_VAL_IS_LT(locmmptr->seq, locssptr->min_seqno)) {
     list_push(locssptr->min_seq, locmmptr);
     locssptr->min_seqno = locmmptr->seq;
   } else {
-    for(mmiterptr = list_head(locssptr->min_seq); mmiterptr != NULL; mmiterptr = list_item_next(mmiterptr)) {
-      if(list_item_next(mmiterptr) == NULL
-         || (SEQ_VAL_IS_GT(locmmptr->seq, mmiterptr->seq) && SEQ_VAL_IS_LT(locmmptr->seq, ((struct mpl_msg *)list_item_next(mmiterptr))->seq))) {
-        list_insert(locssptr->min_seq, mmiterptr, locmmptr);
+    /* Find the closest buffered predecessor from the sequence bitmap */
+    mmiterptr = NULL;
+    for(i = 1; i <= (uint8_t)(seq_val - locssptr->min_seqno); i++) {
+      if(SEED_SEQ_IS_SET(locssptr, (uint8_t)(seq_val - i))) {
+        mmiterptr = msg_lookup(locssptr, seq_val - i);
         break;
       }
     }
+    if(mmiterptr == NULL) {
+      list_push(locssptr->min_seq, locmmptr);
+    } else {
+      /* Link in place, the message is known not to be in the list yet */
+      locmmptr->next = mmiterptr->next;
+      mmiterptr->next = locmmptr;
+    }
   }
+  msg_index_add(locmmptr);
   locssptr->count++;
 
+#if MPL_WITH_NACK
+  /* A message ahead of its predecessor reveals a gap, ask for a repair */
+  if(in == MPL_DGRAM_IN && locmmptr->seq != locssptr->min_seqno
+     && !SEED_SEQ_IS_SET(locssptr, SEQ_VAL_ADD(locmmptr->seq, 0xFF))) {
+    nack_schedule(locssptr);
+  }
+#endif
+
 #if MPL_PROACTIVE_FORWARDING
   /* Start Forwarding the message */
   mpl_data_trickle_timer_start(locmmptr);
@@ -1632,10 +2248,10 @@ accept(uint8_t in)
 #if MPL_PROACTIVE_FORWARDING
   if(HBH_GET_M(lochbhmptr) == 1 && list_item_next(locmmptr) != NULL) {
     LOG_DBG("MPL Domain is inconsistent\n");
-    mpl_trickle_timer_inconsistency(locmmptr);
+    mpl_data_trickle_timer_inconsistency(locmmptr);
   } else {
     LOG_DBG("MPL Domain is consistent\n");
-    trickle_timer_consistency(&locmmptr->tt);
+    msg_trickle_consistency(locmmptr);
   }
 #endif
 
@@ -1766,15 +2382,32 @@ in(void)
 static void
 init(void)
 {
+  uint8_t i;
+
   LOG_INFO("Multicast Protocol for Low Power and Lossy Networks - RFC7731\n");
 
   /* Clear out all sets */
   memset(domain_set, 0, sizeof(struct mpl_domain) * MPL_DOMAIN_SET_SIZE);
   memset(seed_set, 0, sizeof(struct mpl_seed) * MPL_SEED_SET_SIZE);
   memset(buffered_message_set, 0, sizeof(struct mpl_msg) * MPL_BUFFERED_MESSAGE_SET_SIZE);
+  memset(seed_hash, 0, sizeof(seed_hash));
+  memset(domain_hash, 0, sizeof(domain_hash));
+  memset(msg_hash, 0, sizeof(msg_hash));
+  memset(timer_wheel, 0, sizeof(timer_wheel));
+  timer_wheel_count = 0;
+
+  /* Data message Imax, bounded so that intervals fit in clock_time_t */
+  data_imax = MPL_DATA_MESSAGE_IMIN;
+  for(i = 0; i < MPL_DATA_MESSAGE_IMAX && data_imax <= (((clock_time_t)~0) >> 2); i++) {
+    data_imax <<= 1;
+  }
 
   /* Register the ICMPv6 input handler */
   uip_icmp6_register_input_handler(&mpl_icmp_handler);
+#if MPL_WITH_NACK
+  uip_icmp6_register_input_handler(&mpl_nack_handler);
+  ctimer_stop(&nack_timer);
+#endif
 
   update_seed_id();
 
@@ -90,7 +90,7 @@
 #ifndef MPL_CONF_DATA_MESSAGE_K
 #define MPL_DATA_MESSAGE_K                  1
 #else
-#define MPL_CONF_DATA_MESSAGE_K MPL_DATA_MESSAGE_K
+#define MPL_DATA_MESSAGE_K MPL_CONF_DATA_MESSAGE_K
 #endif
 
 #ifndef MPL_CONF_CONTROL_MESSAGE_IMIN
@@ -269,6 +269,86 @@
 #define MPL_CONTROL_MESSAGE_TIMER_EXPIRATIONS MPL_CONF_CONTROL_MESSAGE_TIMER_EXPIRATIONS
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * Hash Table Sizes
+ * Seeds, domains and buffered messages are indexed by hash tables so that
+ * incoming messages are matched without scanning the sets. The number of
+ * buckets of each table is set below.
+ */
+#ifndef MPL_CONF_SEED_HASH_SIZE
+#define MPL_SEED_HASH_SIZE                  8
+#else
+#define MPL_SEED_HASH_SIZE MPL_CONF_SEED_HASH_SIZE
+#endif
+
+#ifndef MPL_CONF_DOMAIN_HASH_SIZE
+#define MPL_DOMAIN_HASH_SIZE                4
+#else
+#define MPL_DOMAIN_HASH_SIZE MPL_CONF_DOMAIN_HASH_SIZE
+#endif
+
+#ifndef MPL_CONF_MESSAGE_HASH_SIZE
+#define MPL_MESSAGE_HASH_SIZE               8
+#else
+#define MPL_MESSAGE_HASH_SIZE MPL_CONF_MESSAGE_HASH_SIZE
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * Timer Wheel
+ * The trickle timers of all buffered data messages are driven by a single
+ * timer wheel instead of one timer each. The wheel has the number of slots
+ * below, each covering a tick of the length below (in clock ticks). Trickle
+ * transmissions are rounded up to the next wheel tick.
+ */
+#ifndef MPL_CONF_TIMER_WHEEL_SLOTS
+#define MPL_TIMER_WHEEL_SLOTS               16
+#else
+#define MPL_TIMER_WHEEL_SLOTS MPL_CONF_TIMER_WHEEL_SLOTS
+#endif
+
+#ifndef MPL_CONF_TIMER_WHEEL_TICK
+#define MPL_TIMER_WHEEL_TICK                ((MPL_DATA_MESSAGE_IMIN / 4) > 0 ? (MPL_DATA_MESSAGE_IMIN / 4) : 1)
+#else
+#define MPL_TIMER_WHEEL_TICK MPL_CONF_TIMER_WHEEL_TICK
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * NACK Repair
+ * When enabled, a node that receives a data message with a sequence number
+ * ahead of the next expected one multicasts a NACK to its link neighbours,
+ * listing the messages it is missing. Neighbours that buffer one of those
+ * messages reset its trickle timer, so that the gap is repaired at Imin by
+ * the closest holders instead of waiting for the control message exchange.
+ * A NACK overheard from a neighbour with the same gap suppresses ours.
+ * This is an extension to RFC7731: all nodes of a domain should agree on it.
+ */
+#ifndef MPL_CONF_WITH_NACK
+#define MPL_WITH_NACK                       0
+#else
+#define MPL_WITH_NACK MPL_CONF_WITH_NACK
+#endif
+
+/**
+ * Maximum random delay before sending a NACK, in clock ticks. This leaves
+ * time for a reordered message to arrive, and spreads the NACKs of
+ * neighbours that share a gap so that one of them suppresses the others.
+ */
+#ifndef MPL_CONF_NACK_DELAY
+#define MPL_NACK_DELAY                      (CLOCK_SECOND / 4)
+#else
+#define MPL_NACK_DELAY MPL_CONF_NACK_DELAY
+#endif
+
+/**
+ * Number of NACKs sent for a gap before giving up and leaving the repair
+ * to the control messages. NACKs are repeated every two data message Imin.
+ */
+#ifndef MPL_CONF_NACK_RETRIES
+#define MPL_NACK_RETRIES                    3
+#else
+#define MPL_NACK_RETRIES MPL_CONF_NACK_RETRIES
+#endif
+/*---------------------------------------------------------------------------*/
 /* Misc System Config */
 /*---------------------------------------------------------------------------*/
 
@@ -43,6 +43,7 @@
 #include "contiki.h"
 #include "lib/list.h"
 #include "lib/memb.h"
+#include "lib/crc16.h"
 #include "net/ipv6/uip.h"
 #include "net/ipv6/multicast/uip-mcast6-route.h"
 
@@ -60,15 +61,21 @@
 LIST(mcast_route_list);
 MEMB(mcast_route_memb, uip_mcast6_route_t, UIP_MCAST6_ROUTE_ROUTES);
 
+static uip_mcast6_route_t *mcast_route_hash[UIP_MCAST6_ROUTE_HASH_SIZE];
+
 static uip_mcast6_route_t *locmcastrt;
 /*---------------------------------------------------------------------------*/
+/* Groups mostly differ in their group ID, the last 32 bits */
+#define ROUTE_HASH(group) \
+  (((group)->u8[12] ^ (group)->u8[13] ^ (group)->u8[14] ^ (group)->u8[15]) \
+   % UIP_MCAST6_ROUTE_HASH_SIZE)
+/*---------------------------------------------------------------------------*/
 uip_mcast6_route_t *
 uip_mcast6_route_lookup(uip_ipaddr_t *group)
 {
-  locmcastrt = NULL;
-  for(locmcastrt = list_head(mcast_route_list);
+  for(locmcastrt = mcast_route_hash[ROUTE_HASH(group)];
       locmcastrt != NULL;
-      locmcastrt = list_item_next(locmcastrt)) {
+      locmcastrt = locmcastrt->hnext) {
     if(uip_ipaddr_cmp(&locmcastrt->group, group)) {
       return locmcastrt;
     }
@@ -88,7 +95,10 @@ uip_mcast6_route_add(uip_ipaddr_t *group)
     if(locmcastrt == NULL) {
       return NULL;
     }
+    memset(locmcastrt, 0, sizeof(uip_mcast6_route_t));
     list_add(mcast_route_list, locmcastrt);
+    locmcastrt->hnext = mcast_route_hash[ROUTE_HASH(group)];
+    mcast_route_hash[ROUTE_HASH(group)] = locmcastrt;
   }
 
   /* Reaching here means we either found the prefix or allocated a new one */
@@ -101,11 +111,14 @@ uip_mcast6_route_add(uip_ipaddr_t *group)
 void
 uip_mcast6_route_rm(uip_mcast6_route_t *route)
 {
-  /* Make sure it's actually in the list */
-  for(locmcastrt = list_head(mcast_route_list);
-      locmcastrt != NULL;
-      locmcastrt = list_item_next(locmcastrt)) {
-    if(locmcastrt == route) {
+  uip_mcast6_route_t **rp;
+
+  /* Make sure it's actually in the table */
+  for(rp = &mcast_route_hash[ROUTE_HASH(&route->group)];
+      *rp != NULL;
+      rp = &(*rp)->hnext) {
+    if(*rp == route) {
+      *rp = route->hnext;
       list_remove(mcast_route_list, route);
       memb_free(&mcast_route_memb, route);
       return;
@@ -113,6 +126,35 @@ uip_mcast6_route_rm(uip_mcast6_route_t *route)
   }
 }
 /*---------------------------------------------------------------------------*/
+uint8_t
+uip_mcast6_route_is_dup(uip_mcast6_route_t *route)
+{
+#if UIP_MCAST6_ROUTE_DUP_CACHE
+  uint16_t sig;
+  uint8_t i;
+  clock_time_t now = clock_time();
+
+  sig = crc16_data((uint8_t *)&UIP_IP_BUF->srcipaddr, sizeof(uip_ipaddr_t), 0);
+  sig = crc16_data(uip_buf + UIP_IPH_LEN, uip_len - UIP_IPH_LEN, sig);
+  if(sig == 0) {
+    sig = 1; /* 0 marks an empty cache entry */
+  }
+
+  for(i = 0; i < UIP_MCAST6_ROUTE_DUP_CACHE; i++) {
+    if(route->dup_cache[i] == sig &&
+       now - route->dup_time[i] < UIP_MCAST6_ROUTE_DUP_LIFETIME) {
+      UIP_MCAST6_ROUTE_STATS_ADD(route, dup);
+      return 1;
+    }
+  }
+
+  route->dup_cache[route->dup_next] = sig;
+  route->dup_time[route->dup_next] = now;
+  route->dup_next = (route->dup_next + 1) % UIP_MCAST6_ROUTE_DUP_CACHE;
+#endif /* UIP_MCAST6_ROUTE_DUP_CACHE */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 uip_mcast6_route_t *
 uip_mcast6_route_list_head(void)
 {
@@ -130,6 +172,7 @@ uip_mcast6_route_init()
 {
   memb_init(&mcast_route_memb);
   list_init(mcast_route_list);
+  memset(mcast_route_hash, 0, sizeof(mcast_route_hash));
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
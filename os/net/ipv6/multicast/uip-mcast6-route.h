@@ -44,17 +44,69 @@
 
 #include "contiki.h"
 #include "net/ipv6/uip.h"
+#include "net/ipv6/multicast/uip-mcast6-stats.h"
 
 #include <stdint.h>
 /*---------------------------------------------------------------------------*/
+/* Number of hash buckets used to look up routes by group */
+#ifdef UIP_MCAST6_ROUTE_CONF_HASH_SIZE
+#define UIP_MCAST6_ROUTE_HASH_SIZE UIP_MCAST6_ROUTE_CONF_HASH_SIZE
+#else
+#define UIP_MCAST6_ROUTE_HASH_SIZE 4
+#endif
+
+/*
+ * Number of recent datagrams remembered per route for duplicate
+ * suppression, e.g. link-layer retransmissions from our parent whose ACK
+ * was lost. 0 disables duplicate suppression.
+ */
+#ifdef UIP_MCAST6_ROUTE_CONF_DUP_CACHE
+#define UIP_MCAST6_ROUTE_DUP_CACHE UIP_MCAST6_ROUTE_CONF_DUP_CACHE
+#else
+#define UIP_MCAST6_ROUTE_DUP_CACHE 0
+#endif
+
+/*
+ * How long a datagram is remembered for duplicate suppression. Only
+ * retransmissions are expected within that time: a datagram received again
+ * later, with the same contents, is a new one.
+ */
+#ifdef UIP_MCAST6_ROUTE_CONF_DUP_LIFETIME
+#define UIP_MCAST6_ROUTE_DUP_LIFETIME UIP_MCAST6_ROUTE_CONF_DUP_LIFETIME
+#else
+#define UIP_MCAST6_ROUTE_DUP_LIFETIME (2 * CLOCK_SECOND)
+#endif
+/*---------------------------------------------------------------------------*/
+/** \brief Per-group traffic counters */
+struct uip_mcast6_route_stats {
+  UIP_MCAST6_STATS_DATATYPE in; /**< Datagrams received for the group */
+  UIP_MCAST6_STATS_DATATYPE fwd; /**< Datagrams forwarded */
+  UIP_MCAST6_STATS_DATATYPE dup; /**< Duplicates suppressed */
+};
+
 /** \brief An entry in the multicast routing table */
 typedef struct uip_mcast6_route {
   struct uip_mcast6_route *next; /**< Routes are arranged in a linked list */
+  struct uip_mcast6_route *hnext; /**< Next route in the same hash bucket */
   uip_ipaddr_t group; /**< The multicast group */
   uint32_t lifetime; /**< Entry lifetime seconds */
   void *dag; /**< Pointer to an rpl_dag_t struct */
+#if UIP_MCAST6_ROUTE_DUP_CACHE
+  uint16_t dup_cache[UIP_MCAST6_ROUTE_DUP_CACHE]; /**< Signatures of recent datagrams */
+  clock_time_t dup_time[UIP_MCAST6_ROUTE_DUP_CACHE]; /**< When they were received */
+  uint8_t dup_next; /**< Next dup_cache entry to overwrite */
+#endif
+#if UIP_MCAST6_STATS
+  struct uip_mcast6_route_stats stats; /**< Traffic counters */
+#endif
 } uip_mcast6_route_t;
 /*---------------------------------------------------------------------------*/
+#if UIP_MCAST6_STATS
+#define UIP_MCAST6_ROUTE_STATS_ADD(r, x) ((r)->stats.x++)
+#else
+#define UIP_MCAST6_ROUTE_STATS_ADD(r, x)
+#endif
+/*---------------------------------------------------------------------------*/
 /** \name Multicast Routing Table Manipulation */
 /** @{ */
 
@@ -92,6 +144,19 @@ int uip_mcast6_route_count(void);
  * If the multicast routes list is empty, this function will return NULL
  */
 uip_mcast6_route_t *uip_mcast6_route_list_head(void);
+
+/**
+ * \brief Check whether the datagram in uip_buf was already seen on a route
+ * \param route A pointer to the route of the datagram's destination group
+ * \return 1 if the datagram is a duplicate, 0 otherwise
+ *
+ * The datagram is identified by its source address and payload, so the hop
+ * limit does not matter. It is a duplicate only if received within
+ * UIP_MCAST6_ROUTE_CONF_DUP_LIFETIME. Datagrams that are not duplicates are
+ * remembered.
+ * Always returns 0 if UIP_MCAST6_ROUTE_CONF_DUP_CACHE is 0.
+ */
+uint8_t uip_mcast6_route_is_dup(uip_mcast6_route_t *route);
 /*---------------------------------------------------------------------------*/
 /**
  * \brief Multicast routing table init routine
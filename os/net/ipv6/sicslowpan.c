@@ -68,11 +68,13 @@
 #include "net/ipv6/tcpip.h"
 #include "net/ipv6/uip.h"
 #include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-icmp6.h"
 #include "net/ipv6/uipbuf.h"
 #include "net/ipv6/sicslowpan.h"
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
+#include "lib/memb.h"
 
 #include "net/routing/routing.h"
 
@@ -202,6 +204,13 @@ static int last_rssi;
 #if SICSLOWPAN_CONF_FRAG
 static uint16_t my_tag;
 
+/* Packetbuf attributes and addresses of the datagram being fragmented.
+ * Only these (and not the whole frame) need to be restored between
+ * fragments: the FRAGN header and payload are rebuilt in place in
+ * packetbuf from uip_buf for every fragment. */
+static struct packetbuf_attr frag_out_attrs[PACKETBUF_NUM_ATTRS];
+static struct packetbuf_addr frag_out_addrs[PACKETBUF_NUM_ADDRS];
+
 /** The total length of the IPv6 packet in the sicslowpan_buf. */
 
 /* This needs to be defined in NBR / Nodes depending on available RAM   */
@@ -215,12 +224,39 @@ static uint16_t my_tag;
 /* REASS_CONTEXTS corresponds to the number of simultaneous
  * reassemblies that can be made. NOTE: the first buffer for each
  * reassembly is stored in the context since it can be larger than the
- * rest of the fragments due to header compression.
+ * rest of the fragments due to header compression. Memory constrained
+ * nodes that do not expect concurrent senders may lower this to 2.
  **/
 #ifdef SICSLOWPAN_CONF_REASS_CONTEXTS
 #define SICSLOWPAN_REASS_CONTEXTS SICSLOWPAN_CONF_REASS_CONTEXTS
 #else
-#define SICSLOWPAN_REASS_CONTEXTS 2
+#define SICSLOWPAN_REASS_CONTEXTS 4
+#endif
+
+/* When all reassembly contexts are busy, a new first fragment may evict
+ * the oldest pending datagram if it has been in reassembly for at least
+ * half of the reassembly timeout. Set to 0 to always drop the new
+ * datagram instead. */
+#ifdef SICSLOWPAN_CONF_REASS_EVICT
+#define SICSLOWPAN_REASS_EVICT SICSLOWPAN_CONF_REASS_EVICT
+#else
+#define SICSLOWPAN_REASS_EVICT 1
+#endif
+
+/* Fragment forwarding: instead of reassembling datagrams that are not
+ * for this node, forward the first fragment as soon as it is received
+ * and relay the subsequent fragments as they arrive, using the
+ * reassembly context as a virtual reassembly buffer. Not used on border
+ * routers, where datagrams may leave through the fallback interface. */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING SICSLOWPAN_CONF_FRAG_FORWARDING
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+#ifdef UIP_FALLBACK_INTERFACE
+#undef SICSLOWPAN_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING 0
 #endif
 
 /* The size of each fragment (IP payload) for the 6lowpan fragmentation */
@@ -239,20 +275,67 @@ static uint16_t my_tag;
 /* Assuming that the worst growth for uncompression is 38 bytes */
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
 
+#define SICSLOWPAN_REASS_TIMEOUT   (SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16)
+#define SICSLOWPAN_REASS_EVICT_AGE (SICSLOWPAN_REASS_TIMEOUT / 2)
+
+/* Fragment offsets are in units of 8 bytes: we keep one bit per 8-byte
+ * block of the datagram to detect duplicate and overlapping fragments */
+#define SICSLOWPAN_REASS_BLOCKS     ((UIP_BUFSIZE + 7) / 8)
+#define SICSLOWPAN_REASS_BITMAP_LEN ((SICSLOWPAN_REASS_BLOCKS + 7) / 8)
+
+/* A buffer from the shared pool, holding one FRAGN payload */
+struct sicslowpan_frag_buf {
+  struct sicslowpan_frag_buf *next;
+  /* Fragment offset */
+  uint8_t offset;
+  /* Length of this fragment */
+  uint8_t len;
+  uint8_t data[SICSLOWPAN_FRAGMENT_SIZE];
+};
+
+MEMB(frag_buf_memb, struct sicslowpan_frag_buf, SICSLOWPAN_FRAGMENT_BUFFERS);
+
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
   /** When reassembling, the source address of the fragments being merged */
   linkaddr_t sender;
-  /** The destination address of the fragments being merged */
-  linkaddr_t receiver;
   /** When reassembling, the tag in the fragments being merged. */
   uint16_t tag;
-  /** Total length of the fragmented packet */
+  /** Total length of the fragmented packet (zero if the context is free) */
   uint16_t len;
   /** Current length of reassembled fragments */
   uint16_t reassembled_len;
   /** Reassembly %process %timer. */
   struct timer reass_timer;
+  /** The buffers of the subsequent fragments received so far */
+  struct sicslowpan_frag_buf *frags;
+  /** One bit per 8-byte block of the datagram received so far */
+  uint8_t received[SICSLOWPAN_REASS_BITMAP_LEN];
+
+#if SICSLOWPAN_FRAG_FORWARDING
+  /** Set if the fragments are relayed rather than reassembled */
+  uint8_t forward;
+  /** Change in the offset of relayed fragments (in units of 8 bytes), when
+      the forwarding node added or removed extension headers */
+  int8_t forward_offset_delta;
+  /** Tag and datagram size of the relayed fragments */
+  uint16_t forward_tag;
+  uint16_t forward_size;
+  /** The next hop the fragments are relayed to */
+  linkaddr_t forward_next_hop;
+  /** Packetbuf attributes the first fragment was relayed with */
+  packetbuf_attr_t forward_max_transmissions;
+  packetbuf_attr_t forward_priority;
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_attr_t forward_security_level;
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  packetbuf_attr_t forward_key_index;
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+  /** Set if uIP already processed the datagram for a forwarding
+      decision, before it was reassembled */
+  uint8_t probed;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 
   /** Fragment size of first fragment */
   uint16_t first_frag_len;
@@ -263,32 +346,97 @@ struct sicslowpan_frag_info {
 
 static struct sicslowpan_frag_info frag_info[SICSLOWPAN_REASS_CONTEXTS];
 
-struct sicslowpan_frag_buf {
-  /* the index of the frag_info */
-  uint8_t index;
-  /* Fragment offset */
-  uint8_t offset;
-  /* Length of this fragment (if zero this buffer is not allocated) */
-  uint8_t len;
-  uint8_t data[SICSLOWPAN_FRAGMENT_SIZE];
-};
+static struct sicslowpan_reass_stats reass_stats;
+
+#if SICSLOWPAN_FRAG_FORWARDING
+/* The context of the datagram passed to uIP for a forwarding decision,
+   -1 if none */
+static int8_t forward_context = -1;
+/* Set by output() if the datagram cannot be forwarded fragment by
+   fragment and must be reassembled first */
+static uint8_t forward_fallback;
+
+static void send_packet(linkaddr_t *dest);
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
+/*---------------------------------------------------------------------------*/
+/* Hash of (sender, tag, size), used as the first slot to probe for a
+   reassembly context */
+static uint8_t
+reass_hash(const linkaddr_t *sender, uint16_t tag, uint16_t size)
+{
+  uint16_t h;
+  int i;
 
-static struct sicslowpan_frag_buf frag_buf[SICSLOWPAN_FRAGMENT_BUFFERS];
+  h = tag ^ (size << 5);
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h << 3) ^ (h >> 13) ^ sender->u8[i];
+  }
+  return h % SICSLOWPAN_REASS_CONTEXTS;
+}
+/*---------------------------------------------------------------------------*/
+static int8_t
+find_context(const linkaddr_t *sender, uint16_t tag, uint16_t size)
+{
+  int i;
+  uint8_t index;
 
+  index = reass_hash(sender, tag, size);
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    if(frag_info[index].len == size && frag_info[index].tag == tag &&
+       linkaddr_cmp(&frag_info[index].sender, sender)) {
+      return index;
+    }
+    index = (index + 1) % SICSLOWPAN_REASS_CONTEXTS;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if any of the 8-byte blocks [first, first + count) of the
+   datagram were already received, 0 otherwise */
+static int
+blocks_received(const struct sicslowpan_frag_info *info,
+                uint16_t first, uint16_t count)
+{
+  uint16_t i;
+  for(i = first; i < first + count; i++) {
+    if(info->received[i >> 3] & (1 << (i & 7))) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+blocks_set_received(struct sicslowpan_frag_info *info,
+                    uint16_t first, uint16_t count)
+{
+  uint16_t i;
+  for(i = first; i < first + count; i++) {
+    info->received[i >> 3] |= 1 << (i & 7);
+  }
+}
 /*---------------------------------------------------------------------------*/
 static int
 clear_fragments(uint8_t frag_info_index)
 {
-  int i, clear_count;
+  struct sicslowpan_frag_buf *buf;
+  int clear_count;
+
   clear_count = 0;
   frag_info[frag_info_index].len = 0;
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len > 0 && frag_buf[i].index == frag_info_index) {
-      /* deallocate the buffer */
-      frag_buf[i].len = 0;
-      clear_count++;
-    }
+  while((buf = frag_info[frag_info_index].frags) != NULL) {
+    /* deallocate the buffer */
+    frag_info[frag_info_index].frags = buf->next;
+    memb_free(&frag_buf_memb, buf);
+    clear_count++;
   }
+  memset(frag_info[frag_info_index].received, 0,
+         sizeof(frag_info[frag_info_index].received));
+#if SICSLOWPAN_FRAG_FORWARDING
+  frag_info[frag_info_index].forward = 0;
+  frag_info[frag_info_index].probed = 0;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
   return clear_count;
 }
 /*---------------------------------------------------------------------------*/
@@ -301,111 +449,216 @@ timeout_fragments(int not_context)
     if(frag_info[i].len > 0 && i != not_context &&
        timer_expired(&frag_info[i].reass_timer)) {
       /* This context can be freed */
+      LOG_INFO("reassembly: timeout - tag: %d\n", frag_info[i].tag);
       count += clear_fragments(i);
+      reass_stats.timed_out++;
     }
   }
   return count;
 }
 /*---------------------------------------------------------------------------*/
-static int
-store_fragment(uint8_t index, uint8_t offset)
+/* Get a context for a new datagram, starting at its hash slot. Evicts
+   the oldest pending datagram if all contexts are busy and
+   SICSLOWPAN_REASS_EVICT is set. */
+static int8_t
+new_context(const linkaddr_t *sender, uint16_t tag, uint16_t size)
 {
   int i;
-  int len;
-
-  len = packetbuf_datalen() - packetbuf_hdr_len;
+  uint8_t index;
+#if SICSLOWPAN_REASS_EVICT
+  int8_t oldest = -1;
+  clock_time_t oldest_age = 0;
+#endif /* SICSLOWPAN_REASS_EVICT */
 
-  if(len < 0 || len > SICSLOWPAN_FRAGMENT_SIZE) {
-    /* Unacceptable fragment size. */
-    return -1;
+  index = reass_hash(sender, tag, size);
+  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
+    /* We use len as indication on used or not used */
+    if(frag_info[index].len == 0) {
+      return index;
+    }
+#if SICSLOWPAN_REASS_EVICT
+    if(oldest < 0 ||
+       clock_time() - frag_info[index].reass_timer.start > oldest_age) {
+      oldest = index;
+      oldest_age = clock_time() - frag_info[index].reass_timer.start;
+    }
+#endif /* SICSLOWPAN_REASS_EVICT */
+    index = (index + 1) % SICSLOWPAN_REASS_CONTEXTS;
   }
 
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    if(frag_buf[i].len == 0) {
-      /* copy over the data from packetbuf into the fragment buffer,
-         and store offset and len */
-      frag_buf[i].offset = offset; /* frag offset */
-      frag_buf[i].len = len;
-      frag_buf[i].index = index;
-      memcpy(frag_buf[i].data, packetbuf_ptr + packetbuf_hdr_len, len);
-      /* return the length of the stored fragment */
-      return len;
-    }
+#if SICSLOWPAN_REASS_EVICT
+  if(oldest >= 0 && oldest_age >= SICSLOWPAN_REASS_EVICT_AGE) {
+    LOG_WARN("reassembly: evicting stale fragment session - tag: %d\n",
+             frag_info[oldest].tag);
+    clear_fragments(oldest);
+    reass_stats.evicted++;
+    return oldest;
   }
-  /* failed */
+#endif /* SICSLOWPAN_REASS_EVICT */
   return -1;
 }
+#if SICSLOWPAN_FRAG_FORWARDING
+/*---------------------------------------------------------------------------*/
+/* Relay the subsequent fragment in packetbuf to the next hop of its
+   datagram, rewriting the fragment header */
+static void
+relay_fragment(uint8_t index, uint8_t offset, int len)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+  uint8_t payload[SICSLOWPAN_FRAGMENT_SIZE];
+
+  blocks_set_received(info, offset, (len + 7) >> 3);
+  info->reassembled_len += len;
+
+  memcpy(payload, packetbuf_ptr + packetbuf_hdr_len, len);
+
+  /* Send with the attributes of the relayed first fragment */
+  packetbuf_clear();
+  packetbuf_ptr = packetbuf_dataptr();
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &info->forward_next_hop);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     info->forward_max_transmissions);
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, info->forward_priority);
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL,
+                     info->forward_security_level);
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX, info->forward_key_index);
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+  if(SICSLOWPAN_FRAGN_HDR_LEN + len > NETSTACK_MAC.max_payload()) {
+    LOG_WARN("forwarding: fragment does not fit next hop frame - dropping datagram tag: %d\n",
+             info->tag);
+    clear_fragments(index);
+    return;
+  }
+
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAGN << 8) | info->forward_size));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, info->forward_tag);
+  PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = offset + info->forward_offset_delta;
+  packetbuf_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
+  memcpy(packetbuf_ptr + packetbuf_hdr_len, payload, len);
+  packetbuf_set_datalen(packetbuf_hdr_len + len);
+
+  LOG_INFO("forwarding: relaying fragment (tag %d -> %d, payload %d, offset %d)\n",
+           info->tag, info->forward_tag, len, offset << 3);
+  send_packet(&info->forward_next_hop);
+
+  if(info->reassembled_len >= info->len) {
+    /* All fragments relayed */
+    clear_fragments(index);
+  }
+}
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 /*---------------------------------------------------------------------------*/
 /* add a new fragment to the buffer */
 static int8_t
 add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 {
-  int i;
   int len;
-  int8_t found = -1;
+  int8_t found;
+  struct sicslowpan_frag_buf *buf;
+  const linkaddr_t *sender = packetbuf_addr(PACKETBUF_ADDR_SENDER);
+
+  if(frag_size > UIP_BUFSIZE) {
+    /* The datagram can never be reassembled, drop it early */
+    LOG_WARN("reassembly: datagram too large (%u) - tag: %d\n", frag_size, tag);
+    reass_stats.invalid++;
+    return -1;
+  }
+
+  /* clear all fragment info with expired timer to free all fragment
+     buffers, and so that an expired datagram is never matched below */
+  timeout_fragments(-1);
+
+  found = find_context(sender, tag, frag_size);
 
   if(offset == 0) {
     /* This is a first fragment - check if we can add this */
-    for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-      /* clear all fragment info with expired timer to free all fragment buffers */
-      if(frag_info[i].len > 0 && timer_expired(&frag_info[i].reass_timer)) {
-        clear_fragments(i);
-      }
-
-      /* We use len as indication on used or not used */
-      if(found < 0 && frag_info[i].len == 0) {
-        /* We remember the first free fragment info but must continue
-           the loop to free any other expired fragment buffers. */
-        found = i;
-      }
+    if(found >= 0) {
+      /* Typically a link-layer retransmission whose ACK was lost */
+      LOG_INFO("reassembly: duplicate first fragment - tag: %d\n", tag);
+      reass_stats.duplicates++;
+      return -1;
     }
 
+    found = new_context(sender, tag, frag_size);
     if(found < 0) {
       LOG_WARN("reassembly: failed to store new fragment session - tag: %d\n", tag);
+      reass_stats.no_context++;
       return -1;
     }
 
     /* Found a free fragment info to store data in */
     frag_info[found].len = frag_size;
     frag_info[found].tag = tag;
-    linkaddr_copy(&frag_info[found].sender,
-                  packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+    frag_info[found].reassembled_len = 0;
+    linkaddr_copy(&frag_info[found].sender, sender);
+    timer_set(&frag_info[found].reass_timer, SICSLOWPAN_REASS_TIMEOUT);
+    reass_stats.started++;
     /* first fragment can not be stored immediately but is moved into
        the buffer while uncompressing */
     return found;
   }
 
   /* This is a N-fragment - should find the info */
-  for(i = 0; i < SICSLOWPAN_REASS_CONTEXTS; i++) {
-    if(frag_info[i].tag == tag && frag_info[i].len > 0 &&
-       linkaddr_cmp(&frag_info[i].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
-      /* Tag and Sender match - this must be the correct info to store in */
-      found = i;
-      break;
-    }
-  }
-
   if(found < 0) {
     /* no entry found for storing the new fragment */
     LOG_WARN("reassembly: failed to store N-fragment - could not find session - tag: %d offset: %d\n", tag, offset);
+    reass_stats.no_session++;
     return -1;
   }
 
-  /* i is the index of the reassembly context */
-  len = store_fragment(i, offset);
-  if(len < 0 && timeout_fragments(i) > 0) {
-    len = store_fragment(i, offset);
+  len = packetbuf_datalen() - packetbuf_hdr_len;
+  if(len <= 0 || len > SICSLOWPAN_FRAGMENT_SIZE ||
+     (offset << 3) + len > UIP_BUFSIZE) {
+    /* Unacceptable fragment size or offset. */
+    LOG_WARN("reassembly: invalid fragment (len %d, offset %d) - tag: %d\n",
+             len, offset, tag);
+    reass_stats.invalid++;
+    return -1;
   }
-  if(len > 0) {
-    frag_info[i].reassembled_len += len;
-    return i;
-  } else {
-    /* should we also clear all fragments since we failed to store
-       this fragment? */
-    LOG_WARN("reassembly: failed to store fragment - packet reassembly will fail tag:%d l\n", frag_info[i].tag);
+
+  if(blocks_received(&frag_info[found], offset, (len + 7) >> 3)) {
+    /* Do not account twice for the same data */
+    LOG_INFO("reassembly: duplicate or overlapping fragment - tag: %d offset: %d\n",
+             tag, offset);
+    reass_stats.duplicates++;
     return -1;
   }
+
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(frag_info[found].forward) {
+    relay_fragment(found, offset, len);
+    return -1;
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
+  buf = memb_alloc(&frag_buf_memb);
+  if(buf == NULL && timeout_fragments(found) > 0) {
+    buf = memb_alloc(&frag_buf_memb);
+  }
+  if(buf == NULL) {
+    /* This datagram cannot complete: release its buffers now so that
+       other datagrams in reassembly can use them. */
+    LOG_WARN("reassembly: no fragment buffer - dropping datagram tag: %d\n",
+             frag_info[found].tag);
+    clear_fragments(found);
+    reass_stats.no_buffer++;
+    return -1;
+  }
+
+  /* copy over the data from packetbuf into the fragment buffer,
+     and store offset and len */
+  buf->offset = offset;
+  buf->len = len;
+  memcpy(buf->data, packetbuf_ptr + packetbuf_hdr_len, len);
+  buf->next = frag_info[found].frags;
+  frag_info[found].frags = buf;
+  blocks_set_received(&frag_info[found], offset, (len + 7) >> 3);
+  frag_info[found].reassembled_len += len;
+  return found;
 }
 /*---------------------------------------------------------------------------*/
 /* Copy all the fragments that are associated with a specific context
@@ -413,7 +666,7 @@ add_fragment(uint16_t tag, uint16_t frag_size, uint8_t offset)
 static bool
 copy_frags2uip(int context)
 {
-  int i;
+  struct sicslowpan_frag_buf *buf;
 
   /* Check length fields before proceeding. */
   if(frag_info[context].len < frag_info[context].first_frag_len ||
@@ -431,24 +684,93 @@ copy_frags2uip(int context)
   memset((uint8_t *)UIP_IP_BUF + frag_info[context].first_frag_len, 0,
          frag_info[context].len - frag_info[context].first_frag_len);
 
-  for(i = 0; i < SICSLOWPAN_FRAGMENT_BUFFERS; i++) {
-    /* And also copy all matching fragments */
-    if(frag_buf[i].len > 0 && frag_buf[i].index == context) {
-      if((frag_buf[i].offset << 3) + frag_buf[i].len > sizeof(uip_buf)) {
-        LOG_WARN("input: invalid fragment offset\n");
-        clear_fragments(context);
-        return false;
-      }
-      memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(frag_buf[i].offset << 3),
-             (uint8_t *)frag_buf[i].data, frag_buf[i].len);
+  /* And also copy all fragments of this context */
+  for(buf = frag_info[context].frags; buf != NULL; buf = buf->next) {
+    if((buf->offset << 3) + buf->len > sizeof(uip_buf)) {
+      LOG_WARN("input: invalid fragment offset\n");
+      clear_fragments(context);
+      return false;
     }
+    memcpy((uint8_t *)UIP_IP_BUF + (uint16_t)(buf->offset << 3),
+           (uint8_t *)buf->data, buf->len);
   }
   /* deallocate all the fragments for this context */
   clear_fragments(context);
+  reass_stats.completed++;
 
   return true;
 }
+#if SICSLOWPAN_FRAG_FORWARDING
+/*---------------------------------------------------------------------------*/
+/* Called on a first fragment once its headers are uncompressed. If the
+   datagram is not for us, pass a virtual copy of it to uIP, with the
+   payload not received yet zeroed, to take the forwarding decision and
+   update the headers. output() then sends the first fragment and turns
+   the context into a virtual reassembly buffer. Returns 1 if the
+   datagram has been handled, 0 if it must be reassembled. */
+static int
+forward_first_fragment(uint8_t index)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+  struct uip_ip_hdr *hdr = (struct uip_ip_hdr *)info->first_frag;
+
+  if(uip_is_addr_mcast(&hdr->destipaddr) ||
+     uip_ds6_is_my_addr(&hdr->destipaddr) ||
+     info->len < info->first_frag_len) {
+    return 0;
+  }
+
+  memcpy(UIP_IP_BUF, info->first_frag, info->first_frag_len);
+  memset((uint8_t *)UIP_IP_BUF + info->first_frag_len, 0,
+         info->len - info->first_frag_len);
+  uip_len = info->len;
+  uipbuf_set_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FRAG_FORWARD);
+#if LLSEC802154_USES_AUX_HEADER
+  /* As for a reassembled datagram, the LLSEC state of the received frame */
+  uipbuf_set_attr(UIPBUF_ATTR_LLSEC_LEVEL,
+    packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL));
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  uipbuf_set_attr(UIPBUF_ATTR_LLSEC_KEY_ID,
+    packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX));
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  forward_context = index;
+  forward_fallback = 0;
+  tcpip_input();
+  forward_context = -1;
+
+  if(info->forward) {
+    reass_stats.forwarded++;
+    return 1;
+  }
+  if(forward_fallback) {
+    info->probed = 1;
+    return 0;
+  }
+  /* uIP dropped the datagram, and would drop it once reassembled too */
+  LOG_INFO("forwarding: datagram not forwarded - tag: %d\n", info->tag);
+  clear_fragments(index);
+  return 1;
+}
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+/*---------------------------------------------------------------------------*/
+const struct sicslowpan_reass_stats *
+sicslowpan_get_reass_stats(void)
+{
+  return &reass_stats;
+}
 #endif /* SICSLOWPAN_CONF_FRAG */
+/*---------------------------------------------------------------------------*/
+void
+sicslowpan_frag_forward_defer(void)
+{
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(forward_context >= 0) {
+    forward_fallback = 1;
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+}
 
 /* -------------------------------------------------------------------------- */
 
@@ -498,6 +820,37 @@ set_packet_attrs(void)
 /*   } */
 
 }
+/*--------------------------------------------------------------------*/
+/* The MAC queueing priority of the packet in uip_buf: as set by upper
+ * layers, else control for ICMPv6 messages other than echo, else high for
+ * packets tagged with a high DSCP */
+static uint16_t
+packet_priority(void)
+{
+  uint8_t proto;
+  uint8_t *hdr;
+
+  if(uipbuf_get_attr(UIPBUF_ATTR_PRIORITY) != PACKETBUF_ATTR_PRIORITY_BEST_EFFORT) {
+    return uipbuf_get_attr(UIPBUF_ATTR_PRIORITY);
+  }
+
+  hdr = uipbuf_get_last_header(uip_buf, uip_len, &proto);
+  if(hdr != NULL && proto == UIP_PROTO_ICMP6
+     && hdr[0] != ICMP6_ECHO_REQUEST && hdr[0] != ICMP6_ECHO_REPLY) {
+    return PACKETBUF_ATTR_PRIORITY_CONTROL;
+  }
+
+#if !UIP_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS
+  {
+    uint8_t tc = (UIP_IP_BUF->vtc << 4) | (UIP_IP_BUF->tcflow >> 4);
+    if((tc >> 2) >= UIP_TC_DSCP_HIGH_MIN) {
+      return PACKETBUF_ATTR_PRIORITY_HIGH;
+    }
+  }
+#endif /* !UIP_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS */
+
+  return PACKETBUF_ATTR_PRIORITY_BEST_EFFORT;
+}
 
 
 
@@ -1514,32 +1867,34 @@ send_packet(linkaddr_t *dest)
 /**
  * \brief This function is called by the 6lowpan code to copy a fragment's
  * payload from uIP and send it down the stack.
+ *
+ * The fragment header (and, for FRAG1, the compressed IP headers) must
+ * already be in place at packetbuf_ptr. The payload is copied directly
+ * from uip_buf after the headers. Once the MAC has taken the frame, only
+ * the packetbuf attributes saved in frag_out_attrs/frag_out_addrs are
+ * restored; the caller rebuilds the next fragment header in place. This
+ * avoids backing up and restoring the whole frame through a queuebuf
+ * for every fragment.
+ *
  * \param uip_offset the offset in the uIP buffer where to copy the payload from
  * \param dest the link layer destination address of the packet
  * \return 1 if success, 0 otherwise
  */
 static int
 fragment_copy_payload_and_send(uint16_t uip_offset, linkaddr_t *dest) {
-  struct queuebuf *q;
-
   /* Now copy fragment payload from uip_buf */
   memcpy(packetbuf_ptr + packetbuf_hdr_len,
          (uint8_t *)UIP_IP_BUF + uip_offset, packetbuf_payload_len);
   packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
 
-  /* Backup packetbuf to queuebuf. Enables preserving attributes for all framgnets */
-  q = queuebuf_new_from_packetbuf();
-  if(q == NULL) {
-    LOG_WARN("output: could not allocate queuebuf, dropping fragment\n");
-    return 0;
-  }
-
   /* Send fragment */
   send_packet(dest);
 
-  /* Restore packetbuf from queuebuf */
-  queuebuf_to_packetbuf(q);
-  queuebuf_free(q);
+  /* The MAC may have added its own header to packetbuf: start over with
+     an empty buffer and the attributes of the original datagram */
+  packetbuf_clear();
+  packetbuf_attr_copyfrom(frag_out_attrs, frag_out_addrs);
+  packetbuf_ptr = packetbuf_dataptr();
 
   /* Check tx result. */
   if((last_tx_status == MAC_TX_COLLISION) ||
@@ -1551,6 +1906,71 @@ fragment_copy_payload_and_send(uint16_t uip_offset, linkaddr_t *dest) {
   return 1;
 }
 #endif /* SICSLOWPAN_CONF_FRAG */
+#if SICSLOWPAN_FRAG_FORWARDING
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Send the first fragment of a datagram forwarded fragment by
+ * fragment, and set up its context to relay the subsequent fragments.
+ *
+ * The IP packet in uip_buf is the virtual datagram built by
+ * forward_first_fragment(), its headers already compressed into
+ * packetbuf. The first fragment sent carries exactly the data received
+ * in the incoming first fragment, so that the subsequent fragments can
+ * be relayed unmodified apart from their header.
+ * \param index the reassembly context of the datagram
+ * \param dest the link layer destination address of the packet
+ * \return 1 if success, 0 otherwise
+ */
+static uint8_t
+output_forwarded_first_fragment(uint8_t index, linkaddr_t *dest)
+{
+  struct sicslowpan_frag_info *info = &frag_info[index];
+  /* Extension headers added or removed while forwarding */
+  int delta = (int)uip_len - (int)info->len;
+  int payload_len = (int)info->first_frag_len + delta - (int)uncomp_hdr_len;
+
+  if((delta & 7) != 0 || delta / 8 < INT8_MIN || delta / 8 > INT8_MAX ||
+     uip_len > 0x7ff || payload_len < 0 ||
+     packetbuf_hdr_len + SICSLOWPAN_FRAG1_HDR_LEN + payload_len > mac_max_payload) {
+    LOG_INFO("forwarding: cannot relay fragments, reassembling - tag: %d\n",
+             info->tag);
+    forward_fallback = 1;
+    return 0;
+  }
+
+  info->forward = 1;
+  info->forward_offset_delta = delta / 8;
+  info->forward_tag = my_tag++;
+  info->forward_size = uip_len;
+  linkaddr_copy(&info->forward_next_hop, dest);
+  /* Saved for the subsequent fragments, see relay_fragment() */
+  info->forward_max_transmissions =
+    packetbuf_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS);
+  info->forward_priority = packetbuf_attr(PACKETBUF_ATTR_PRIORITY);
+#if LLSEC802154_USES_AUX_HEADER
+  info->forward_security_level = packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL);
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  info->forward_key_index = packetbuf_attr(PACKETBUF_ATTR_KEY_INDEX);
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /* LLSEC802154_USES_AUX_HEADER */
+
+  /* Move IPHC/IPv6 header to make room for FRAG1 header */
+  memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+  packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, info->forward_tag);
+
+  memcpy(packetbuf_ptr + packetbuf_hdr_len,
+         (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, payload_len);
+  packetbuf_set_datalen(packetbuf_hdr_len + payload_len);
+
+  LOG_INFO("forwarding: first fragment (tag %d -> %d, payload %d)\n",
+           info->tag, info->forward_tag, payload_len);
+  send_packet(dest);
+  return 1;
+}
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 /*--------------------------------------------------------------------*/
 /** \brief Take an IP packet and format it to be sent on an 802.15.4
  *  network using 6lowpan.
@@ -1599,6 +2019,7 @@ output(const linkaddr_t *localdest)
   /* copy over the retransmission count from uipbuf attributes */
   packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
                      uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, packet_priority());
 
 /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_MAC */
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
@@ -1645,6 +2066,17 @@ output(const linkaddr_t *localdest)
 
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(forward_context >= 0 &&
+     uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr,
+                    &((struct uip_ip_hdr *)frag_info[forward_context].first_frag)->srcipaddr)) {
+    /* This is the virtual datagram of a fragment forwarding decision */
+    int8_t index = forward_context;
+    forward_context = -1;
+    return output_forwarded_first_fragment(index, &dest);
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   frag_needed = (int)uip_len - (int)uncomp_hdr_len + (int)packetbuf_hdr_len > mac_max_payload;
   LOG_INFO("output: header len %d -> %d, total len %d -> %d, MAC max payload %d, frag_needed %d\n",
             uncomp_hdr_len, packetbuf_hdr_len,
@@ -1682,7 +2114,7 @@ output(const linkaddr_t *localdest)
       fragment_count += 1 + (middle_fragn_total_payload - 1) / fragn_max_payload;
     }
 
-    int freebuf = queuebuf_numfree() - 1;
+    int freebuf = queuebuf_numfree();
     LOG_INFO("output: fragmentation needed, fragments: %u, free queuebufs: %u\n",
       fragment_count, freebuf);
 
@@ -1717,6 +2149,9 @@ output(const linkaddr_t *localdest)
     /* Set frag1 payload len. Was already caulcated earlier as frag1_payload */
     packetbuf_payload_len = frag1_payload;
 
+    /* Save the attributes to be restored for each subsequent fragment */
+    packetbuf_attr_copyto(frag_out_attrs, frag_out_addrs);
+
     /* Copy payload from uIP and send fragment */
     /* Send fragment */
     LOG_INFO("output: fragment %d/%d (tag %d, payload %d)\n",
@@ -1728,10 +2163,7 @@ output(const linkaddr_t *localdest)
 
     /* Now prepare for subsequent fragments. */
 
-    /* FRAGN header: tag was already set at FRAG1. Now set dispatch for all FRAGN */
     packetbuf_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
-    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
-          ((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len));
 
     /* Keep track of the total length of data sent */
     processed_ip_out_len = uncomp_hdr_len + packetbuf_payload_len;
@@ -1739,7 +2171,11 @@ output(const linkaddr_t *localdest)
     /* Create and send subsequent fragments. */
     while(processed_ip_out_len < uip_len) {
       curr_frag++;
-      /* FRAGN header: set offset for this fragment */
+      /* FRAGN header: packetbuf was reset after the previous fragment,
+         so write the whole header in place */
+      SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+            ((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len));
+      SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, frag_tag);
       PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = processed_ip_out_len >> 3;
 
       /* Calculate fragment len */
@@ -1795,8 +2231,8 @@ output(const linkaddr_t *localdest)
  *  copied in siclowpan_buf. If the IP packet is complete it is copied
  *  to uip_buf and the IP layer is called.
  *
- * \note We do not check for overlapping sicslowpan fragments
- * (it is a SHALL in the RFC 4944 and should never happen)
+ * \note Duplicate and overlapping subsequent fragments are detected
+ * with a per-datagram bitmap of received 8-byte blocks and ignored.
  */
 static void
 input(void)
@@ -1863,7 +2299,7 @@ input(void)
       frag_context = add_fragment(frag_tag, frag_size, frag_offset);
 
       if(frag_context == -1) {
-        LOG_ERR("input: failed to allocate new reassembly context\n");
+        /* No context, or a duplicate (already logged) */
         return;
       }
 
@@ -1884,7 +2320,7 @@ input(void)
       frag_context = add_fragment(frag_tag, frag_size, frag_offset);
 
       if(frag_context == -1) {
-        LOG_ERR("input: reassembly context not found (tag %d)\n", frag_tag);
+        /* Not stored: relayed, or no context, duplicate or invalid */
         return;
       }
 
@@ -1995,15 +2431,30 @@ input(void)
     if(first_fragment != 0) {
       frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
       frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+      blocks_set_received(&frag_info[frag_context], 0,
+                          frag_info[frag_context].first_frag_len >> 3);
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(forward_first_fragment(frag_context)) {
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     }
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
     if(last_fragment != 0) {
+#if SICSLOWPAN_FRAG_FORWARDING
+      uint8_t probed = frag_info[frag_context].probed;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
       frag_info[frag_context].reassembled_len = frag_size;
       /* copy to uip */
       if(!copy_frags2uip(frag_context)) {
         return;
       }
+#if SICSLOWPAN_FRAG_FORWARDING
+      if(probed) {
+        uipbuf_set_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FRAG_PROBED);
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     }
   }
 
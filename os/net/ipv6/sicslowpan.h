@@ -338,6 +338,38 @@ struct sicslowpan_nh_compressor {
 
 int sicslowpan_get_last_rssi(void);
 
+/**
+ * \brief Called by uIP when the virtual datagram passed to it for a
+ * fragment forwarding decision cannot be sent yet, e.g. because its next
+ * hop is being resolved. The datagram is then reassembled and passed to
+ * uIP again once complete, so that it can be queued.
+ */
+void sicslowpan_frag_forward_defer(void);
+
+#if SICSLOWPAN_CONF_FRAG
+/**
+ * 6LoWPAN reassembly statistics
+ */
+struct sicslowpan_reass_stats {
+  uint32_t started;    /**< Datagrams for which a reassembly was started */
+  uint32_t completed;  /**< Datagrams fully reassembled */
+  uint32_t timed_out;  /**< Reassemblies dropped after the reassembly timeout */
+  uint32_t evicted;    /**< Stale reassemblies evicted for a new datagram */
+  uint32_t no_context; /**< First fragments dropped, no free context */
+  uint32_t no_session; /**< Subsequent fragments without a matching context */
+  uint32_t no_buffer;  /**< Reassemblies dropped, out of fragment buffers */
+  uint32_t duplicates; /**< Duplicate or overlapping fragments ignored */
+  uint32_t invalid;    /**< Fragments dropped for an invalid size or offset */
+  uint32_t forwarded;  /**< Datagrams relayed fragment by fragment */
+};
+
+/**
+ * \brief Get the 6LoWPAN reassembly statistics
+ * \return A pointer to the statistics
+ */
+const struct sicslowpan_reass_stats *sicslowpan_get_reass_stats(void);
+#endif /* SICSLOWPAN_CONF_FRAG */
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
@@ -45,7 +45,9 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/sicslowpan.h"
 #include "net/linkaddr.h"
+#include "net/packetbuf.h"
 #include "net/routing/routing.h"
 
 #include <string.h>
@@ -117,7 +119,14 @@ tcpip_output(const uip_lladdr_t *a)
     UIP_IP_BUF->tcflow =
       uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS) << 4;
   }
-#endif
+#else /* UIP_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS */
+  /* Tag high-priority packets with a DSCP, for forwarders to queue them as such */
+  if(uipbuf_get_attr(UIPBUF_ATTR_PRIORITY) == PACKETBUF_ATTR_PRIORITY_HIGH
+     && (UIP_IP_BUF->vtc & 0x0f) == 0 && (UIP_IP_BUF->tcflow & 0xf0) == 0) {
+    UIP_IP_BUF->vtc = 0x60 | (UIP_TC_DSCP_EF >> 4);
+    UIP_IP_BUF->tcflow |= (UIP_TC_DSCP_EF & 0x0f) << 4;
+  }
+#endif /* UIP_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS */
 
   if(netstack_process_ip_callback(NETSTACK_IP_OUTPUT, (const linkaddr_t *)a) ==
      NETSTACK_IP_PROCESS) {
@@ -561,9 +570,19 @@ queue_packet(uip_ds6_nbr_t *nbr)
 {
   /* Copy outgoing pkt in the queuing buffer for later transmit. */
 #if UIP_CONF_IPV6_QUEUE_PKT
-  if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-    memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-    uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
+  struct uip_packetqueue_packet *p;
+
+  if(uipbuf_is_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FRAG_FORWARD)) {
+    /* The rest of this datagram is still in flight as fragments: have it
+       reassembled, it is queued when passed to us again */
+    sicslowpan_frag_forward_defer();
+    return 1;
+  }
+
+  p = uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME);
+  if(p != NULL) {
+    memcpy(p->queue_buf, UIP_IP_BUF, uip_len);
+    p->queue_buf_len = uip_len;
     return 0;
   }
 #endif
@@ -577,12 +596,13 @@ send_queued(uip_ds6_nbr_t *nbr)
 {
 #if UIP_CONF_IPV6_QUEUE_PKT
   /*
-   * Send the queued packets from here, may not be 100% perfect though.
+   * Send the queued packets from here, oldest first, may not be 100%
+   * perfect though.
    * This happens in a few cases, for example when instead of receiving a
    * NA after sendiong a NS, you receive a NS with SLLAO: the entry moves
    * to STALE, and you must both send a NA and the queued packet.
    */
-  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
+  while(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
     uip_len = uip_packetqueue_buflen(&nbr->packethandle);
     memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
     uip_packetqueue_free(&nbr->packethandle);
@@ -598,6 +618,8 @@ send_nd6_ns(const uip_ipaddr_t *nexthop)
 
 #if UIP_ND6_SEND_NS
    uip_ds6_nbr_t *nbr = NULL;
+  int sent;
+
   if((nbr = uip_ds6_nbr_add(nexthop, NULL, 0, NBR_INCOMPLETE, NBR_TABLE_REASON_IPV6_ND, NULL)) != NULL) {
     err = 0;
 
@@ -609,13 +631,18 @@ send_nd6_ns(const uip_ipaddr_t *nexthop)
    * solicitation.  Otherwise, any one of the addresses assigned to the
    * interface should be used."*/
    if(uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)){
-      uip_nd6_ns_output(&UIP_IP_BUF->srcipaddr, NULL, &nbr->ipaddr);
+      sent = uip_nd6_ns_output(&UIP_IP_BUF->srcipaddr, NULL, &nbr->ipaddr);
     } else {
-      uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
+      sent = uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
     }
 
-    stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
-    nbr->nscount = 1;
+    /* If rate limited, the NS is sent later by the neighbor periodic
+       processing, and not counted until then */
+    if(sent != 0) {
+      stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+      nbr->nscount = 1;
+    }
+    uip_ds6_nbr_schedule(nbr);
     /* Send the first NS try from here (multicast destination IP address). */
   }
 #else
@@ -704,6 +731,10 @@ tcpip_ipv6_output(void)
       goto exit;
     } else {
       /* We're sending NS here instead of original packet */
+      if(uip_len == 0) {
+        /* No NS was built, e.g. because it was rate limited */
+        goto exit;
+      }
       goto send_packet;
     }
   }
@@ -720,6 +751,7 @@ tcpip_ipv6_output(void)
     nbr->state = NBR_DELAY;
     stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
     nbr->nscount = 0;
+    uip_ds6_nbr_schedule(nbr);
     LOG_INFO("output: nbr cache entry stale moving to delay\n");
   }
 #endif /* UIP_ND6_SEND_NS */
@@ -104,6 +104,13 @@ MEMB(uip_ds6_nbr_memb, uip_ds6_nbr_t, UIP_DS6_NBR_MAX_NEIGHBOR_CACHES);
 NBR_TABLE(uip_ds6_nbr_t, ds6_neighbors);
 #endif /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
 
+#if UIP_ND6_SEND_NS
+/* Earliest expiration, in clock_seconds(), of a neighbor state timer.
+ * uip_ds6_neighbor_periodic() only scans the cache once it has passed. */
+static unsigned long next_nbr_event;
+static uint8_t nbr_event_pending;
+#endif /* UIP_ND6_SEND_NS */
+
 /*---------------------------------------------------------------------------*/
 void
 uip_ds6_neighbors_init(void)
@@ -198,6 +205,7 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
     }
     stimer_set(&nbr->sendns, 0);
     nbr->nscount = 0;
+    uip_ds6_nbr_schedule(nbr);
 #endif /* UIP_ND6_SEND_NS */
     LOG_INFO("Adding neighbor with ip addr ");
     LOG_INFO_6ADDR(ipaddr);
@@ -257,7 +265,7 @@ free_uip_ds6_nbr(uip_ds6_nbr_t *nbr)
     return;
   }
 #if UIP_CONF_IPV6_QUEUE_PKT
-  uip_packetqueue_free(&nbr->packethandle);
+  uip_packetqueue_free_all(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
   NETSTACK_ROUTING.neighbor_state_changed(nbr);
   assert(nbr->nbr_entry != NULL);
@@ -303,7 +311,7 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
 #else /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
   if(nbr != NULL) {
 #if UIP_CONF_IPV6_QUEUE_PKT
-    uip_packetqueue_free(&nbr->packethandle);
+    uip_packetqueue_free_all(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
     NETSTACK_ROUTING.neighbor_state_changed(nbr);
     return nbr_table_remove(ds6_neighbors, nbr);
@@ -364,6 +372,10 @@ uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
   }
 
   memcpy(&nbr_backup, *nbr_pp, sizeof(uip_ds6_nbr_t));
+#if UIP_CONF_IPV6_QUEUE_PKT
+  /* Keep the queued packets across the removal of the entry */
+  uip_packetqueue_move(&(*nbr_pp)->packethandle, &nbr_backup.packethandle);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
   if(uip_ds6_nbr_rm(*nbr_pp) == 0) {
     LOG_ERR("%s: input nbr cannot be removed\n", __func__);
     return -1;
@@ -373,9 +385,18 @@ uip_ds6_nbr_update_ll(uip_ds6_nbr_t **nbr_pp, const uip_lladdr_t *new_ll_addr)
                                 nbr_backup.isrouter, nbr_backup.state,
                                 NBR_TABLE_REASON_IPV6_ND, NULL)) == NULL) {
     LOG_ERR("%s: cannot allocate a new nbr for new_ll_addr\n", __func__);
+#if UIP_CONF_IPV6_QUEUE_PKT
+    uip_packetqueue_free_all(&nbr_backup.packethandle);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
     return -1;
   }
   memcpy(*nbr_pp, &nbr_backup, sizeof(uip_ds6_nbr_t));
+#if UIP_CONF_IPV6_QUEUE_PKT
+  uip_packetqueue_move(&nbr_backup.packethandle, &(*nbr_pp)->packethandle);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+#if UIP_ND6_SEND_NS
+  uip_ds6_nbr_schedule(*nbr_pp);
+#endif /* UIP_ND6_SEND_NS */
 #endif /* UIP_DS6_NBR_MULTI_IPV6_ADDRS */
 
   return 0;
@@ -523,6 +544,9 @@ update_nbr_reachable_state_by_ack(uip_ds6_nbr_t *nbr, const linkaddr_t *lladdr)
   if(nbr != NULL && nbr->state != NBR_INCOMPLETE) {
     nbr->state = NBR_REACHABLE;
     stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
+#if UIP_ND6_SEND_NS
+    uip_ds6_nbr_schedule(nbr);
+#endif /* UIP_ND6_SEND_NS */
     LOG_INFO("received a link layer ACK : ");
     LOG_INFO_LLADDR(lladdr);
     LOG_INFO_(" is reachable.\n");
@@ -577,12 +601,70 @@ uip_ds6_link_callback(int status, int numtx)
 }
 #if UIP_ND6_SEND_NS
 /*---------------------------------------------------------------------------*/
+/* Sets deadline to the time, in clock_seconds(), at which the state timer
+ * of nbr expires. Returns 0 if no timer runs in the current state. */
+static int
+nbr_deadline(const uip_ds6_nbr_t *nbr, unsigned long *deadline)
+{
+  switch(nbr->state) {
+  case NBR_REACHABLE:
+  case NBR_DELAY:
+    *deadline = nbr->reachable.start + nbr->reachable.interval;
+    return 1;
+  case NBR_INCOMPLETE:
+    if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
+      /* Due for removal */
+      *deadline = nbr->sendns.start;
+    } else {
+      *deadline = nbr->sendns.start + nbr->sendns.interval;
+    }
+    return 1;
+  case NBR_PROBE:
+    if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
+      *deadline = nbr->sendns.start;
+    } else {
+      *deadline = nbr->sendns.start + nbr->sendns.interval;
+    }
+    return 1;
+  default:
+    return 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_nbr_schedule(const uip_ds6_nbr_t *nbr)
+{
+  unsigned long deadline;
+
+  if(nbr != NULL && nbr_deadline(nbr, &deadline)) {
+    if(!nbr_event_pending || (long)(deadline - next_nbr_event) < 0) {
+      next_nbr_event = deadline;
+      nbr_event_pending = 1;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 /** Periodic processing on neighbors */
 void
 uip_ds6_neighbor_periodic(void)
 {
-  uip_ds6_nbr_t *nbr = uip_ds6_nbr_head();
-  while(nbr != NULL) {
+  uip_ds6_nbr_t *nbr;
+  uip_ds6_nbr_t *next;
+  uint8_t removed;
+
+  if(!nbr_event_pending || (long)(clock_seconds() - next_nbr_event) < 0) {
+    /* No neighbor state timer can have expired */
+    uip_nd6_stats.nbr_scans_skipped++;
+    return;
+  }
+  uip_nd6_stats.nbr_scans++;
+
+  /* Collect the next deadline while walking the cache */
+  nbr_event_pending = 0;
+  for(nbr = uip_ds6_nbr_head(); nbr != NULL; nbr = next) {
+    next = uip_ds6_nbr_next(nbr);
+    removed = 0;
+    uip_nd6_stats.nbr_visited++;
     switch(nbr->state) {
     case NBR_REACHABLE:
       if(stimer_expired(&nbr->reachable)) {
@@ -617,11 +699,14 @@ uip_ds6_neighbor_periodic(void)
     case NBR_INCOMPLETE:
       if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
         uip_ds6_nbr_rm(nbr);
+        removed = 1;
       } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        LOG_INFO("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+        /* A rate limited NS does not count, it is tried again soon */
+        if(uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr) != 0) {
+          nbr->nscount++;
+          LOG_INFO("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
+          stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+        }
       }
       break;
     case NBR_DELAY:
@@ -642,17 +727,21 @@ uip_ds6_neighbor_periodic(void)
           }
         }
         uip_ds6_nbr_rm(nbr);
+        removed = 1;
       } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        LOG_INFO("PROBE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+        if(uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr) != 0) {
+          nbr->nscount++;
+          LOG_INFO("PROBE: NS %u\n", nbr->nscount);
+          stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+        }
       }
       break;
     default:
       break;
     }
-    nbr = uip_ds6_nbr_next(nbr);
+    if(!removed) {
+      uip_ds6_nbr_schedule(nbr);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -665,6 +754,7 @@ uip_ds6_nbr_refresh_reachable_state(const uip_ipaddr_t *ipaddr)
     nbr->state = NBR_REACHABLE;
     nbr->nscount = 0;
     stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
+    uip_ds6_nbr_schedule(nbr);
   }
 }
 /*---------------------------------------------------------------------------*/
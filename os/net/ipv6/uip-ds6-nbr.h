@@ -232,10 +232,23 @@ uip_ds6_nbr_t *uip_ds6_nbr_next(uip_ds6_nbr_t *nbr);
 void uip_ds6_link_callback(int status, int numtx);
 
 /**
- * The housekeeping function called periodically
+ * The housekeeping function called periodically. The neighbor cache is
+ * only scanned once the earliest state timer recorded with
+ * uip_ds6_nbr_schedule() has expired.
  */
 void uip_ds6_neighbor_periodic(void);
 
+#if UIP_ND6_SEND_NS
+/**
+ * Make the periodic processing take the state timers of a neighbor cache
+ * into account. Must be called whenever the state of a neighbor cache is
+ * changed to one with a running timer (REACHABLE, DELAY, INCOMPLETE,
+ * PROBE) or such a timer is restarted from outside of uip-ds6-nbr.
+ * \param nbr the neighbor cache whose timers were set
+ */
+void uip_ds6_nbr_schedule(const uip_ds6_nbr_t *nbr);
+#endif /* UIP_ND6_SEND_NS */
+
 #if UIP_ND6_SEND_NS
 /**
  * \brief Refresh the reachable state of a neighbor. This function
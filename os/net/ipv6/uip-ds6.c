@@ -355,6 +355,19 @@ uip_ds6_is_addr_onlink(uip_ipaddr_t *ipaddr)
   return 0;
 }
 
+/*---------------------------------------------------------------------------*/
+#if UIP_ND6_DEF_MAXDADNS > 0 && UIP_ND6_SKIP_DAD_FOR_DERIVED
+/* Is the interface identifier of ipaddr the one derived from our
+ * link-layer address? */
+static int
+is_iid_from_lladdr(const uip_ipaddr_t *ipaddr)
+{
+  uip_ipaddr_t derived;
+
+  uip_ds6_set_addr_iid(&derived, &uip_lladdr);
+  return memcmp(&derived.u8[8], &ipaddr->u8[8], 8) == 0;
+}
+#endif /* UIP_ND6_DEF_MAXDADNS > 0 && UIP_ND6_SKIP_DAD_FOR_DERIVED */
 /*---------------------------------------------------------------------------*/
 uip_ds6_addr_t *
 uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
@@ -373,11 +386,19 @@ uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
       stimer_set(&(locaddr->vlifetime), vlifetime);
     }
 #if UIP_ND6_DEF_MAXDADNS > 0
-    locaddr->state = ADDR_TENTATIVE;
-    timer_set(&locaddr->dadtimer,
-              random_rand() % (UIP_ND6_MAX_RTR_SOLICITATION_DELAY *
-                               CLOCK_SECOND));
-    locaddr->dadnscount = 0;
+#if UIP_ND6_SKIP_DAD_FOR_DERIVED
+    if(is_iid_from_lladdr(ipaddr)) {
+      /* Unique by construction, usable at once */
+      locaddr->state = ADDR_PREFERRED;
+    } else
+#endif /* UIP_ND6_SKIP_DAD_FOR_DERIVED */
+    {
+      locaddr->state = ADDR_TENTATIVE;
+      timer_set(&locaddr->dadtimer,
+                random_rand() % (UIP_ND6_MAX_RTR_SOLICITATION_DELAY *
+                                 CLOCK_SECOND));
+      locaddr->dadnscount = 0;
+    }
 #else /* UIP_ND6_DEF_MAXDADNS > 0 */
     locaddr->state = ADDR_PREFERRED;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
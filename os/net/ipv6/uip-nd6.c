@@ -119,6 +119,17 @@ static uip_ipaddr_t ipaddr;
 static uip_ds6_prefix_t *prefix; /**  Pointer to a prefix list entry */
 #endif
 
+struct uip_nd6_stats uip_nd6_stats;
+
+#if UIP_ND6_SEND_NS && UIP_ND6_NS_RATE_LIMIT_TARGETS > 0
+/* Targets of the most recent NS, for per-target rate limiting */
+static struct {
+  uip_ipaddr_t target;
+  clock_time_t sent;
+  uint8_t used;
+} ns_targets[UIP_ND6_NS_RATE_LIMIT_TARGETS];
+#endif /* UIP_ND6_SEND_NS && UIP_ND6_NS_RATE_LIMIT_TARGETS > 0 */
+
 #if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
 /*------------------------------------------------------------------*/
 /* Copy link-layer address from LLAO option to a word-aligned uip_lladdr_t */
@@ -355,10 +366,55 @@ discard:
 
 /*------------------------------------------------------------------*/
 #if UIP_ND6_SEND_NS
-void
+/* Returns 0 if a NS for tgt was sent less than UIP_ND6_NS_MIN_INTERVAL ago,
+ * otherwise records the NS and returns 1 */
+static int
+ns_rate_limit_check(const uip_ipaddr_t *tgt)
+{
+#if UIP_ND6_NS_RATE_LIMIT_TARGETS > 0
+  clock_time_t now = clock_time();
+  int oldest = 0;
+  int i;
+
+  for(i = 0; i < UIP_ND6_NS_RATE_LIMIT_TARGETS; i++) {
+    if(!ns_targets[i].used) {
+      oldest = i;
+      continue;
+    }
+    if(uip_ipaddr_cmp(&ns_targets[i].target, tgt)) {
+      if(now - ns_targets[i].sent < UIP_ND6_NS_MIN_INTERVAL) {
+        return 0;
+      }
+      ns_targets[i].sent = now;
+      return 1;
+    }
+    if(ns_targets[oldest].used &&
+       (clock_time_t)(now - ns_targets[i].sent) >
+       (clock_time_t)(now - ns_targets[oldest].sent)) {
+      oldest = i;
+    }
+  }
+
+  /* Not solicited recently: take over the least recently used slot */
+  uip_ipaddr_copy(&ns_targets[oldest].target, tgt);
+  ns_targets[oldest].sent = now;
+  ns_targets[oldest].used = 1;
+#endif /* UIP_ND6_NS_RATE_LIMIT_TARGETS > 0 */
+  return 1;
+}
+/*------------------------------------------------------------------*/
+int
 uip_nd6_ns_output(uip_ipaddr_t * src, uip_ipaddr_t * dest, uip_ipaddr_t * tgt)
 {
   uipbuf_clear();
+  /* DAD (our own target) follows its own schedule, see uip_ds6_dad() */
+  if(!uip_ds6_is_my_addr(tgt) && !ns_rate_limit_check(tgt)) {
+    uip_nd6_stats.ns_rate_limited++;
+    LOG_INFO("NS for ");
+    LOG_INFO_6ADDR(tgt);
+    LOG_INFO_(" rate limited\n");
+    return 0;
+  }
   UIP_IP_BUF->vtc = 0x60;
   UIP_IP_BUF->tcflow = 0;
   UIP_IP_BUF->flow = 0;
@@ -387,7 +443,7 @@ uip_nd6_ns_output(uip_ipaddr_t * src, uip_ipaddr_t * dest, uip_ipaddr_t * tgt)
     if (uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
       LOG_ERR("Dropping NS due to no suitable source address\n");
       uipbuf_clear();
-      return;
+      return -1;
     }
     uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + UIP_ND6_NS_LEN + UIP_ND6_OPT_LLAO_LEN);
 
@@ -406,6 +462,7 @@ uip_nd6_ns_output(uip_ipaddr_t * src, uip_ipaddr_t * dest, uip_ipaddr_t * tgt)
   UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
 
   UIP_STAT(++uip_stat.nd6.sent);
+  uip_nd6_stats.ns_sent++;
   LOG_INFO("Sending NS to ");
   LOG_INFO_6ADDR(&UIP_IP_BUF->destipaddr);
   LOG_INFO_(" from ");
@@ -413,7 +470,7 @@ uip_nd6_ns_output(uip_ipaddr_t * src, uip_ipaddr_t * dest, uip_ipaddr_t * tgt)
   LOG_INFO_(" with target address ");
   LOG_INFO_6ADDR(tgt);
   LOG_INFO_("\n");
-  return;
+  return 1;
 }
 #endif /* UIP_ND6_SEND_NS */
 
@@ -582,6 +639,7 @@ na_input(void)
     nbr->queue_buf_len = 0;
     return;
     }*/
+  /* Send the oldest one here; tcpip_ipv6_output() flushes the rest */
   if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
     uip_len = uip_packetqueue_buflen(&nbr->packethandle);
     memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
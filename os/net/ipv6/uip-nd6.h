@@ -147,6 +147,15 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_DEF_MAXDADNS UIP_CONF_ND6_DEF_MAXDADNS
 #endif /* UIP_CONF_ND6_DEF_MAXDADNS */
 
+/** \brief When DAD is used, skip it for addresses whose interface
+ * identifier is derived from our own link-layer address: these are unique
+ * as long as the link-layer address is (RFC 6775, section 4) */
+#ifdef UIP_ND6_CONF_SKIP_DAD_FOR_DERIVED
+#define UIP_ND6_SKIP_DAD_FOR_DERIVED UIP_ND6_CONF_SKIP_DAD_FOR_DERIVED
+#else
+#define UIP_ND6_SKIP_DAD_FOR_DERIVED 0
+#endif
+
 /** \name RFC 4861 Node constant */
 #define UIP_ND6_MAX_MULTICAST_SOLICIT  3
 
@@ -168,6 +177,23 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_RETRANS_TIMER          1000
 #endif
 
+/** \brief Minimum interval, in clock ticks, between two NS for the same
+ * target. Solicitations issued faster than this are aggregated into the
+ * NS already in flight (RFC 4861, 7.2.2) */
+#ifdef UIP_CONF_ND6_NS_MIN_INTERVAL
+#define UIP_ND6_NS_MIN_INTERVAL        UIP_CONF_ND6_NS_MIN_INTERVAL
+#else
+#define UIP_ND6_NS_MIN_INTERVAL        (CLOCK_SECOND / 2)
+#endif
+
+/** \brief Number of recently solicited targets remembered for NS rate
+ * limiting. 0 disables rate limiting */
+#ifdef UIP_CONF_ND6_NS_RATE_LIMIT_TARGETS
+#define UIP_ND6_NS_RATE_LIMIT_TARGETS  UIP_CONF_ND6_NS_RATE_LIMIT_TARGETS
+#else
+#define UIP_ND6_NS_RATE_LIMIT_TARGETS  4
+#endif
+
 #define UIP_ND6_DELAY_FIRST_PROBE_TIME 5
 #define UIP_ND6_MIN_RANDOM_FACTOR(x)   (x / 2)
 #define UIP_ND6_MAX_RANDOM_FACTOR(x)   ((x) + (x) / 2)
@@ -386,8 +412,14 @@ typedef struct uip_nd6_opt_redirected_hdr {
  *
  * - we check if it is a NS for Address resolution  or NUD, if yes we include
  *   a SLLAO option, otherwise no.
+ *
+ * - NS for address resolution and NUD are rate limited per target, see
+ *   UIP_ND6_NS_MIN_INTERVAL. NS for DAD are not.
+ *
+ * \return 1 if the NS was sent, 0 if it was held back by rate limiting and
+ * should be tried again later, -1 if it could not be sent
  */
-void
+int
 uip_nd6_ns_output(uip_ipaddr_t *src, uip_ipaddr_t *dest, uip_ipaddr_t *tgt);
 
 #if UIP_CONF_ROUTER
@@ -420,6 +452,19 @@ void uip_nd6_rs_output(void);
 void uip_nd6_init(void);
 /** @} */
 
+/** \brief Neighbor discovery statistics */
+struct uip_nd6_stats {
+  uint32_t ns_sent;           /**< NS built for transmission */
+  uint32_t ns_rate_limited;   /**< NS suppressed by the per-target limit */
+  uint32_t nbr_scans;         /**< Periodic neighbor cache scans */
+  uint32_t nbr_scans_skipped; /**< Periods with no neighbor timer due */
+  uint32_t nbr_visited;       /**< Entries visited by the periodic scans */
+};
+
+/** \brief Neighbor discovery statistics, updated by uip-nd6 and the
+ * neighbor cache */
+extern struct uip_nd6_stats uip_nd6_stats;
+
 
 void
 uip_appserver_addr_get(uip_ipaddr_t *ipaddr);
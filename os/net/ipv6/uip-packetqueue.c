@@ -2,13 +2,32 @@
 
 #include "net/ipv6/uip.h"
 
+#include "lib/list.h"
 #include "lib/memb.h"
 
 #include "net/ipv6/uip-packetqueue.h"
 
+/* Number of packets shared by all queues */
+#ifdef UIP_PACKETQUEUE_CONF_NUM_PACKETS
+#define MAX_NUM_QUEUED_PACKETS UIP_PACKETQUEUE_CONF_NUM_PACKETS
+#else
 #define MAX_NUM_QUEUED_PACKETS 2
+#endif
+
+/* Maximum number of packets a single queue may hold */
+#ifdef UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#define MAX_PACKETS_PER_HANDLE UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#else
+#define MAX_PACKETS_PER_HANDLE MAX_NUM_QUEUED_PACKETS
+#endif
+
 MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 
+/* All queued packets, oldest first */
+LIST(packets_list);
+
+static struct uip_packetqueue_stats stats;
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -17,70 +36,161 @@ MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 #define PRINTF(...)
 #endif
 
+/*---------------------------------------------------------------------------*/
+static struct uip_packetqueue_packet *
+head(struct uip_packetqueue_handle *handle)
+{
+  struct uip_packetqueue_packet *p;
+
+  if(handle->count == 0) {
+    return NULL;
+  }
+  for(p = list_head(packets_list); p != NULL; p = list_item_next(p)) {
+    if(p->handle == handle) {
+      return p;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_free(struct uip_packetqueue_packet *p)
+{
+  ctimer_stop(&p->lifetimer);
+  list_remove(packets_list, p);
+  p->handle->count--;
+  memb_free(&packets_memb, p);
+}
 /*---------------------------------------------------------------------------*/
 static void
 packet_timedout(void *ptr)
 {
-  struct uip_packetqueue_handle *h = ptr;
+  struct uip_packetqueue_packet *p = ptr;
 
-  PRINTF("uip_packetqueue_free timed out %p\n", h);
-  memb_free(&packets_memb, h->packet);
-  h->packet = NULL;
+  PRINTF("uip_packetqueue_free timed out %p\n", p->handle);
+  stats.timed_out++;
+  packet_free(p);
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_new(struct uip_packetqueue_handle *handle)
 {
   PRINTF("uip_packetqueue_new %p\n", handle);
-  handle->packet = NULL;
+  handle->count = 0;
 }
 /*---------------------------------------------------------------------------*/
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime)
 {
+  struct uip_packetqueue_packet *p;
+
   PRINTF("uip_packetqueue_alloc %p\n", handle);
-  if(handle->packet != NULL) {
-    PRINTF("alloced\n");
-    return NULL;
+  if(handle->count >= MAX_PACKETS_PER_HANDLE) {
+    p = head(handle);
+    if(p != NULL) {
+      /* Make room by dropping the oldest packet of this queue */
+      PRINTF("queue full, dropping oldest\n");
+      stats.dropped++;
+      packet_free(p);
+    }
   }
-  handle->packet = memb_alloc(&packets_memb);
-  if(handle->packet != NULL) {
-    ctimer_set(&handle->packet->lifetimer, lifetime,
-               packet_timedout, handle);
-  } else {
-    PRINTF("uip_packetqueue_alloc failed\n");
+
+  p = memb_alloc(&packets_memb);
+  if(p == NULL) {
+    /* Pool exhausted: evict the oldest packet of any queue */
+    p = list_head(packets_list);
+    if(p == NULL) {
+      PRINTF("uip_packetqueue_alloc failed\n");
+      return NULL;
+    }
+    PRINTF("pool full, evicting oldest from %p\n", p->handle);
+    stats.evicted++;
+    packet_free(p);
+    p = memb_alloc(&packets_memb);
+    if(p == NULL) {
+      return NULL;
+    }
   }
-  return handle->packet;
+
+  p->handle = handle;
+  p->queue_buf_len = 0;
+  ctimer_set(&p->lifetimer, lifetime, packet_timedout, p);
+  list_add(packets_list, p);
+  handle->count++;
+  stats.queued++;
+  return p;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle)
 {
+  struct uip_packetqueue_packet *p;
+
   PRINTF("uip_packetqueue_free %p\n", handle);
-  if(handle->packet != NULL) {
-    ctimer_stop(&handle->packet->lifetimer);
-    memb_free(&packets_memb, handle->packet);
-    handle->packet = NULL;
+  p = head(handle);
+  if(p != NULL) {
+    stats.sent++;
+    packet_free(p);
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+uip_packetqueue_free_all(struct uip_packetqueue_handle *handle)
+{
+  struct uip_packetqueue_packet *p;
+
+  PRINTF("uip_packetqueue_free_all %p\n", handle);
+  while((p = head(handle)) != NULL) {
+    stats.flushed++;
+    packet_free(p);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_packetqueue_move(struct uip_packetqueue_handle *from,
+                     struct uip_packetqueue_handle *to)
+{
+  struct uip_packetqueue_packet *p;
+
+  PRINTF("uip_packetqueue_move %p -> %p\n", from, to);
+  for(p = list_head(packets_list); p != NULL; p = list_item_next(p)) {
+    if(p->handle == from) {
+      p->handle = to;
+    }
+  }
+  to->count = from->count;
+  from->count = 0;
+}
+/*---------------------------------------------------------------------------*/
 uint8_t *
 uip_packetqueue_buf(struct uip_packetqueue_handle *h)
 {
-  return h->packet != NULL? h->packet->queue_buf: NULL;
+  struct uip_packetqueue_packet *p = head(h);
+
+  return p != NULL ? p->queue_buf : NULL;
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
 uip_packetqueue_buflen(struct uip_packetqueue_handle *h)
 {
-  return h->packet != NULL? h->packet->queue_buf_len: 0;
+  struct uip_packetqueue_packet *p = head(h);
+
+  return p != NULL ? p->queue_buf_len : 0;
 }
 /*---------------------------------------------------------------------------*/
 void
 uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len)
 {
-  if(h->packet != NULL) {
-    h->packet->queue_buf_len = len;
+  struct uip_packetqueue_packet *p = head(h);
+
+  if(p != NULL) {
+    p->queue_buf_len = len;
   }
 }
 /*---------------------------------------------------------------------------*/
+const struct uip_packetqueue_stats *
+uip_packetqueue_get_stats(void)
+{
+  return &stats;
+}
+/*---------------------------------------------------------------------------*/
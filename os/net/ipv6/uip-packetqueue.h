@@ -6,30 +6,56 @@
 struct uip_packetqueue_handle;
 
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
+  struct uip_packetqueue_packet *next;
   uint8_t queue_buf[UIP_BUFSIZE];
   uint16_t queue_buf_len;
   struct ctimer lifetimer;
   struct uip_packetqueue_handle *handle;
 };
 
+/*
+ * All handles share one pool of packets. The packets of a handle are
+ * kept in arrival order; the oldest one is at the head of the queue.
+ */
 struct uip_packetqueue_handle {
-  struct uip_packetqueue_packet *packet;
+  uint8_t count;
 };
 
-void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
+/* Packet queue statistics, all counters wrap around */
+struct uip_packetqueue_stats {
+  uint32_t queued;    /* Packets added to a queue */
+  uint32_t sent;      /* Packets removed from the head of a queue */
+  uint32_t dropped;   /* Oldest packet dropped because its queue was full */
+  uint32_t evicted;   /* Oldest packet evicted because the pool was full */
+  uint32_t timed_out; /* Packets whose lifetime expired */
+  uint32_t flushed;   /* Packets dropped when their handle was flushed */
+};
 
+void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
 
+/* Appends a packet to the tail of the queue. The caller copies the packet
+   into queue_buf and sets queue_buf_len of the returned packet. */
 struct uip_packetqueue_packet *
 uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
 
-
+/* Removes the packet at the head of the queue */
 void
 uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
+/* Removes all packets of the queue */
+void
+uip_packetqueue_free_all(struct uip_packetqueue_handle *handle);
+
+/* Hands all packets of a queue over to another, empty, handle */
+void
+uip_packetqueue_move(struct uip_packetqueue_handle *from,
+                     struct uip_packetqueue_handle *to);
+
+/* Accessors for the packet at the head of the queue */
 uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
 uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
 void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
 
+const struct uip_packetqueue_stats *uip_packetqueue_get_stats(void);
 
 #endif /* UIP_PACKETQUEUE_H */
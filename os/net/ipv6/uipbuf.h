@@ -186,6 +186,14 @@ void uipbuf_init(void);
 #define UIPBUF_ATTR_FLAGS_6LOWPAN_NO_NHC_COMPRESSION      0x01
 /* Avoid using prefix compression on the packet (6LoWPAN) */
 #define UIPBUF_ATTR_FLAGS_6LOWPAN_NO_PREFIX_COMPRESSION   0x02
+/* The packet is a virtual copy of a datagram forwarded fragment by
+   fragment: only its first fragment is present, it must not be buffered
+   (6LoWPAN) */
+#define UIPBUF_ATTR_FLAGS_6LOWPAN_FRAG_FORWARD            0x04
+/* The packet was reassembled after a fragment forwarding decision could
+   not forward it: uIP already processed it once, so per-flow state must
+   not be updated again (6LoWPAN) */
+#define UIPBUF_ATTR_FLAGS_6LOWPAN_FRAG_PROBED             0x08
 
 /* MAC will set the default for this packet */
 #define UIPBUF_ATTR_LLSEC_LEVEL_MAC_DEFAULT               0xffff
@@ -201,6 +209,7 @@ enum {
   UIPBUF_ATTR_PHYSICAL_NETWORK_ID, /**< Physical network ID (mapped to PAN ID)*/
   UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS, /**< MAX transmissions of the packet MAC */
   UIPBUF_ATTR_FLAGS,   /**< Flags that can control lower layers.  see above. */
+  UIPBUF_ATTR_PRIORITY, /**< MAC queueing priority (PACKETBUF_ATTR_PRIORITY_*) */
   UIPBUF_ATTR_MAX
 };
 
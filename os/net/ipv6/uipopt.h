@@ -505,6 +505,14 @@ void uip_log(char *msg);
  */
 #define UIP_TC_MAC_TRANSMISSION_COUNTER_MASK 0x3F
 
+/**
+ * The "Traffic Class" of high-priority packets (UIPBUF_ATTR_PRIORITY set to
+ * PACKETBUF_ATTR_PRIORITY_HIGH): DSCP Expedited Forwarding. Forwarders queue
+ * packets with a DSCP from UIP_TC_DSCP_HIGH_MIN up as high-priority
+ */
+#define UIP_TC_DSCP_EF       0xb8
+#define UIP_TC_DSCP_HIGH_MIN 40
+
 #ifdef UIP_CONF_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS
 #define UIP_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS UIP_CONF_TAG_TC_WITH_VARIABLE_RETRANSMISSIONS
 #else
@@ -66,6 +66,12 @@
 /* Initial ETX value */
 #define ETX_DEFAULT                      2
 
+/* Guessing the ETX from the RSSI */
+#define ETX_INIT_MAX                     3
+#define RSSI_HIGH                      -60
+#define RSSI_LOW                       -90
+#define RSSI_DIFF                      (RSSI_HIGH - RSSI_LOW)
+
 /* Per-neighbor link statistics table */
 NBR_TABLE(struct link_stats, link_stats);
 
@@ -96,7 +102,7 @@ link_stats_is_fresh(const struct link_stats *stats)
       && stats->freshness >= FRESHNESS_TARGET;
 }
 /*---------------------------------------------------------------------------*/
-#if LINK_STATS_INIT_ETX_FROM_RSSI
+#if LINK_STATS_INIT_ETX_FROM_RSSI || LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_4BIT
 uint16_t
 guess_etx_from_rssi(const struct link_stats *stats)
 {
@@ -111,10 +117,6 @@ guess_etx_from_rssi(const struct link_stats *stats)
        * etx = ETX_DIVOSOR / ((bounded_rssi - RSSI_LOW) / RSSI_DIFF)
        * etx = (RSSI_DIFF * ETX_DIVOSOR) / (bounded_rssi - RSSI_LOW)
        * */
-#define ETX_INIT_MAX 3
-#define RSSI_HIGH -60
-#define RSSI_LOW  -90
-#define RSSI_DIFF (RSSI_HIGH - RSSI_LOW)
       uint16_t etx;
       int16_t bounded_rssi = stats->rssi;
       bounded_rssi = MIN(bounded_rssi, RSSI_HIGH);
@@ -125,17 +127,191 @@ guess_etx_from_rssi(const struct link_stats *stats)
   }
   return 0xffff;
 }
+#endif /* LINK_STATS_INIT_ETX_FROM_RSSI || LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_4BIT */
+/*---------------------------------------------------------------------------*/
+/* Initial ETX of a new link, common to all estimators */
+static void
+init_etx(struct link_stats *stats)
+{
+#if LINK_STATS_INIT_ETX_FROM_RSSI
+  stats->etx = guess_etx_from_rssi(stats);
+#else /* LINK_STATS_INIT_ETX_FROM_RSSI */
+  stats->etx = ETX_DEFAULT * ETX_DIVISOR;
 #endif /* LINK_STATS_INIT_ETX_FROM_RSSI */
+}
+/*---------------------------------------------------------------------------*/
+#if LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_EWMA \
+  || LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_4BIT
+/* Update an ETX with a new sample, using an EWMA. The EWMA moves faster
+ * while the link statistics are not fresh yet. */
+static uint16_t
+ewma_etx(const struct link_stats *stats, uint16_t sample_etx)
+{
+  uint8_t ewma_alpha;
+
+  ewma_alpha = link_stats_is_fresh(stats) ? EWMA_ALPHA : EWMA_BOOTSTRAP_ALPHA;
+  return ((uint32_t)stats->etx * (EWMA_SCALE - ewma_alpha) +
+          (uint32_t)sample_etx * ewma_alpha) / EWMA_SCALE;
+}
+#endif /* LINK_STATS_ESTIMATOR */
+/*---------------------------------------------------------------------------*/
+/* Estimators */
+/*---------------------------------------------------------------------------*/
+#if LINK_STATS_ESTIMATOR != LINK_STATS_ESTIMATOR_4BIT
+static void
+no_packet_received(struct link_stats *stats, int16_t rssi)
+{
+}
+#endif /* LINK_STATS_ESTIMATOR != LINK_STATS_ESTIMATOR_4BIT */
+/*---------------------------------------------------------------------------*/
+#if LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_EWMA
+/* EWMA of the Tx count of every packet */
+static void
+ewma_packet_sent(struct link_stats *stats, int status, int numtx)
+{
+  stats->etx = ewma_etx(stats, numtx * ETX_DIVISOR);
+}
+static const struct link_stats_estimator estimator = {
+  "ewma", init_etx, ewma_packet_sent, no_packet_received
+};
+/*---------------------------------------------------------------------------*/
+#elif LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_PACKET_COUNT
+/* Tx count over ACK count, both halved after TX_COUNT_MAX transmissions */
+static void
+packet_count_packet_sent(struct link_stats *stats, int status, int numtx)
+{
+  /* Halve both counter after TX_COUNT_MAX */
+  if(stats->tx_count + numtx > TX_COUNT_MAX) {
+    stats->tx_count /= 2;
+    stats->ack_count /= 2;
+  }
+  /* Update tx_count and ack_count */
+  stats->tx_count += numtx;
+  if(status == MAC_TX_OK) {
+    stats->ack_count++;
+  }
+  /* Compute ETX */
+  if(stats->ack_count > 0) {
+    stats->etx = ((uint16_t)stats->tx_count * ETX_DIVISOR) / stats->ack_count;
+  } else {
+    stats->etx = (uint16_t)MAX(ETX_NOACK_PENALTY, stats->tx_count) * ETX_DIVISOR;
+  }
+}
+static const struct link_stats_estimator estimator = {
+  "packet-count", init_etx, packet_count_packet_sent, no_packet_received
+};
+/*---------------------------------------------------------------------------*/
+#elif LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_WINDOW
+/* Mean Tx count of the last LINK_STATS_WINDOW_SIZE packets. Reacts to
+ * changes within a window, and forgets older packets entirely. */
+static void
+window_packet_sent(struct link_stats *stats, int status, int numtx)
+{
+  uint16_t sum;
+  uint8_t i;
+
+  stats->window[stats->window_pos] = MIN(numtx, 0xff);
+  stats->window_pos = (stats->window_pos + 1) % LINK_STATS_WINDOW_SIZE;
+  if(stats->window_len < LINK_STATS_WINDOW_SIZE) {
+    stats->window_len++;
+  }
+
+  sum = 0;
+  for(i = 0; i < stats->window_len; i++) {
+    sum += stats->window[i];
+  }
+  stats->etx = ((uint32_t)sum * ETX_DIVISOR) / stats->window_len;
+}
+static const struct link_stats_estimator estimator = {
+  "window", init_etx, window_packet_sent, no_packet_received
+};
+/*---------------------------------------------------------------------------*/
+#elif LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_4BIT
+/* In the spirit of the four-bit estimator: the ACK-based ETX is sampled
+ * every LINK_STATS_4BIT_WINDOW transmissions and fed to an EWMA, which
+ * is robust to single losses. The PHY provides a hint while the link is
+ * being bootstrapped: receptions at a strong RSSI cap the ETX to the one
+ * guessed from the RSSI, so that good links are usable before enough
+ * transmissions were made. */
+static void
+fourbit_packet_sent(struct link_stats *stats, int status, int numtx)
+{
+  uint16_t window_etx;
+
+  stats->tx_count = MIN(stats->tx_count + numtx, 0xff);
+  if(status == MAC_TX_OK) {
+    stats->ack_count++;
+  }
+  if(stats->tx_count < LINK_STATS_4BIT_WINDOW) {
+    return;
+  }
+
+  /* A window is complete, take a sample */
+  if(stats->ack_count > 0) {
+    window_etx = MIN(((uint32_t)stats->tx_count * ETX_DIVISOR) / stats->ack_count, 0xffff);
+  } else {
+    window_etx = (uint16_t)MAX(ETX_NOACK_PENALTY, stats->tx_count) * ETX_DIVISOR;
+  }
+  stats->etx = ewma_etx(stats, window_etx);
+  stats->tx_count = 0;
+  stats->ack_count = 0;
+}
+static void
+fourbit_packet_received(struct link_stats *stats, int16_t rssi)
+{
+  uint16_t guess;
+
+  if(!link_stats_is_fresh(stats) && rssi >= RSSI_HIGH) {
+    guess = guess_etx_from_rssi(stats);
+    stats->etx = MIN(stats->etx, guess);
+  }
+}
+static const struct link_stats_estimator estimator = {
+  "4bit", init_etx, fourbit_packet_sent, fourbit_packet_received
+};
+#else
+#error "Unknown LINK_STATS_ESTIMATOR"
+#endif /* LINK_STATS_ESTIMATOR */
+/*---------------------------------------------------------------------------*/
+const char *
+link_stats_estimator_name(void)
+{
+  return estimator.name;
+}
+/*---------------------------------------------------------------------------*/
+/* Is the link new, and in need of probing at a short interval? */
+int
+link_stats_in_probe_burst(const struct link_stats *stats)
+{
+#if LINK_STATS_PROBE_BURST
+  return stats != NULL && stats->probe_burst > 0;
+#else /* LINK_STATS_PROBE_BURST */
+  return 0;
+#endif /* LINK_STATS_PROBE_BURST */
+}
+/*---------------------------------------------------------------------------*/
+/* Adds a link, with an initial ETX */
+static struct link_stats *
+add_link(const linkaddr_t *lladdr, int16_t rssi)
+{
+  struct link_stats *stats;
+
+  stats = nbr_table_add_lladdr(link_stats, lladdr, NBR_TABLE_REASON_LINK_STATS, NULL);
+  if(stats != NULL) {
+    stats->rssi = rssi;
+    estimator.init(stats);
+#if LINK_STATS_PROBE_BURST
+    stats->probe_burst = LINK_STATS_PROBE_BURST;
+#endif /* LINK_STATS_PROBE_BURST */
+  }
+  return stats;
+}
 /*---------------------------------------------------------------------------*/
 /* Packet sent callback. Updates stats for transmissions to lladdr */
 void
 link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx)
 {
   struct link_stats *stats;
-#if !LINK_STATS_ETX_FROM_PACKET_COUNT
-  uint16_t packet_etx;
-  uint8_t ewma_alpha;
-#endif /* !LINK_STATS_ETX_FROM_PACKET_COUNT */
 
   if(status != MAC_TX_OK && status != MAC_TX_NOACK) {
     /* Do not penalize the ETX when collisions or transmission errors occur. */
@@ -145,14 +321,8 @@ link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx)
   stats = nbr_table_get_from_lladdr(link_stats, lladdr);
   if(stats == NULL) {
     /* Add the neighbor */
-    stats = nbr_table_add_lladdr(link_stats, lladdr, NBR_TABLE_REASON_LINK_STATS, NULL);
-    if(stats != NULL) {
-#if LINK_STATS_INIT_ETX_FROM_RSSI
-      stats->etx = guess_etx_from_rssi(stats);
-#else /* LINK_STATS_INIT_ETX_FROM_RSSI */
-      stats->etx = ETX_DEFAULT * ETX_DIVISOR;
-#endif /* LINK_STATS_INIT_ETX_FROM_RSSI */
-    } else {
+    stats = add_link(lladdr, 0);
+    if(stats == NULL) {
       return; /* No space left, return */
     }
   }
@@ -161,6 +331,12 @@ link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx)
   stats->last_tx_time = clock_time();
   stats->freshness = MIN(stats->freshness + numtx, FRESHNESS_MAX);
 
+#if LINK_STATS_PROBE_BURST
+  if(stats->probe_burst > 0) {
+    stats->probe_burst--;
+  }
+#endif /* LINK_STATS_PROBE_BURST */
+
 #if LINK_STATS_PACKET_COUNTERS
   /* Update paket counters */
   stats->cnt_current.num_packets_tx += numtx;
@@ -174,36 +350,7 @@ link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx)
     numtx += ETX_NOACK_PENALTY;
   }
 
-#if LINK_STATS_ETX_FROM_PACKET_COUNT
-  /* Compute ETX from packet and ACK count */
-  /* Halve both counter after TX_COUNT_MAX */
-  if(stats->tx_count + numtx > TX_COUNT_MAX) {
-    stats->tx_count /= 2;
-    stats->ack_count /= 2;
-  }
-  /* Update tx_count and ack_count */
-  stats->tx_count += numtx;
-  if(status == MAC_TX_OK) {
-    stats->ack_count++;
-  }
-  /* Compute ETX */
-  if(stats->ack_count > 0) {
-    stats->etx = ((uint16_t)stats->tx_count * ETX_DIVISOR) / stats->ack_count;
-  } else {
-    stats->etx = (uint16_t)MAX(ETX_NOACK_PENALTY, stats->tx_count) * ETX_DIVISOR;
-  }
-#else /* LINK_STATS_ETX_FROM_PACKET_COUNT */
-  /* Compute ETX using an EWMA */
-
-  /* ETX used for this update */
-  packet_etx = numtx * ETX_DIVISOR;
-  /* ETX alpha used for this update */
-  ewma_alpha = link_stats_is_fresh(stats) ? EWMA_ALPHA : EWMA_BOOTSTRAP_ALPHA;
-
-  /* Compute EWMA and update ETX */
-  stats->etx = ((uint32_t)stats->etx * (EWMA_SCALE - ewma_alpha) +
-      (uint32_t)packet_etx * ewma_alpha) / EWMA_SCALE;
-#endif /* LINK_STATS_ETX_FROM_PACKET_COUNT */
+  estimator.packet_sent(stats, status, numtx);
 }
 /*---------------------------------------------------------------------------*/
 /* Packet input callback. Updates statistics for receptions on a given link */
@@ -216,19 +363,12 @@ link_stats_input_callback(const linkaddr_t *lladdr)
   stats = nbr_table_get_from_lladdr(link_stats, lladdr);
   if(stats == NULL) {
     /* Add the neighbor */
-    stats = nbr_table_add_lladdr(link_stats, lladdr, NBR_TABLE_REASON_LINK_STATS, NULL);
-    if(stats != NULL) {
-      /* Initialize */
-      stats->rssi = packet_rssi;
-#if LINK_STATS_INIT_ETX_FROM_RSSI
-      stats->etx = guess_etx_from_rssi(stats);
-#else /* LINK_STATS_INIT_ETX_FROM_RSSI */
-      stats->etx = ETX_DEFAULT * ETX_DIVISOR;
-#endif /* LINK_STATS_INIT_ETX_FROM_RSSI */
+    stats = add_link(lladdr, packet_rssi);
 #if LINK_STATS_PACKET_COUNTERS
+    if(stats != NULL) {
       stats->cnt_current.num_packets_rx = 1;
-#endif
     }
+#endif
     return;
   }
 
@@ -236,6 +376,8 @@ link_stats_input_callback(const linkaddr_t *lladdr)
   stats->rssi = ((int32_t)stats->rssi * (EWMA_SCALE - EWMA_ALPHA) +
       (int32_t)packet_rssi * EWMA_ALPHA) / EWMA_SCALE;
 
+  estimator.packet_received(stats, packet_rssi);
+
 #if LINK_STATS_PACKET_COUNTERS
   stats->cnt_current.num_packets_rx++;
 #endif
@@ -299,6 +441,7 @@ link_stats_reset(void)
 void
 link_stats_init(void)
 {
+  LOG_INFO("link estimator: %s\n", estimator.name);
   nbr_table_register(link_stats, NULL);
   ctimer_set(&periodic_timer, FRESHNESS_HALF_LIFE, periodic, NULL);
 }
@@ -56,6 +56,44 @@
 #define LINK_STATS_ETX_FROM_PACKET_COUNT           0
 #endif /* LINK_STATS_ETX_FROM_PACKET_COUNT */
 
+/* Link estimators, see LINK_STATS_CONF_ESTIMATOR */
+#define LINK_STATS_ESTIMATOR_EWMA                  0 /* EWMA of per-packet ETX */
+#define LINK_STATS_ESTIMATOR_PACKET_COUNT          1 /* Tx count over ACK count */
+#define LINK_STATS_ESTIMATOR_WINDOW                2 /* Mean ETX of the last packets */
+#define LINK_STATS_ESTIMATOR_4BIT                  3 /* EWMA of windowed ETX, with PHY hints */
+
+/* The link estimator used to compute ETX */
+#ifdef LINK_STATS_CONF_ESTIMATOR
+#define LINK_STATS_ESTIMATOR LINK_STATS_CONF_ESTIMATOR
+#elif LINK_STATS_ETX_FROM_PACKET_COUNT
+#define LINK_STATS_ESTIMATOR LINK_STATS_ESTIMATOR_PACKET_COUNT
+#else /* LINK_STATS_CONF_ESTIMATOR */
+#define LINK_STATS_ESTIMATOR LINK_STATS_ESTIMATOR_EWMA
+#endif /* LINK_STATS_CONF_ESTIMATOR */
+
+/* Number of packets averaged by the windowed mean estimator */
+#ifdef LINK_STATS_CONF_WINDOW_SIZE
+#define LINK_STATS_WINDOW_SIZE LINK_STATS_CONF_WINDOW_SIZE
+#else /* LINK_STATS_CONF_WINDOW_SIZE */
+#define LINK_STATS_WINDOW_SIZE                     8
+#endif /* LINK_STATS_CONF_WINDOW_SIZE */
+
+/* Number of transmissions per ETX sample of the 4-bit style estimator */
+#ifdef LINK_STATS_CONF_4BIT_WINDOW
+#define LINK_STATS_4BIT_WINDOW LINK_STATS_CONF_4BIT_WINDOW
+#else /* LINK_STATS_CONF_4BIT_WINDOW */
+#define LINK_STATS_4BIT_WINDOW                     5
+#endif /* LINK_STATS_CONF_4BIT_WINDOW */
+
+/* Number of transmissions in the probing burst of a new link, during which
+ * routing probes it at a short interval to bootstrap its ETX. 0 disables
+ * probing bursts. */
+#ifdef LINK_STATS_CONF_PROBE_BURST
+#define LINK_STATS_PROBE_BURST LINK_STATS_CONF_PROBE_BURST
+#else /* LINK_STATS_CONF_PROBE_BURST */
+#define LINK_STATS_PROBE_BURST                     0
+#endif /* LINK_STATS_CONF_PROBE_BURST */
+
 /* Store and periodically print packet counters? */
 #ifdef LINK_STATS_CONF_PACKET_COUNTERS
 #define LINK_STATS_PACKET_COUNTERS LINK_STATS_CONF_PACKET_COUNTERS
@@ -81,10 +119,18 @@ struct link_stats {
   uint16_t etx;               /* ETX using ETX_DIVISOR as fixed point divisor */
   int16_t rssi;               /* RSSI (received signal strength) */
   uint8_t freshness;          /* Freshness of the statistics */
-#if LINK_STATS_ETX_FROM_PACKET_COUNT
+#if LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_PACKET_COUNT \
+  || LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_4BIT
   uint8_t tx_count;           /* Tx count, used for ETX calculation */
   uint8_t ack_count;          /* ACK count, used for ETX calculation */
-#endif /* LINK_STATS_ETX_FROM_PACKET_COUNT */
+#elif LINK_STATS_ESTIMATOR == LINK_STATS_ESTIMATOR_WINDOW
+  uint8_t window[LINK_STATS_WINDOW_SIZE]; /* Tx count of the last packets */
+  uint8_t window_pos;         /* Next window entry to overwrite */
+  uint8_t window_len;         /* Number of valid window entries */
+#endif /* LINK_STATS_ESTIMATOR */
+#if LINK_STATS_PROBE_BURST
+  uint8_t probe_burst;        /* Transmissions left in the probing burst */
+#endif /* LINK_STATS_PROBE_BURST */
 
 #if LINK_STATS_PACKET_COUNTERS
   struct link_packet_counter cnt_current; /* packets in the current period */
@@ -92,12 +138,29 @@ struct link_stats {
 #endif
 };
 
+/* A link estimator, maintaining the ETX of links */
+struct link_stats_estimator {
+  /* Name of the estimator */
+  const char *name;
+  /* Called when a link is added, sets its initial ETX */
+  void (*init)(struct link_stats *stats);
+  /* Called after a unicast transmission that was ACKed or not. numtx
+   * includes the no-ACK penalty. */
+  void (*packet_sent)(struct link_stats *stats, int status, int numtx);
+  /* Called on reception from the link, after its RSSI was updated */
+  void (*packet_received)(struct link_stats *stats, int16_t rssi);
+};
+
 /* Returns the neighbor's link statistics */
 const struct link_stats *link_stats_from_lladdr(const linkaddr_t *lladdr);
 /* Returns the address of the neighbor */
 const linkaddr_t *link_stats_get_lladdr(const struct link_stats *);
 /* Are the statistics fresh? */
 int link_stats_is_fresh(const struct link_stats *stats);
+/* Is the link new, and in need of probing at a short interval? */
+int link_stats_in_probe_burst(const struct link_stats *stats);
+/* Returns the name of the link estimator in use */
+const char *link_stats_estimator_name(void);
 /* Resets link-stats module */
 void link_stats_reset(void);
 /* Initializes link-stats module */
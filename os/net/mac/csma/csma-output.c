@@ -40,6 +40,7 @@
  */
 
 #include "net/mac/csma/csma.h"
+#include "net/mac/csma/csma-output.h"
 #include "net/mac/csma/csma-security.h"
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
@@ -51,6 +52,7 @@
 #include "lib/list.h"
 #include "lib/memb.h"
 #include "lib/assert.h"
+#include <string.h>
 
 /* Log configuration */
 #include "sys/log.h"
@@ -94,13 +96,19 @@ struct qbuf_metadata {
   uint8_t max_transmissions;
 };
 
-/* Every neighbor has its own packet queue */
+/* Every neighbor has its own packet queue. Queues are kept, idle, after
+ * they are emptied, and recycled when a new neighbor needs one */
 struct neighbor_queue {
   struct neighbor_queue *next;
+  /* Next queue in the same neighbor_hash bucket */
+  struct neighbor_queue *hash_next;
   linkaddr_t addr;
   struct ctimer transmit_timer;
   uint8_t transmissions;
   uint8_t collisions;
+  /* Frames sent so far in the current burst */
+  uint8_t burst_count;
+  struct csma_neighbor_stats stats;
   LIST_STRUCT(packet_queue);
 };
 
@@ -118,7 +126,33 @@ struct neighbor_queue {
 #define CSMA_MAX_PACKET_PER_NEIGHBOR MAX_QUEUED_PACKETS
 #endif /* CSMA_CONF_MAX_PACKET_PER_NEIGHBOR */
 
+/* The maximum number of pending packets, all neighbors together */
+#ifdef CSMA_CONF_MAX_QUEUED_PACKETS
+#define MAX_QUEUED_PACKETS CSMA_CONF_MAX_QUEUED_PACKETS
+#else
 #define MAX_QUEUED_PACKETS QUEUEBUF_NUM
+#endif /* CSMA_CONF_MAX_QUEUED_PACKETS */
+
+/* The number of buckets of the neighbor queue lookup table. Must be a
+ * power of two */
+#ifdef CSMA_CONF_NEIGHBOR_HASH_SIZE
+#define CSMA_NEIGHBOR_HASH_SIZE CSMA_CONF_NEIGHBOR_HASH_SIZE
+#else
+#define CSMA_NEIGHBOR_HASH_SIZE 8
+#endif /* CSMA_CONF_NEIGHBOR_HASH_SIZE */
+
+#if (CSMA_NEIGHBOR_HASH_SIZE & (CSMA_NEIGHBOR_HASH_SIZE - 1)) != 0
+#error CSMA_NEIGHBOR_HASH_SIZE must be a power of two
+#endif
+
+/* The maximum number of unicast frames sent back-to-back to a neighbor,
+ * without backoff in between, as long as they get acknowledged. All but the
+ * last frame of a burst have the frame pending bit set. 0 or 1: disabled */
+#ifdef CSMA_CONF_BURST_MAX_LEN
+#define CSMA_BURST_MAX_LEN CSMA_CONF_BURST_MAX_LEN
+#else
+#define CSMA_BURST_MAX_LEN 0
+#endif /* CSMA_CONF_BURST_MAX_LEN */
 
 /* Neighbor packet queue */
 struct packet_queue {
@@ -130,7 +164,12 @@ struct packet_queue {
 MEMB(neighbor_memb, struct neighbor_queue, CSMA_MAX_NEIGHBOR_QUEUES);
 MEMB(packet_memb, struct packet_queue, MAX_QUEUED_PACKETS);
 MEMB(metadata_memb, struct qbuf_metadata, MAX_QUEUED_PACKETS);
+/* All neighbor queues, oldest first */
 LIST(neighbor_list);
+/* Neighbor queues by link-layer address */
+static struct neighbor_queue *neighbor_hash[CSMA_NEIGHBOR_HASH_SIZE];
+
+static struct csma_output_stats stats;
 
 static void packet_sent(struct neighbor_queue *n,
     struct packet_queue *q,
@@ -138,19 +177,85 @@ static void packet_sent(struct neighbor_queue *n,
     int num_transmissions);
 static void transmit_from_queue(void *ptr);
 /*---------------------------------------------------------------------------*/
+static struct neighbor_queue **
+neighbor_hash_bucket(const linkaddr_t *addr)
+{
+  uint8_t h = 0;
+  int i;
+
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (h << 1) ^ (h >> 7) ^ addr->u8[i];
+  }
+  return &neighbor_hash[h & (CSMA_NEIGHBOR_HASH_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
 static struct neighbor_queue *
 neighbor_queue_from_addr(const linkaddr_t *addr)
 {
-  struct neighbor_queue *n = list_head(neighbor_list);
+  struct neighbor_queue *n = *neighbor_hash_bucket(addr);
   while(n != NULL) {
     if(linkaddr_cmp(&n->addr, addr)) {
       return n;
     }
-    n = list_item_next(n);
+    n = n->hash_next;
   }
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static void
+neighbor_queue_free(struct neighbor_queue *n)
+{
+  struct neighbor_queue **np = neighbor_hash_bucket(&n->addr);
+
+  while(*np != NULL) {
+    if(*np == n) {
+      *np = n->hash_next;
+      break;
+    }
+    np = &(*np)->hash_next;
+  }
+  ctimer_stop(&n->transmit_timer);
+  list_remove(neighbor_list, n);
+  memb_free(&neighbor_memb, n);
+}
+/*---------------------------------------------------------------------------*/
+static struct neighbor_queue *
+neighbor_queue_alloc(const linkaddr_t *addr)
+{
+  struct neighbor_queue *n = memb_alloc(&neighbor_memb);
+  struct neighbor_queue **bucket;
+
+  if(n == NULL) {
+    /* Recycle the oldest idle queue */
+    for(n = list_head(neighbor_list); n != NULL; n = list_item_next(n)) {
+      if(list_head(n->packet_queue) == NULL) {
+        neighbor_queue_free(n);
+        stats.recycled++;
+        n = memb_alloc(&neighbor_memb);
+        break;
+      }
+    }
+    if(n == NULL) {
+      return NULL;
+    }
+  }
+
+  /* Init neighbor entry */
+  linkaddr_copy(&n->addr, addr);
+  n->transmissions = 0;
+  n->collisions = 0;
+  n->burst_count = 0;
+  memset(&n->stats, 0, sizeof(n->stats));
+  /* Init packet queue for this neighbor */
+  LIST_STRUCT_INIT(n, packet_queue);
+  /* Add neighbor to the neighbor list and lookup table */
+  list_add(neighbor_list, n);
+  bucket = neighbor_hash_bucket(addr);
+  n->hash_next = *bucket;
+  *bucket = n;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
 static clock_time_t
 backoff_period(void)
 {
@@ -173,6 +278,13 @@ send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
 
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+#if CSMA_BURST_MAX_LEN > 1
+  /* Announce that another frame follows within the burst */
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_PENDING,
+                     !packetbuf_holds_broadcast()
+                     && list_item_next(q) != NULL
+                     && n->burst_count + 1 < CSMA_BURST_MAX_LEN);
+#endif /* CSMA_BURST_MAX_LEN > 1 */
 
 #if LLSEC802154_ENABLED
 #if LLSEC802154_USES_EXPLICIT_KEYS
@@ -298,23 +410,35 @@ free_packet(struct neighbor_queue *n, struct packet_queue *p, int status)
   if(p != NULL) {
     /* Remove packet from queue and deallocate */
     list_remove(n->packet_queue, p);
+    n->stats.backlog--;
 
     queuebuf_free(p->buf);
     memb_free(&metadata_memb, p->ptr);
     memb_free(&packet_memb, p);
     LOG_DBG("free_queued_packet, queue length %d, free packets %d\n",
-           list_length(n->packet_queue), memb_numfree(&packet_memb));
+           n->stats.backlog, memb_numfree(&packet_memb));
     if(list_head(n->packet_queue) != NULL) {
       /* There is a next packet. We reset current tx information */
       n->transmissions = 0;
       n->collisions = 0;
+#if CSMA_BURST_MAX_LEN > 1
+      if(status == MAC_TX_OK && !linkaddr_cmp(&n->addr, &linkaddr_null)
+         && n->burst_count + 1 < CSMA_BURST_MAX_LEN) {
+        /* The neighbor just acknowledged a frame announcing this one: we
+         * still hold the channel, send right away */
+        n->burst_count++;
+        stats.burst_frames++;
+        ctimer_set(&n->transmit_timer, 0, transmit_from_queue, n);
+        return;
+      }
+      n->burst_count = 0;
+#endif /* CSMA_BURST_MAX_LEN > 1 */
       /* Schedule next transmissions */
       schedule_transmission(n);
     } else {
-      /* This was the last packet in the queue, we free the neighbor */
+      /* This was the last packet in the queue, the neighbor is now idle */
+      n->burst_count = 0;
       ctimer_stop(&n->transmit_timer);
-      list_remove(neighbor_list, n);
-      memb_free(&neighbor_memb, n);
     }
   }
 }
@@ -338,6 +462,11 @@ tx_done(int status, struct packet_queue *q, struct neighbor_queue *n)
               packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO),
               status, n->transmissions, n->collisions);
 
+  if(status == MAC_TX_OK) {
+    n->stats.sent++;
+  } else {
+    n->stats.failed++;
+  }
   free_packet(n, q, status);
   mac_call_sent_callback(sent, cptr, status, ntx);
 }
@@ -345,6 +474,8 @@ tx_done(int status, struct packet_queue *q, struct neighbor_queue *n)
 static void
 rexmit(struct packet_queue *q, struct neighbor_queue *n)
 {
+  /* The burst, if any, lost the channel: back off as usual */
+  n->burst_count = 0;
   schedule_transmission(n);
   /* This is needed to correctly attribute energy that we spent
      transmitting this packet. */
@@ -464,22 +595,12 @@ csma_output_packet(mac_callback_t sent, void *ptr)
   n = neighbor_queue_from_addr(addr);
   if(n == NULL) {
     /* Allocate a new neighbor entry */
-    n = memb_alloc(&neighbor_memb);
-    if(n != NULL) {
-      /* Init neighbor entry */
-      linkaddr_copy(&n->addr, addr);
-      n->transmissions = 0;
-      n->collisions = 0;
-      /* Init packet queue for this neighbor */
-      LIST_STRUCT_INIT(n, packet_queue);
-      /* Add neighbor to the neighbor list */
-      list_add(neighbor_list, n);
-    }
+    n = neighbor_queue_alloc(addr);
   }
 
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
-    if(list_length(n->packet_queue) < CSMA_MAX_PACKET_PER_NEIGHBOR) {
+    if(n->stats.backlog < CSMA_MAX_PACKET_PER_NEIGHBOR) {
       q = memb_alloc(&packet_memb);
       if(q != NULL) {
         q->ptr = memb_alloc(&metadata_memb);
@@ -496,13 +617,16 @@ csma_output_packet(mac_callback_t sent, void *ptr)
             metadata->sent = sent;
             metadata->cptr = ptr;
             list_add(n->packet_queue, q);
+            n->stats.backlog++;
+            n->stats.max_backlog = MAX(n->stats.max_backlog, n->stats.backlog);
+            stats.enqueued++;
 
             LOG_INFO("sending to ");
             LOG_INFO_LLADDR(addr);
             LOG_INFO_(", len %u, seqno %u, queue length %d, free packets %d\n",
                     packetbuf_datalen(),
                     packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO),
-                    list_length(n->packet_queue), memb_numfree(&packet_memb));
+                    n->stats.backlog, memb_numfree(&packet_memb));
             /* If q is the first packet in the neighbor's queue, send asap */
             if(list_head(n->packet_queue) == q) {
               schedule_transmission(n);
@@ -515,21 +639,44 @@ csma_output_packet(mac_callback_t sent, void *ptr)
         memb_free(&packet_memb, q);
         LOG_WARN("could not allocate queuebuf, dropping packet\n");
       }
-      /* The packet allocation failed. Remove and free neighbor entry if empty. */
-      if(list_length(n->packet_queue) == 0) {
-        list_remove(neighbor_list, n);
-        memb_free(&neighbor_memb, n);
-      }
+      /* The packet allocation failed */
+      stats.dropped_no_buffer++;
     } else {
       LOG_WARN("Neighbor queue full\n");
+      stats.dropped_queue_full++;
     }
+    n->stats.dropped++;
     LOG_WARN("could not allocate packet, dropping packet\n");
   } else {
     LOG_WARN("could not allocate neighbor, dropping packet\n");
+    stats.dropped_no_neighbor++;
   }
   mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
 }
 /*---------------------------------------------------------------------------*/
+const struct csma_output_stats *
+csma_output_get_stats(void)
+{
+  return &stats;
+}
+/*---------------------------------------------------------------------------*/
+int
+csma_output_get_neighbor_stats(int index, linkaddr_t *addr,
+                               struct csma_neighbor_stats *nbr_stats)
+{
+  struct neighbor_queue *n = list_head(neighbor_list);
+
+  while(n != NULL && index-- > 0) {
+    n = list_item_next(n);
+  }
+  if(n == NULL) {
+    return 0;
+  }
+  linkaddr_copy(addr, &n->addr);
+  memcpy(nbr_stats, &n->stats, sizeof(*nbr_stats));
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 void
 csma_output_init(void)
 {
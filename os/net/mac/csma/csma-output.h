@@ -44,8 +44,34 @@
 
 #include "contiki.h"
 #include "net/mac/mac.h"
+#include "net/linkaddr.h"
+
+/* Statistics of a neighbor queue. They live as long as the queue, which is
+ * kept after it empties until recycled for another neighbor */
+struct csma_neighbor_stats {
+  uint8_t backlog;      /* Packets currently queued */
+  uint8_t max_backlog;  /* Highest backlog seen */
+  uint16_t sent;        /* Packets acknowledged (or broadcast) */
+  uint16_t failed;      /* Packets given up after retransmissions */
+  uint16_t dropped;     /* Packets rejected as the queue or buffers were full */
+};
+
+/* Global CSMA output statistics */
+struct csma_output_stats {
+  uint32_t enqueued;
+  uint32_t dropped_queue_full;   /* Neighbor queue at CSMA_MAX_PACKET_PER_NEIGHBOR */
+  uint32_t dropped_no_buffer;    /* Out of packet or queue buffers */
+  uint32_t dropped_no_neighbor;  /* No neighbor queue available */
+  uint32_t recycled;             /* Idle neighbor queues given to another neighbor */
+  uint32_t burst_frames;         /* Frames sent back-to-back, without backoff */
+};
 
 void csma_output_packet(mac_callback_t sent, void *ptr);
 void csma_output_init(void);
+const struct csma_output_stats *csma_output_get_stats(void);
+/* Copy the address and statistics of the index-th neighbor queue.
+ * Returns 0 if there is no such queue */
+int csma_output_get_neighbor_stats(int index, linkaddr_t *addr,
+                                   struct csma_neighbor_stats *nbr_stats);
 
 #endif /* CSMA_OUTPUT_H_ */
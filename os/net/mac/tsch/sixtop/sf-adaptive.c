@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup sixtop
+ * @{
+ */
+/**
+ * \file
+ *         Traffic-adaptive Scheduling Function
+ */
+
+#include "contiki.h"
+#include "lib/assert.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+
+#include "net/mac/tsch/tsch.h"
+#include "net/mac/tsch/sixtop/sixtop.h"
+#include "net/mac/tsch/sixtop/sixp.h"
+#include "net/mac/tsch/sixtop/sixp-pkt.h"
+#include "net/mac/tsch/sixtop/sixp-trans.h"
+
+#include "sf-adaptive.h"
+
+#include <string.h>
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "6top"
+#define LOG_LEVEL LOG_LEVEL_6TOP
+
+/* A cell in a CellList: timeslot offset and channel offset */
+#define CELL_LEN 4
+/* Metadata, CellOptions and NumCells fields of ADD/DELETE requests */
+#define REQ_FIXED_LEN 4
+
+#define NO_TIMESLOT 0xffff
+
+/* A neighbor whose backlog is monitored */
+struct sf_adaptive_nbr {
+  struct sf_adaptive_nbr *next;
+  linkaddr_t addr;
+  /* Sum of the backlog samples of the current period */
+  uint16_t backlog_sum;
+  /* The cell of the DELETE request in process, if any */
+  uint16_t deleting_timeslot;
+  uint16_t deleting_channel_offset;
+};
+
+MEMB(nbr_memb, struct sf_adaptive_nbr, SF_ADAPTIVE_MAX_NEIGHBORS);
+LIST(nbr_list);
+
+static struct ctimer sample_timer;
+static uint8_t num_samples;
+static uint8_t req_storage[REQ_FIXED_LEN + SF_ADAPTIVE_NUM_CANDIDATES * CELL_LEN];
+static uint8_t res_storage[SF_ADAPTIVE_NUM_CANDIDATES * CELL_LEN];
+
+/*---------------------------------------------------------------------------*/
+static void
+write_cell(uint8_t *buf, uint16_t timeslot, uint16_t channel_offset)
+{
+  buf[0] = timeslot & 0xff;
+  buf[1] = timeslot >> 8;
+  buf[2] = channel_offset & 0xff;
+  buf[3] = channel_offset >> 8;
+}
+/*---------------------------------------------------------------------------*/
+static void
+read_cell(const uint8_t *buf, uint16_t *timeslot, uint16_t *channel_offset)
+{
+  *timeslot = buf[0] + (buf[1] << 8);
+  *channel_offset = buf[2] + (buf[3] << 8);
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_slotframe *
+get_slotframe(void)
+{
+  struct tsch_slotframe *sf;
+
+  sf = tsch_schedule_get_slotframe_by_handle(SF_ADAPTIVE_SLOTFRAME_HANDLE);
+  if(sf == NULL) {
+    /* Not created yet, or removed along with the schedule */
+    sf = tsch_schedule_add_slotframe(SF_ADAPTIVE_SLOTFRAME_HANDLE,
+                                     SF_ADAPTIVE_SLOTFRAME_LENGTH);
+  }
+  return sf;
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_free_timeslot(struct tsch_slotframe *sf, uint16_t timeslot)
+{
+  return timeslot < sf->size.val
+         && tsch_schedule_get_link_by_timeslot(sf, timeslot) == NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+find_link(struct tsch_slotframe *sf, uint8_t link_options,
+          const linkaddr_t *peer_addr, uint16_t timeslot)
+{
+  struct tsch_link *l;
+
+  l = tsch_schedule_get_link_by_timeslot(sf, timeslot);
+  if(l != NULL && l->link_options == link_options
+     && linkaddr_cmp(&l->addr, peer_addr)) {
+    return l;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+sf_adaptive_tx_cell_count(const linkaddr_t *peer_addr)
+{
+  struct tsch_slotframe *sf;
+  struct tsch_link *l;
+  int count = 0;
+
+  sf = tsch_schedule_get_slotframe_by_handle(SF_ADAPTIVE_SLOTFRAME_HANDLE);
+  if(sf != NULL) {
+    for(l = list_head(sf->links_list); l != NULL; l = list_item_next(l)) {
+      if(l->link_options == LINK_OPTION_TX && linkaddr_cmp(&l->addr, peer_addr)) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static struct sf_adaptive_nbr *
+nbr_find(const linkaddr_t *addr)
+{
+  struct sf_adaptive_nbr *n;
+
+  for(n = list_head(nbr_list); n != NULL; n = list_item_next(n)) {
+    if(linkaddr_cmp(&n->addr, addr)) {
+      return n;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct sf_adaptive_nbr *
+nbr_add(const linkaddr_t *addr)
+{
+  struct sf_adaptive_nbr *n = memb_alloc(&nbr_memb);
+
+  if(n != NULL) {
+    linkaddr_copy(&n->addr, addr);
+    n->backlog_sum = 0;
+    n->deleting_timeslot = NO_TIMESLOT;
+    list_add(nbr_list, n);
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+nbr_remove(struct sf_adaptive_nbr *n)
+{
+  list_remove(nbr_list, n);
+  memb_free(&nbr_memb, n);
+}
+/*---------------------------------------------------------------------------*/
+/* The mean transmission success probability towards a neighbor, over the
+ * channels in use, scaled by TSCH_STATS_BINARY_SCALING_FACTOR */
+static uint32_t
+link_p_tx(const linkaddr_t *addr)
+{
+#if TSCH_STATS_ON
+  struct tsch_neighbor_stats *stats;
+  uint32_t sum = 0;
+  int i;
+
+  stats = tsch_stats_get_from_neighbor(tsch_queue_get_nbr(addr));
+  if(stats != NULL && tsch_hopping_sequence_length.val > 0) {
+    for(i = 0; i < tsch_hopping_sequence_length.val; i++) {
+      uint8_t index = tsch_stats_channel_to_index(tsch_hopping_sequence[i]);
+      sum += stats->channel_stats[index].p_tx_success;
+    }
+    sum /= tsch_hopping_sequence_length.val;
+    /* Do not let a few failures inflate the demand without bound */
+    return MAX(sum, TSCH_STATS_BINARY_SCALING_FACTOR / 8);
+  }
+#endif /* TSCH_STATS_ON */
+  return TSCH_STATS_BINARY_SCALING_FACTOR;
+}
+/*---------------------------------------------------------------------------*/
+static int
+request_add(const linkaddr_t *peer_addr)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  uint16_t candidates[SF_ADAPTIVE_NUM_CANDIDATES];
+  int num_candidates = 0;
+  int trials;
+  int i;
+
+  if(sf == NULL) {
+    return -1;
+  }
+
+  memset(req_storage, 0, sizeof(req_storage));
+  for(trials = 0;
+      trials < sf->size.val && num_candidates < SF_ADAPTIVE_NUM_CANDIDATES;
+      trials++) {
+    uint16_t timeslot = random_rand() % sf->size.val;
+
+    if(!is_free_timeslot(sf, timeslot)) {
+      continue;
+    }
+    for(i = 0; i < num_candidates; i++) {
+      if(candidates[i] == timeslot) {
+        break;
+      }
+    }
+    if(i == num_candidates) {
+      candidates[num_candidates] = timeslot;
+      write_cell(&req_storage[REQ_FIXED_LEN + num_candidates * CELL_LEN],
+                 timeslot, random_rand() % SF_ADAPTIVE_NUM_CHANNEL_OFFSETS);
+      num_candidates++;
+    }
+  }
+
+  if(num_candidates == 0) {
+    LOG_WARN("sf-adaptive: no free cell to propose\n");
+    return -1;
+  }
+
+  if(sixp_pkt_set_cell_options(SIXP_PKT_TYPE_REQUEST,
+                               (sixp_pkt_code_t)(uint8_t)SIXP_PKT_CMD_ADD,
+                               SIXP_PKT_CELL_OPTION_TX,
+                               req_storage, sizeof(req_storage)) != 0 ||
+     sixp_pkt_set_num_cells(SIXP_PKT_TYPE_REQUEST,
+                            (sixp_pkt_code_t)(uint8_t)SIXP_PKT_CMD_ADD,
+                            1, req_storage, sizeof(req_storage)) != 0) {
+    LOG_ERR("sf-adaptive: build error on add request\n");
+    return -1;
+  }
+
+  LOG_INFO("sf-adaptive: add request to ");
+  LOG_INFO_LLADDR(peer_addr);
+  LOG_INFO_(", %u candidates\n", num_candidates);
+  return sixp_output(SIXP_PKT_TYPE_REQUEST,
+                     (sixp_pkt_code_t)(uint8_t)SIXP_PKT_CMD_ADD,
+                     SF_ADAPTIVE_SFID,
+                     req_storage, REQ_FIXED_LEN + num_candidates * CELL_LEN,
+                     peer_addr, NULL, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+static int
+request_delete(struct sf_adaptive_nbr *n)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  struct tsch_link *l;
+
+  if(sf == NULL) {
+    return -1;
+  }
+
+  /* Pick the most recently added TX cell */
+  n->deleting_timeslot = NO_TIMESLOT;
+  for(l = list_head(sf->links_list); l != NULL; l = list_item_next(l)) {
+    if(l->link_options == LINK_OPTION_TX && linkaddr_cmp(&l->addr, &n->addr)) {
+      n->deleting_timeslot = l->timeslot;
+      n->deleting_channel_offset = l->channel_offset;
+    }
+  }
+  if(n->deleting_timeslot == NO_TIMESLOT) {
+    return -1;
+  }
+
+  memset(req_storage, 0, sizeof(req_storage));
+  write_cell(&req_storage[REQ_FIXED_LEN],
+             n->deleting_timeslot, n->deleting_channel_offset);
+  if(sixp_pkt_set_cell_options(SIXP_PKT_TYPE_REQUEST,
+                               (sixp_pkt_code_t)(uint8_t)SIXP_PKT_CMD_DELETE,
+                               SIXP_PKT_CELL_OPTION_TX,
+                               req_storage, sizeof(req_storage)) != 0 ||
+     sixp_pkt_set_num_cells(SIXP_PKT_TYPE_REQUEST,
+                            (sixp_pkt_code_t)(uint8_t)SIXP_PKT_CMD_DELETE,
+                            1, req_storage, sizeof(req_storage)) != 0) {
+    LOG_ERR("sf-adaptive: build error on delete request\n");
+    n->deleting_timeslot = NO_TIMESLOT;
+    return -1;
+  }
+
+  LOG_INFO("sf-adaptive: delete request to ");
+  LOG_INFO_LLADDR(&n->addr);
+  LOG_INFO_(", timeslot %u\n", n->deleting_timeslot);
+  if(sixp_output(SIXP_PKT_TYPE_REQUEST,
+                 (sixp_pkt_code_t)(uint8_t)SIXP_PKT_CMD_DELETE,
+                 SF_ADAPTIVE_SFID,
+                 req_storage, REQ_FIXED_LEN + CELL_LEN,
+                 &n->addr, NULL, NULL, 0) != 0) {
+    n->deleting_timeslot = NO_TIMESLOT;
+    return -1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Adjust the cells of a neighbor to the backlog of the period that ended */
+static void
+update_nbr(struct sf_adaptive_nbr *n, int is_time_source)
+{
+  uint32_t demand;
+  int num_cells;
+  int min_cells;
+
+  /* Mean backlog in sixteenths of a packet, over the transmission success
+   * probability: the number of transmissions the backlog needs */
+  demand = ((uint32_t)n->backlog_sum * 16) / SF_ADAPTIVE_NUM_SAMPLES;
+  demand = (demand * TSCH_STATS_BINARY_SCALING_FACTOR) / link_p_tx(&n->addr);
+  n->backlog_sum = 0;
+
+  if(sixp_trans_find(&n->addr) != NULL) {
+    /* A transaction is in process, wait for its outcome */
+    return;
+  }
+
+  num_cells = sf_adaptive_tx_cell_count(&n->addr);
+  min_cells = is_time_source ? SF_ADAPTIVE_MIN_CELLS : 0;
+
+  LOG_DBG("sf-adaptive: ");
+  LOG_DBG_LLADDR(&n->addr);
+  LOG_DBG_(" demand %lu/16, cells %d\n", (unsigned long)demand, num_cells);
+
+  if(num_cells < min_cells
+     || (demand > SF_ADAPTIVE_ADD_THRESHOLD && num_cells < SF_ADAPTIVE_MAX_CELLS)) {
+    request_add(&n->addr);
+  } else if(num_cells > min_cells && demand < SF_ADAPTIVE_DELETE_THRESHOLD) {
+    request_delete(n);
+  } else if(num_cells == 0 && !is_time_source) {
+    /* Nothing left to monitor */
+    nbr_remove(n);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+sample(void *ptr)
+{
+  struct tsch_neighbor *time_source;
+  struct sf_adaptive_nbr *n;
+  struct sf_adaptive_nbr *next;
+
+  ctimer_reset(&sample_timer);
+
+  if(!tsch_is_associated || tsch_is_locked()) {
+    return;
+  }
+
+  time_source = tsch_queue_get_time_source();
+  if(time_source != NULL && nbr_find(&time_source->addr) == NULL) {
+    nbr_add(&time_source->addr);
+  }
+
+  for(n = list_head(nbr_list); n != NULL; n = list_item_next(n)) {
+    n->backlog_sum += tsch_queue_nbr_packet_count(tsch_queue_get_nbr(&n->addr));
+  }
+
+  if(++num_samples < SF_ADAPTIVE_NUM_SAMPLES) {
+    return;
+  }
+  num_samples = 0;
+
+  for(n = list_head(nbr_list); n != NULL; n = next) {
+    next = list_item_next(n);
+    update_nbr(n, time_source != NULL
+               && linkaddr_cmp(&n->addr, &time_source->addr));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_response_sent_callback(void *arg, uint16_t arg_len,
+                           const linkaddr_t *dest_addr,
+                           sixp_output_status_t status)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  uint16_t i;
+
+  if(status != SIXP_OUTPUT_STATUS_SUCCESS || sf == NULL) {
+    return;
+  }
+
+  for(i = 0; i + CELL_LEN <= arg_len; i += CELL_LEN) {
+    read_cell((const uint8_t *)arg + i, &timeslot, &channel_offset);
+    tsch_schedule_add_link(sf, LINK_OPTION_RX, LINK_TYPE_NORMAL, dest_addr,
+                           timeslot, channel_offset);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+delete_response_sent_callback(void *arg, uint16_t arg_len,
+                              const linkaddr_t *dest_addr,
+                              sixp_output_status_t status)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  struct tsch_link *l;
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  uint16_t i;
+
+  if(status != SIXP_OUTPUT_STATUS_SUCCESS || sf == NULL) {
+    return;
+  }
+
+  for(i = 0; i + CELL_LEN <= arg_len; i += CELL_LEN) {
+    read_cell((const uint8_t *)arg + i, &timeslot, &channel_offset);
+    if((l = find_link(sf, LINK_OPTION_RX, dest_addr, timeslot)) != NULL) {
+      tsch_schedule_remove_link(sf, l);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+request_input(sixp_pkt_cmd_t cmd, const uint8_t *body, uint16_t body_len,
+              const linkaddr_t *peer_addr)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  sixp_pkt_cell_options_t cell_options;
+  uint8_t num_cells;
+  const uint8_t *cell_list;
+  uint16_t cell_list_len;
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  uint16_t res_len = 0;
+  uint16_t i;
+
+  if(cmd != SIXP_PKT_CMD_ADD && cmd != SIXP_PKT_CMD_DELETE) {
+    sixp_output(SIXP_PKT_TYPE_RESPONSE,
+                (sixp_pkt_code_t)(uint8_t)SIXP_PKT_RC_ERR,
+                SF_ADAPTIVE_SFID, NULL, 0, peer_addr, NULL, NULL, 0);
+    return;
+  }
+
+  if(sixp_pkt_get_cell_options(SIXP_PKT_TYPE_REQUEST,
+                               (sixp_pkt_code_t)(uint8_t)cmd,
+                               &cell_options, body, body_len) != 0 ||
+     sixp_pkt_get_num_cells(SIXP_PKT_TYPE_REQUEST,
+                            (sixp_pkt_code_t)(uint8_t)cmd,
+                            &num_cells, body, body_len) != 0 ||
+     sixp_pkt_get_cell_list(SIXP_PKT_TYPE_REQUEST,
+                            (sixp_pkt_code_t)(uint8_t)cmd,
+                            &cell_list, &cell_list_len,
+                            body, body_len) != 0) {
+    LOG_ERR("sf-adaptive: parse error on request\n");
+    return;
+  }
+
+  if(sf == NULL || cell_options != SIXP_PKT_CELL_OPTION_TX) {
+    /* We only negotiate dedicated TX cells of the requester */
+    sixp_output(SIXP_PKT_TYPE_RESPONSE,
+                (sixp_pkt_code_t)(uint8_t)SIXP_PKT_RC_ERR,
+                SF_ADAPTIVE_SFID, NULL, 0, peer_addr, NULL, NULL, 0);
+    return;
+  }
+
+  /* Accept, or confirm, up to num_cells cells of the list */
+  for(i = 0;
+      i + CELL_LEN <= cell_list_len && res_len / CELL_LEN < num_cells
+      && res_len < sizeof(res_storage);
+      i += CELL_LEN) {
+    read_cell(&cell_list[i], &timeslot, &channel_offset);
+    if(cmd == SIXP_PKT_CMD_ADD ?
+       is_free_timeslot(sf, timeslot) :
+       find_link(sf, LINK_OPTION_RX, peer_addr, timeslot) != NULL) {
+      memcpy(&res_storage[res_len], &cell_list[i], CELL_LEN);
+      res_len += CELL_LEN;
+    }
+  }
+
+  LOG_INFO("sf-adaptive: %s request from ",
+           cmd == SIXP_PKT_CMD_ADD ? "add" : "delete");
+  LOG_INFO_LLADDR(peer_addr);
+  LOG_INFO_(", %u of %u cells\n", res_len / CELL_LEN, num_cells);
+
+  sixp_output(SIXP_PKT_TYPE_RESPONSE,
+              (sixp_pkt_code_t)(uint8_t)SIXP_PKT_RC_SUCCESS,
+              SF_ADAPTIVE_SFID, res_len > 0 ? res_storage : NULL, res_len,
+              peer_addr,
+              cmd == SIXP_PKT_CMD_ADD ?
+              add_response_sent_callback : delete_response_sent_callback,
+              res_storage, res_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+response_input(sixp_pkt_rc_t rc, const uint8_t *body, uint16_t body_len,
+               const linkaddr_t *peer_addr)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  struct sf_adaptive_nbr *n = nbr_find(peer_addr);
+  struct tsch_link *l;
+  sixp_trans_t *trans;
+  sixp_pkt_cmd_t cmd;
+  const uint8_t *cell_list;
+  uint16_t cell_list_len;
+  uint16_t timeslot;
+  uint16_t channel_offset;
+  uint16_t i;
+
+  if((trans = sixp_trans_find(peer_addr)) == NULL || sf == NULL) {
+    return;
+  }
+  cmd = sixp_trans_get_cmd(trans);
+  if(n != NULL && cmd == SIXP_PKT_CMD_DELETE) {
+    n->deleting_timeslot = NO_TIMESLOT;
+  }
+
+  if(rc != SIXP_PKT_RC_SUCCESS) {
+    LOG_WARN("sf-adaptive: request rejected, rc %u\n", rc);
+    return;
+  }
+
+  if(sixp_pkt_get_cell_list(SIXP_PKT_TYPE_RESPONSE,
+                            (sixp_pkt_code_t)(uint8_t)SIXP_PKT_RC_SUCCESS,
+                            &cell_list, &cell_list_len,
+                            body, body_len) != 0) {
+    LOG_ERR("sf-adaptive: parse error on response\n");
+    return;
+  }
+
+  for(i = 0; i + CELL_LEN <= cell_list_len; i += CELL_LEN) {
+    read_cell(&cell_list[i], &timeslot, &channel_offset);
+    if(cmd == SIXP_PKT_CMD_ADD) {
+      if(is_free_timeslot(sf, timeslot)) {
+        tsch_schedule_add_link(sf, LINK_OPTION_TX, LINK_TYPE_NORMAL, peer_addr,
+                               timeslot, channel_offset);
+      }
+    } else if(cmd == SIXP_PKT_CMD_DELETE) {
+      if((l = find_link(sf, LINK_OPTION_TX, peer_addr, timeslot)) != NULL) {
+        tsch_schedule_remove_link(sf, l);
+      }
+    }
+  }
+
+  LOG_INFO("sf-adaptive: %s response from ",
+           cmd == SIXP_PKT_CMD_ADD ? "add" : "delete");
+  LOG_INFO_LLADDR(peer_addr);
+  LOG_INFO_(", %u cells, now %d TX cells\n",
+            cell_list_len / CELL_LEN, sf_adaptive_tx_cell_count(peer_addr));
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(sixp_pkt_type_t type, sixp_pkt_code_t code,
+      const uint8_t *body, uint16_t body_len, const linkaddr_t *src_addr)
+{
+  assert(src_addr != NULL);
+
+  switch(type) {
+    case SIXP_PKT_TYPE_REQUEST:
+      request_input(code.cmd, body, body_len, src_addr);
+      break;
+    case SIXP_PKT_TYPE_RESPONSE:
+      response_input(code.rc, body, body_len, src_addr);
+      break;
+    default:
+      /* unsupported */
+      break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+timeout(sixp_pkt_cmd_t cmd, const linkaddr_t *peer_addr)
+{
+  struct sf_adaptive_nbr *n = nbr_find(peer_addr);
+  struct tsch_slotframe *sf = get_slotframe();
+  struct tsch_link *l;
+
+  if(cmd == SIXP_PKT_CMD_DELETE && n != NULL && sf != NULL
+     && n->deleting_timeslot != NO_TIMESLOT) {
+    /* The neighbor is likely gone: release the cell on our side anyway */
+    if((l = find_link(sf, LINK_OPTION_TX, peer_addr,
+                      n->deleting_timeslot)) != NULL) {
+      tsch_schedule_remove_link(sf, l);
+    }
+    n->deleting_timeslot = NO_TIMESLOT;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  memb_init(&nbr_memb);
+  list_init(nbr_list);
+  num_samples = 0;
+  get_slotframe();
+  ctimer_set(&sample_timer, SF_ADAPTIVE_SAMPLE_PERIOD, sample, NULL);
+}
+/*---------------------------------------------------------------------------*/
+const sixtop_sf_t sf_adaptive_driver = {
+  SF_ADAPTIVE_SFID,
+  CLOCK_SECOND,
+  init,
+  input,
+  timeout
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
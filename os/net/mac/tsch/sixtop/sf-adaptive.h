@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * \addtogroup sixtop
+ * @{
+ */
+/**
+ * \file
+ *         Traffic-adaptive Scheduling Function
+ *
+ * The SF samples the TSCH queue backlog towards the time source and every
+ * neighbor it already has cells with, weighs it by the link's transmission
+ * success probability (from tsch-stats, when enabled) and adds or deletes
+ * dedicated TX cells through 6P ADD/DELETE transactions. Nodes forwarding
+ * more traffic build up more backlog and thus get more cells.
+ *
+ * Usage: add the sixtop module, set TSCH_CONF_WITH_SIXTOP to 1 and call
+ * sixtop_add_sf(&sf_adaptive_driver) on every node.
+ */
+
+#ifndef _SIXTOP_SF_ADAPTIVE_H_
+#define _SIXTOP_SF_ADAPTIVE_H_
+
+#include "net/linkaddr.h"
+#include "net/mac/tsch/sixtop/sixtop.h"
+
+/* Scheduling Function Identifier (unmanaged range) */
+#ifdef SF_ADAPTIVE_CONF_SFID
+#define SF_ADAPTIVE_SFID SF_ADAPTIVE_CONF_SFID
+#else
+#define SF_ADAPTIVE_SFID 0xf1
+#endif
+
+/* Handle and length of the slotframe holding the negotiated cells */
+#ifdef SF_ADAPTIVE_CONF_SLOTFRAME_HANDLE
+#define SF_ADAPTIVE_SLOTFRAME_HANDLE SF_ADAPTIVE_CONF_SLOTFRAME_HANDLE
+#else
+#define SF_ADAPTIVE_SLOTFRAME_HANDLE 3
+#endif
+
+#ifdef SF_ADAPTIVE_CONF_SLOTFRAME_LENGTH
+#define SF_ADAPTIVE_SLOTFRAME_LENGTH SF_ADAPTIVE_CONF_SLOTFRAME_LENGTH
+#else
+#define SF_ADAPTIVE_SLOTFRAME_LENGTH 23
+#endif
+
+/* Channel offsets are picked in [0, SF_ADAPTIVE_NUM_CHANNEL_OFFSETS) */
+#ifdef SF_ADAPTIVE_CONF_NUM_CHANNEL_OFFSETS
+#define SF_ADAPTIVE_NUM_CHANNEL_OFFSETS SF_ADAPTIVE_CONF_NUM_CHANNEL_OFFSETS
+#else
+#define SF_ADAPTIVE_NUM_CHANNEL_OFFSETS 4
+#endif
+
+/* Bounds on the number of TX cells towards one neighbor. The minimum
+ * applies to the time source only */
+#ifdef SF_ADAPTIVE_CONF_MIN_CELLS
+#define SF_ADAPTIVE_MIN_CELLS SF_ADAPTIVE_CONF_MIN_CELLS
+#else
+#define SF_ADAPTIVE_MIN_CELLS 1
+#endif
+
+#ifdef SF_ADAPTIVE_CONF_MAX_CELLS
+#define SF_ADAPTIVE_MAX_CELLS SF_ADAPTIVE_CONF_MAX_CELLS
+#else
+#define SF_ADAPTIVE_MAX_CELLS 8
+#endif
+
+/* Number of candidate cells proposed in an ADD request */
+#ifdef SF_ADAPTIVE_CONF_NUM_CANDIDATES
+#define SF_ADAPTIVE_NUM_CANDIDATES SF_ADAPTIVE_CONF_NUM_CANDIDATES
+#else
+#define SF_ADAPTIVE_NUM_CANDIDATES 3
+#endif
+
+/* Number of neighbors whose traffic is monitored */
+#ifdef SF_ADAPTIVE_CONF_MAX_NEIGHBORS
+#define SF_ADAPTIVE_MAX_NEIGHBORS SF_ADAPTIVE_CONF_MAX_NEIGHBORS
+#else
+#define SF_ADAPTIVE_MAX_NEIGHBORS 4
+#endif
+
+/* The backlog is sampled every SF_ADAPTIVE_SAMPLE_PERIOD, and cells are
+ * added or deleted every SF_ADAPTIVE_NUM_SAMPLES samples */
+#ifdef SF_ADAPTIVE_CONF_SAMPLE_PERIOD
+#define SF_ADAPTIVE_SAMPLE_PERIOD SF_ADAPTIVE_CONF_SAMPLE_PERIOD
+#else
+#define SF_ADAPTIVE_SAMPLE_PERIOD (CLOCK_SECOND / 4)
+#endif
+
+#ifdef SF_ADAPTIVE_CONF_NUM_SAMPLES
+#define SF_ADAPTIVE_NUM_SAMPLES SF_ADAPTIVE_CONF_NUM_SAMPLES
+#else
+#define SF_ADAPTIVE_NUM_SAMPLES 16
+#endif
+
+/* Thresholds on the demand, i.e. the mean backlog divided by the TX
+ * success probability, in sixteenths of a packet. Above the first, one
+ * cell is added; below the second, one cell is deleted */
+#ifdef SF_ADAPTIVE_CONF_ADD_THRESHOLD
+#define SF_ADAPTIVE_ADD_THRESHOLD SF_ADAPTIVE_CONF_ADD_THRESHOLD
+#else
+#define SF_ADAPTIVE_ADD_THRESHOLD 24
+#endif
+
+#ifdef SF_ADAPTIVE_CONF_DELETE_THRESHOLD
+#define SF_ADAPTIVE_DELETE_THRESHOLD SF_ADAPTIVE_CONF_DELETE_THRESHOLD
+#else
+#define SF_ADAPTIVE_DELETE_THRESHOLD 2
+#endif
+
+/**
+ * \brief Get the number of TX cells negotiated with a neighbor
+ * \param peer_addr The MAC address of the neighbor
+ * \return The number of TX cells
+ */
+int sf_adaptive_tx_cell_count(const linkaddr_t *peer_addr);
+
+extern const sixtop_sf_t sf_adaptive_driver;
+
+#endif /* !_SIXTOP_SF_ADAPTIVE_H_ */
+/** @} */
@@ -192,6 +192,8 @@ sixtop_output(const linkaddr_t *dest_addr, mac_callback_t callback, void *arg)
 
   /* 6P packet is data frame */
   packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
+  /* Schedule negotiation goes ahead of data */
+  packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, PACKETBUF_ATTR_PRIORITY_CONTROL);
 
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest_addr);
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
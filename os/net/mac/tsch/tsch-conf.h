@@ -219,6 +219,34 @@
 #define TSCH_CHANNEL_SCAN_DURATION CLOCK_SECOND
 #endif
 
+/* Scan with hints: when (re-)joining, first scan the channel we last
+ * associated on, then only the channels of the hopping sequence we last
+ * learned, before falling back to TSCH_JOIN_HOPPING_SEQUENCE. The hints
+ * are kept across leaving the network, and can be restored after a reboot
+ * with tsch_set_scan_hints() */
+#ifdef TSCH_CONF_SCAN_WITH_HINTS
+#define TSCH_SCAN_WITH_HINTS TSCH_CONF_SCAN_WITH_HINTS
+#else
+#define TSCH_SCAN_WITH_HINTS 0
+#endif
+
+/* With RPL: right after joining a TSCH network, send a unicast DIS to
+ * the time source so that it answers with a DIO at once, instead of
+ * waiting for its next Trickle DIO */
+#ifdef TSCH_RPL_CONF_DIS_ON_JOIN
+#define TSCH_RPL_DIS_ON_JOIN TSCH_RPL_CONF_DIS_ON_JOIN
+#else
+#define TSCH_RPL_DIS_ON_JOIN 0
+#endif
+
+/* With TSCH_SCAN_WITH_HINTS: how many channel switches to draw from the
+ * hints before falling back to the regular scan */
+#ifdef TSCH_CONF_SCAN_HINT_TRIES
+#define TSCH_SCAN_HINT_TRIES TSCH_CONF_SCAN_HINT_TRIES
+#else
+#define TSCH_SCAN_HINT_TRIES 8
+#endif
+
 /* TSCH EB: include timeslot timing Information Element? */
 #ifdef TSCH_PACKET_CONF_EB_WITH_TIMESLOT_TIMING
 #define TSCH_PACKET_EB_WITH_TIMESLOT_TIMING TSCH_PACKET_CONF_EB_WITH_TIMESLOT_TIMING
@@ -274,6 +302,28 @@
 #define TSCH_MAX_INCOMING_PACKETS 4
 #endif
 
+/* The maximum number of incoming and of sent packets passed to the upper
+ * layers per poll of the TSCH pending events process. The process polls
+ * itself again when more are pending, letting other processes run in between.
+ * Should be smaller than TSCH_MAX_INCOMING_PACKETS to have any effect */
+#ifdef TSCH_CONF_PENDING_BATCH_SIZE
+#define TSCH_PENDING_BATCH_SIZE TSCH_CONF_PENDING_BATCH_SIZE
+#else
+#define TSCH_PENDING_BATCH_SIZE 2
+#endif
+
+/* Input ring fill level at which the slot operation asks the pending events
+ * process to drain the whole ring at once, ahead of batching, so that Rx
+ * slots are not skipped for lack of buffers. The ring holds up to
+ * TSCH_MAX_INCOMING_PACKETS - 1 packets. When the ring does fill up,
+ * Rx slots are skipped: unicast frames are then not acknowledged and get
+ * retransmitted by the sender */
+#ifdef TSCH_CONF_RX_BACKPRESSURE_LEVEL
+#define TSCH_RX_BACKPRESSURE_LEVEL TSCH_CONF_RX_BACKPRESSURE_LEVEL
+#else
+#define TSCH_RX_BACKPRESSURE_LEVEL (TSCH_MAX_INCOMING_PACKETS / 2)
+#endif
+
 /* The maximum number of outgoing packets towards each neighbor
  * Must be power of two to enable atomic ringbuf operations.
  * Note: the total number of outgoing packets in the system (for
@@ -308,6 +358,44 @@
 #define TSCH_QUEUE_MAX_NEIGHBOR_QUEUES ((NBR_TABLE_CONF_MAX_NEIGHBORS) + 2)
 #endif
 
+/* The number of traffic classes per neighbor queue, from 1 to 3. Packets
+ * are classified from PACKETBUF_ATTR_PRIORITY: control, high-priority data
+ * and best effort. With fewer classes, the lowest ones are merged.
+ * Each class has its own ringbuf of TSCH_QUEUE_NUM_PER_NEIGHBOR entries */
+#ifdef TSCH_QUEUE_CONF_NUM_CLASSES
+#define TSCH_QUEUE_NUM_CLASSES TSCH_QUEUE_CONF_NUM_CLASSES
+#else
+#define TSCH_QUEUE_NUM_CLASSES 1
+#endif
+
+/* How classes are served: TSCH_QUEUE_SERVICE_STRICT always sends from the
+ * highest non-empty class, TSCH_QUEUE_SERVICE_WEIGHTED serves classes in
+ * round robin, up to their weight in packets per round */
+#define TSCH_QUEUE_SERVICE_STRICT   0
+#define TSCH_QUEUE_SERVICE_WEIGHTED 1
+#ifdef TSCH_QUEUE_CONF_SERVICE
+#define TSCH_QUEUE_SERVICE TSCH_QUEUE_CONF_SERVICE
+#else
+#define TSCH_QUEUE_SERVICE TSCH_QUEUE_SERVICE_STRICT
+#endif
+
+/* Per-class weights, for TSCH_QUEUE_SERVICE_WEIGHTED */
+#ifdef TSCH_QUEUE_CONF_CLASS_WEIGHTS
+#define TSCH_QUEUE_CLASS_WEIGHTS TSCH_QUEUE_CONF_CLASS_WEIGHTS
+#else
+#define TSCH_QUEUE_CLASS_WEIGHTS { 4, 2, 1 }
+#endif
+
+/* Per-class maximum number of packets queued towards a neighbor. Limiting
+ * lower classes keeps queuebufs available for the higher ones */
+#ifdef TSCH_QUEUE_CONF_CLASS_LIMITS
+#define TSCH_QUEUE_CLASS_LIMITS TSCH_QUEUE_CONF_CLASS_LIMITS
+#else
+#define TSCH_QUEUE_CLASS_LIMITS { TSCH_QUEUE_NUM_PER_NEIGHBOR, \
+                                  TSCH_QUEUE_NUM_PER_NEIGHBOR, \
+                                  TSCH_QUEUE_NUM_PER_NEIGHBOR }
+#endif
+
 /******** Configuration: scheduling  *******/
 
 /* Initializes TSCH with a 6TiSCH minimal schedule */
@@ -326,6 +414,15 @@
 #define TSCH_BURST_MAX_LEN 32
 #endif
 
+/* With TSCH_CALLBACK_SKIP_TX_CHANNEL defined, the maximum number of times in
+ * a row a neighbor's traffic is deferred because of a bad channel. Bounds the
+ * delay when the slotframe keeps hitting the same channels */
+#ifdef TSCH_CONF_MAX_TX_CHANNEL_SKIPS
+#define TSCH_MAX_TX_CHANNEL_SKIPS TSCH_CONF_MAX_TX_CHANNEL_SKIPS
+#else
+#define TSCH_MAX_TX_CHANNEL_SKIPS 2
+#endif
+
 /* 6TiSCH Minimal schedule slotframe length */
 #ifdef TSCH_SCHEDULE_CONF_DEFAULT_LENGTH
 #define TSCH_SCHEDULE_DEFAULT_LENGTH TSCH_SCHEDULE_CONF_DEFAULT_LENGTH
@@ -362,6 +459,23 @@
 #define TSCH_WITH_LINK_SELECTOR (BUILD_WITH_ORCHESTRA)
 #endif /* TSCH_CONF_WITH_LINK_SELECTOR */
 
+/* Pack several packets queued for the same neighbor into a single unicast
+ * frame (see tsch_packet_aggregation_start). All nodes of the network must
+ * enable it, as the receiver unpacks aggregated frames. Not used on secured
+ * PANs */
+#ifdef TSCH_CONF_WITH_AGGREGATION
+#define TSCH_WITH_AGGREGATION TSCH_CONF_WITH_AGGREGATION
+#else /* TSCH_CONF_WITH_AGGREGATION */
+#define TSCH_WITH_AGGREGATION 0
+#endif /* TSCH_CONF_WITH_AGGREGATION */
+
+/* Max number of packets in an aggregated frame */
+#ifdef TSCH_CONF_AGGREGATION_MAX_PACKETS
+#define TSCH_AGGREGATION_MAX_PACKETS TSCH_CONF_AGGREGATION_MAX_PACKETS
+#else /* TSCH_CONF_AGGREGATION_MAX_PACKETS */
+#define TSCH_AGGREGATION_MAX_PACKETS 4
+#endif /* TSCH_CONF_AGGREGATION_MAX_PACKETS */
+
 /******** Configuration: CSMA *******/
 
 /* TSCH CSMA-CA parameters, see IEEE 802.15.4e-2012 */
@@ -437,5 +551,30 @@ by default, useful in case of duplicate seqno */
 #define TSCH_CONF_RX_WAIT 2200
 #endif /* TSCH_CONF_RX_WAIT */
 
+/* Rx guard time of the 5 ms timeslot template (tsch_timeslot_timing_us_5000),
+ * in micro-seconds */
+#ifndef TSCH_CONF_RX_WAIT_5000
+#define TSCH_CONF_RX_WAIT_5000 800
+#endif /* TSCH_CONF_RX_WAIT_5000 */
+
+/******** Configuration: profiling *******/
+
+/* Measure, in rtimer ticks, how long each phase of the slot operation takes
+ * and how late missed deadlines are. See tsch_slot_profiler_get() */
+#ifdef TSCH_CONF_SLOT_PROFILER
+#define TSCH_SLOT_PROFILER TSCH_CONF_SLOT_PROFILER
+#else
+#define TSCH_SLOT_PROFILER 0
+#endif
+
+/* Number of histogram buckets of the slot profiler. Bucket i counts
+ * durations of less than 2^i rtimer ticks, the last bucket everything
+ * longer */
+#ifdef TSCH_CONF_SLOT_PROFILER_BUCKETS
+#define TSCH_SLOT_PROFILER_BUCKETS TSCH_CONF_SLOT_PROFILER_BUCKETS
+#else
+#define TSCH_SLOT_PROFILER_BUCKETS 12
+#endif
+
 #endif /* __TSCH_CONF_H__ */
 /** @} */
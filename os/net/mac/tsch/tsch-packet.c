@@ -45,12 +45,14 @@
 
 #include "contiki.h"
 #include "net/packetbuf.h"
+#include "net/queuebuf.h"
 #include "net/mac/tsch/tsch.h"
 #include "net/mac/framer/frame802154.h"
 #include "net/mac/framer/framer-802154.h"
 #include "net/netstack.h"
 #include "lib/ccm-star.h"
 #include "lib/aes-128.h"
+#include <string.h>
 
 /* Log configuration */
 #include "sys/log.h"
@@ -461,5 +463,89 @@ tsch_packet_get_frame_pending(uint8_t *buf, int buf_size)
 {
   return (buf[0] >> IEEE802154_FRAME_PENDING_BIT_OFFSET) & 1;
 }
+#if TSCH_WITH_AGGREGATION
+/*---------------------------------------------------------------------------*/
+/* The offset of the IE list present flag within the second byte of FCF */
+#define IEEE802154_IE_PRESENT_BIT_OFFSET 1
+/*---------------------------------------------------------------------------*/
+/* Append the payload of a queued packet as an aggregation entry */
+static int
+aggregation_append(uint8_t *buf, int len, int buf_size, const struct tsch_packet *p)
+{
+  const uint8_t *frame = queuebuf_dataptr(p->qb);
+  int payload_len = queuebuf_datalen(p->qb) - p->header_len;
+
+  /* Entries hold at least one byte, so that they never look like a keep-alive */
+  if(payload_len <= 0 || len + 1 + payload_len > buf_size) {
+    return 0;
+  }
+  buf[len++] = payload_len;
+  memcpy(buf + len, frame + p->header_len, payload_len);
+  return len + payload_len;
+}
+/*---------------------------------------------------------------------------*/
+/* Start an aggregated frame from a queued packet */
+int
+tsch_packet_aggregation_start(uint8_t *buf, int buf_size, const struct tsch_packet *p)
+{
+  const uint8_t *frame = queuebuf_dataptr(p->qb);
+
+  /* Only plain data frames: IEs must directly follow the header */
+  if((frame[0] & 7) != FRAME802154_DATAFRAME
+     || (frame[1] >> IEEE802154_IE_PRESENT_BIT_OFFSET) & 1
+     || p->header_len + 1 > buf_size) {
+    return 0;
+  }
+  memcpy(buf, frame, p->header_len);
+  buf[p->header_len] = TSCH_AGGREGATION_DISPATCH;
+  return aggregation_append(buf, p->header_len + 1, buf_size, p);
+}
+/*---------------------------------------------------------------------------*/
+/* Append a queued packet to an aggregated frame */
+int
+tsch_packet_aggregation_add(uint8_t *buf, int len, int buf_size,
+                            const struct tsch_packet *first,
+                            const struct tsch_packet *p)
+{
+  const uint8_t *first_frame = queuebuf_dataptr(first->qb);
+  const uint8_t *frame = queuebuf_dataptr(p->qb);
+  const uint8_t pending_mask = 1 << IEEE802154_FRAME_PENDING_BIT_OFFSET;
+
+  /* Same header, but for the frame pending bit and the sequence number */
+  if(p->header_len != first->header_len
+     || (frame[0] & ~pending_mask) != (first_frame[0] & ~pending_mask)
+     || frame[1] != first_frame[1]
+     || memcmp(frame + 3, first_frame + 3, p->header_len - 3) != 0) {
+    return 0;
+  }
+  return aggregation_append(buf, len, buf_size, p);
+}
+/*---------------------------------------------------------------------------*/
+/* Iterate over the entries of an aggregated payload */
+int
+tsch_packet_aggregation_next(const uint8_t *payload, int payload_len,
+                             int *offset, const uint8_t **entry)
+{
+  int entry_len;
+
+  if(*offset == 0) {
+    if(payload_len < 1 || payload[0] != TSCH_AGGREGATION_DISPATCH) {
+      return 0;
+    }
+    *offset = 1;
+  }
+  if(*offset >= payload_len) {
+    return 0;
+  }
+  entry_len = payload[*offset];
+  if(entry_len == 0 || *offset + 1 + entry_len > payload_len) {
+    LOG_WARN("! malformed aggregated frame\n");
+    return 0;
+  }
+  *entry = payload + *offset + 1;
+  *offset += 1 + entry_len;
+  return entry_len;
+}
+#endif /* TSCH_WITH_AGGREGATION */
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -46,6 +46,15 @@
 #include "net/mac/framer/frame802154.h"
 #include "net/mac/framer/frame802154e-ie.h"
 
+/********** Constants *********/
+
+/* First payload byte of an aggregated frame. Taken from the 6LoWPAN
+ * "Not a LoWPAN frame" dispatch range, so that it never collides with
+ * a regular 6LoWPAN payload */
+#define TSCH_AGGREGATION_DISPATCH 0x3a
+
+struct tsch_packet;
+
 /********** Functions *********/
 
 /**
@@ -127,6 +136,43 @@ void tsch_packet_eackbuf_set_attr(uint8_t type, const packetbuf_attr_t val);
  * \return The attribute value
  */
 packetbuf_attr_t tsch_packet_eackbuf_attr(uint8_t type);
+#if TSCH_WITH_AGGREGATION
+/**
+ * \brief Start an aggregated frame from a queued packet: copy its header,
+ * then the aggregation dispatch and its payload as first entry. Entries are
+ * stored as a length byte followed by the payload.
+ * \param buf The buffer where to build the aggregated frame
+ * \param buf_size The buffer size, i.e. the max frame length
+ * \param p The first packet, whose header is used for the whole frame
+ * \return The length of the frame, 0 if the packet can not be aggregated
+ */
+int tsch_packet_aggregation_start(uint8_t *buf, int buf_size,
+                                  const struct tsch_packet *p);
+/**
+ * \brief Append a queued packet to an aggregated frame. Only packets whose
+ * header matches the first packet's (but for the sequence number) qualify.
+ * \param buf The buffer that contains the aggregated frame
+ * \param len The current length of the aggregated frame
+ * \param buf_size The buffer size, i.e. the max frame length
+ * \param first The packet the aggregated frame was started from
+ * \param p The packet to append
+ * \return The new length of the frame, 0 if the packet was not appended
+ */
+int tsch_packet_aggregation_add(uint8_t *buf, int len, int buf_size,
+                                const struct tsch_packet *first,
+                                const struct tsch_packet *p);
+/**
+ * \brief Iterate over the entries of an aggregated payload
+ * \param payload The frame payload, starting with the aggregation dispatch
+ * \param payload_len The payload length
+ * \param offset The offset of the next entry, to be initialized to 0
+ * \param entry A pointer where to store the address of the entry
+ * \return The length of the entry, 0 at the end of the payload or if
+ * it is malformed
+ */
+int tsch_packet_aggregation_next(const uint8_t *payload, int payload_len,
+                                 int *offset, const uint8_t **entry);
+#endif /* TSCH_WITH_AGGREGATION */
 
 #endif /* __TSCH_PACKET_H__ */
 /** @} */
@@ -65,6 +65,13 @@
 #error TSCH_QUEUE_NUM_PER_NEIGHBOR must be power of two
 #endif
 
+#if TSCH_QUEUE_NUM_CLASSES < 1 || TSCH_QUEUE_NUM_CLASSES > 3
+#error TSCH_QUEUE_NUM_CLASSES must be 1, 2 or 3
+#endif
+
+#define WITH_WRR (TSCH_QUEUE_NUM_CLASSES > 1 \
+                  && TSCH_QUEUE_SERVICE == TSCH_QUEUE_SERVICE_WEIGHTED)
+
 /* We have as many packets are there are queuebuf in the system */
 MEMB(packet_memb, struct tsch_packet, QUEUEBUF_NUM);
 MEMB(neighbor_memb, struct tsch_neighbor, TSCH_QUEUE_MAX_NEIGHBOR_QUEUES);
@@ -74,12 +81,86 @@ LIST(neighbor_list);
 struct tsch_neighbor *n_broadcast;
 struct tsch_neighbor *n_eb;
 
+static const uint8_t class_limits[] = TSCH_QUEUE_CLASS_LIMITS;
+#if WITH_WRR
+static const uint8_t class_weights[] = TSCH_QUEUE_CLASS_WEIGHTS;
+#endif /* WITH_WRR */
+
+/*---------------------------------------------------------------------------*/
+/* The traffic class of the packet in packetbuf */
+static uint8_t
+packetbuf_queue_class(void)
+{
+  uint8_t c;
+
+  switch(packetbuf_attr(PACKETBUF_ATTR_PRIORITY)) {
+  case PACKETBUF_ATTR_PRIORITY_CONTROL:
+    c = TSCH_QUEUE_CLASS_CONTROL;
+    break;
+  case PACKETBUF_ATTR_PRIORITY_HIGH:
+    c = TSCH_QUEUE_CLASS_HIGH;
+    break;
+  default:
+    c = TSCH_QUEUE_CLASS_BEST_EFFORT;
+    break;
+  }
+  return MIN(c, TSCH_QUEUE_NUM_CLASSES - 1);
+}
+/*---------------------------------------------------------------------------*/
+/* The class whose head packet is to be sent next, -1 if all are empty */
+static int
+service_class(const struct tsch_neighbor *n)
+{
+  int i;
+
+  for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+#if WITH_WRR
+    int c = (n->wrr_class + i) % TSCH_QUEUE_NUM_CLASSES;
+#else
+    int c = i;
+#endif
+    if(!ringbufindex_empty(&n->tx_ringbuf[c])) {
+      return c;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Remove the head packet of a class */
+static struct tsch_packet *
+remove_class_head(struct tsch_neighbor *n, int c)
+{
+  int16_t get_index;
+
+  /* Get and remove packet from ringbuf (remove committed through an atomic operation */
+  get_index = ringbufindex_get(&n->tx_ringbuf[c]);
+  if(get_index == -1) {
+    return NULL;
+  }
+#if WITH_WRR
+  if(c != n->wrr_class) {
+    /* The class in turn was empty: the round moved on to this one */
+    n->wrr_class = c;
+    n->wrr_credit = class_weights[c];
+  }
+  if(n->wrr_credit > 0) {
+    n->wrr_credit--;
+  }
+  if(n->wrr_credit == 0 || ringbufindex_empty(&n->tx_ringbuf[c])) {
+    n->wrr_class = (c + 1) % TSCH_QUEUE_NUM_CLASSES;
+    n->wrr_credit = class_weights[n->wrr_class];
+  }
+#endif /* WITH_WRR */
+  return n->tx_array[c][get_index];
+}
+
 /*---------------------------------------------------------------------------*/
 /* Add a TSCH neighbor */
 struct tsch_neighbor *
 tsch_queue_add_nbr(const linkaddr_t *addr)
 {
   struct tsch_neighbor *n = NULL;
+  int i;
   /* If we have an entry for this neighbor already, we simply update it */
   n = tsch_queue_get_nbr(addr);
   if(n == NULL) {
@@ -89,7 +170,12 @@ tsch_queue_add_nbr(const linkaddr_t *addr)
       if(n != NULL) {
         /* Initialize neighbor entry */
         memset(n, 0, sizeof(struct tsch_neighbor));
-        ringbufindex_init(&n->tx_ringbuf, TSCH_QUEUE_NUM_PER_NEIGHBOR);
+        for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+          ringbufindex_init(&n->tx_ringbuf[i], TSCH_QUEUE_NUM_PER_NEIGHBOR);
+        }
+#if WITH_WRR
+        n->wrr_credit = class_weights[0];
+#endif /* WITH_WRR */
         linkaddr_copy(&n->addr, addr);
         n->is_broadcast = linkaddr_cmp(addr, &tsch_eb_address)
           || linkaddr_cmp(addr, &tsch_broadcast_address);
@@ -233,6 +319,7 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
   struct tsch_neighbor *n = NULL;
   int16_t put_index = -1;
   struct tsch_packet *p = NULL;
+  uint8_t c = packetbuf_queue_class();
 
 #ifdef TSCH_CALLBACK_PACKET_READY
   /* The scheduler provides a callback which sets the timeslot and other attributes */
@@ -246,7 +333,9 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      put_index = ringbufindex_peek_put(&n->tx_ringbuf);
+      if(ringbufindex_elements(&n->tx_ringbuf[c]) < class_limits[c]) {
+        put_index = ringbufindex_peek_put(&n->tx_ringbuf[c]);
+      }
       if(put_index != -1) {
         p = memb_alloc(&packet_memb);
         if(p != NULL) {
@@ -258,11 +347,12 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
             p->ret = MAC_TX_DEFERRED;
             p->transmissions = 0;
             p->max_transmissions = max_transmissions;
+            p->queue_class = c;
             /* Add to ringbuf (actual add committed through atomic operation) */
-            n->tx_array[put_index] = p;
-            ringbufindex_put(&n->tx_ringbuf);
-            LOG_DBG("packet is added put_index %u, packet %p\n",
-                   put_index, p);
+            n->tx_array[c][put_index] = p;
+            ringbufindex_put(&n->tx_ringbuf[c]);
+            LOG_DBG("packet is added class %u put_index %u, packet %p\n",
+                   c, put_index, p);
             return p;
           } else {
             memb_free(&packet_memb, p);
@@ -271,7 +361,7 @@ tsch_queue_add_packet(const linkaddr_t *addr, uint8_t max_transmissions,
       }
     }
   }
-  LOG_ERR("! add packet failed: %u %p %d %p %p\n", tsch_is_locked(), n, put_index, p, p ? p->qb : NULL);
+  LOG_ERR("! add packet failed: %u %p %u %d %p %p\n", tsch_is_locked(), n, c, put_index, p, p ? p->qb : NULL);
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
@@ -290,24 +380,36 @@ tsch_queue_packet_count(const linkaddr_t *addr)
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      return ringbufindex_elements(&n->tx_ringbuf);
+      return tsch_queue_nbr_packet_count(n);
     }
   }
   return -1;
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the number of packets in a neighbor queue, all classes together */
+int
+tsch_queue_nbr_packet_count(const struct tsch_neighbor *n)
+{
+  int count = 0;
+  int i;
+
+  if(n != NULL) {
+    for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+      count += ringbufindex_elements(&n->tx_ringbuf[i]);
+    }
+  }
+  return count;
+}
+/*---------------------------------------------------------------------------*/
 /* Remove first packet from a neighbor queue */
 struct tsch_packet *
 tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n)
 {
   if(!tsch_is_locked()) {
     if(n != NULL) {
-      /* Get and remove packet from ringbuf (remove committed through an atomic operation */
-      int16_t get_index = ringbufindex_get(&n->tx_ringbuf);
-      if(get_index != -1) {
-        return n->tx_array[get_index];
-      } else {
-        return NULL;
+      int c = service_class(n);
+      if(c != -1) {
+        return remove_class_head(n, c);
       }
     }
   }
@@ -334,8 +436,9 @@ tsch_queue_packet_sent(struct tsch_neighbor *n, struct tsch_packet *p,
   int is_unicast = !n->is_broadcast;
 
   if(mac_tx_status == MAC_TX_OK) {
-    /* Successful transmission */
-    tsch_queue_remove_packet_from_queue(n);
+    /* Successful transmission. The packet is the head of its class, which
+     * may no longer be the class in service if a higher one got a packet */
+    remove_class_head(n, p->queue_class);
     in_queue = 0;
 
     /* Update CSMA state in the unicast case */
@@ -350,7 +453,7 @@ tsch_queue_packet_sent(struct tsch_neighbor *n, struct tsch_packet *p,
     /* Failed transmission */
     if(p->transmissions >= p->max_transmissions) {
       /* Drop packet */
-      tsch_queue_remove_packet_from_queue(n);
+      remove_class_head(n, p->queue_class);
       in_queue = 0;
     }
     /* Update CSMA state in the unicast case */
@@ -409,7 +512,24 @@ tsch_queue_free_unused_neighbors(void)
 int
 tsch_queue_is_empty(const struct tsch_neighbor *n)
 {
-  return !tsch_is_locked() && n != NULL && ringbufindex_empty(&n->tx_ringbuf);
+  return !tsch_is_locked() && n != NULL && service_class(n) == -1;
+}
+/*---------------------------------------------------------------------------*/
+/* Can the packet be sent at a given link? */
+static int
+packet_matches_link(const struct tsch_packet *p, const struct tsch_link *link)
+{
+#if TSCH_WITH_LINK_SELECTOR
+  int packet_attr_slotframe = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
+  int packet_attr_timeslot = queuebuf_attr(p->qb, PACKETBUF_ATTR_TSCH_TIMESLOT);
+  if(packet_attr_slotframe != 0xffff && packet_attr_slotframe != link->slotframe_handle) {
+    return 0;
+  }
+  if(packet_attr_timeslot != 0xffff && packet_attr_timeslot != link->timeslot) {
+    return 0;
+  }
+#endif
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
 /* Returns the first packet from a neighbor queue */
@@ -419,26 +539,55 @@ tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, struct tsch_link *l
   if(!tsch_is_locked()) {
     int is_shared_link = link != NULL && link->link_options & LINK_OPTION_SHARED;
     if(n != NULL) {
-      int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf);
+      int c = service_class(n);
+      int16_t get_index = c != -1 ? ringbufindex_peek_get(&n->tx_ringbuf[c]) : -1;
       if(get_index != -1 &&
           !(is_shared_link && !tsch_queue_backoff_expired(n))) {    /* If this is a shared link,
                                                                     make sure the backoff has expired */
-#if TSCH_WITH_LINK_SELECTOR
-        int packet_attr_slotframe = queuebuf_attr(n->tx_array[get_index]->qb, PACKETBUF_ATTR_TSCH_SLOTFRAME);
-        int packet_attr_timeslot = queuebuf_attr(n->tx_array[get_index]->qb, PACKETBUF_ATTR_TSCH_TIMESLOT);
-        if(packet_attr_slotframe != 0xffff && packet_attr_slotframe != link->slotframe_handle) {
-          return NULL;
-        }
-        if(packet_attr_timeslot != 0xffff && packet_attr_timeslot != link->timeslot) {
+        if(!packet_matches_link(n->tx_array[c][get_index], link)) {
           return NULL;
         }
-#endif
-        return n->tx_array[get_index];
+        return n->tx_array[c][get_index];
       }
     }
   }
   return NULL;
 }
+#if TSCH_WITH_AGGREGATION
+/*---------------------------------------------------------------------------*/
+/* Returns the i-th packet from a neighbor queue (0 being the head), if it
+ * can be sent at the given link. Packets are ordered by class, starting
+ * with the class in service, so that the first i packets of each class
+ * are the i heads of its ringbuf */
+struct tsch_packet *
+tsch_queue_get_packet_at(const struct tsch_neighbor *n, int i, struct tsch_link *link)
+{
+  if(!tsch_is_locked() && n != NULL) {
+    int first = service_class(n);
+    int k;
+
+    for(k = -1; first != -1 && k < TSCH_QUEUE_NUM_CLASSES; k++) {
+      int c = k == -1 ? first : k;
+      const struct ringbufindex *r = &n->tx_ringbuf[c];
+      if(k == first) {
+        continue;
+      }
+      if(i < ringbufindex_elements(r)) {
+        struct tsch_packet *p = n->tx_array[c][(r->get_ptr + i) & r->mask];
+        return packet_matches_link(p, link) ? p : NULL;
+      }
+      i -= ringbufindex_elements(r);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_queue_drop_aggregated_packet(struct tsch_neighbor *n, struct tsch_packet *p)
+{
+  remove_class_head(n, p->queue_class);
+}
+#endif /* TSCH_WITH_AGGREGATION */
 /*---------------------------------------------------------------------------*/
 /* Returns the head packet from a neighbor queue (from neighbor address) */
 struct tsch_packet *
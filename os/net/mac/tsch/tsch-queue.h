@@ -47,6 +47,11 @@
 #include "net/linkaddr.h"
 #include "net/mac/mac.h"
 
+/* Traffic classes of neighbor queues, from the highest priority */
+#define TSCH_QUEUE_CLASS_CONTROL      0
+#define TSCH_QUEUE_CLASS_HIGH         1
+#define TSCH_QUEUE_CLASS_BEST_EFFORT  2
+
 /***** External Variables *****/
 
 /* Broadcast and EB virtual neighbors */
@@ -98,7 +103,13 @@ int tsch_queue_global_packet_count(void);
  */
 int tsch_queue_packet_count(const linkaddr_t *addr);
 /**
- * \brief Remove first packet from a neighbor queue. The packet is stored in a separate
+ * \brief Returns the number of packets in a neighbor queue, all classes together
+ * \param n The neighbor queue
+ * \return The number of packets in the neighbor's queue
+ */
+int tsch_queue_nbr_packet_count(const struct tsch_neighbor *n);
+/**
+ * \brief Remove the next packet to be sent from a neighbor queue. The packet is stored in a separate
  * dequeued packet list, for later processing.
  * \param n The neighbor queue
  * \return The packet that was removed if any, NULL otherwise
@@ -133,12 +144,30 @@ void tsch_queue_free_unused_neighbors(void);
  */
 int tsch_queue_is_empty(const struct tsch_neighbor *n);
 /**
- * \brief Returns the first packet that can be sent from a queue on a given link
+ * \brief Returns the first packet that can be sent from a queue on a given link,
+ * i.e. the head of the class in service
  * \param n The neighbor queue
  * \param link The link
  * \return The next packet to be sent for the neighbor on the given link, if any, else NULL
  */
 struct tsch_packet *tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, struct tsch_link *link);
+#if TSCH_WITH_AGGREGATION
+/**
+ * \brief Returns a packet from a queue, by position, if it can be sent on a given link
+ * \param n The neighbor queue
+ * \param i The position of the packet in the queue, 0 being the head
+ * \param link The link
+ * \return The packet, or NULL if there is none at this position or it can not be sent on the link
+ */
+struct tsch_packet *tsch_queue_get_packet_at(const struct tsch_neighbor *n, int i, struct tsch_link *link);
+/**
+ * \brief Removes a packet of a failed aggregated frame that reached its
+ * transmission limit. The packet must be the head of its class.
+ * \param n The neighbor queue
+ * \param p The packet
+ */
+void tsch_queue_drop_aggregated_packet(struct tsch_neighbor *n, struct tsch_packet *p);
+#endif /* TSCH_WITH_AGGREGATION */
 /**
  * \brief Returns the first packet that can be sent to a given address on a given link
  * \param addr The target link-layer address
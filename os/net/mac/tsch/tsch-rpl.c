@@ -67,11 +67,41 @@ tsch_rpl_callback_ka_sent(int status, int transmissions)
 {
   NETSTACK_ROUTING.link_callback(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), status, transmissions);
 }
+#if TSCH_RPL_DIS_ON_JOIN
+static struct ctimer dis_timer;
+#endif /* TSCH_RPL_DIS_ON_JOIN */
+
+/*---------------------------------------------------------------------------*/
+#if TSCH_RPL_DIS_ON_JOIN
+static void
+send_dis_to_time_source(void *ptr)
+{
+  struct tsch_neighbor *n = tsch_queue_get_time_source();
+  uip_ipaddr_t addr;
+
+  if(!tsch_is_associated || n == NULL || NETSTACK_ROUTING.node_has_joined()) {
+    return;
+  }
+
+  /* The time source's link-local address, derived from its MAC address */
+  uip_create_linklocal_prefix(&addr);
+  uip_ds6_set_addr_iid(&addr, (uip_lladdr_t *)&n->addr);
+#if ROUTING_CONF_RPL_LITE
+  rpl_icmp6_dis_output(&addr);
+#elif ROUTING_CONF_RPL_CLASSIC
+  dis_output(&addr);
+#endif
+}
+#endif /* TSCH_RPL_DIS_ON_JOIN */
 /*---------------------------------------------------------------------------*/
 /* To use, set #define TSCH_CALLBACK_JOINING_NETWORK tsch_rpl_callback_joining_network */
 void
 tsch_rpl_callback_joining_network(void)
 {
+#if TSCH_RPL_DIS_ON_JOIN
+  /* Not from here: we are called from the TSCH scanning protothread */
+  ctimer_set(&dis_timer, 0, send_dis_to_time_source, NULL);
+#endif /* TSCH_RPL_DIS_ON_JOIN */
 }
 /*---------------------------------------------------------------------------*/
 /* Upon leaving a TSCH network, perform a local repair
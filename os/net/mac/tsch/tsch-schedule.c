@@ -66,6 +66,70 @@ MEMB(link_memb, struct tsch_link, TSCH_SCHEDULE_MAX_LINKS);
 MEMB(slotframe_memb, struct tsch_slotframe, TSCH_SCHEDULE_MAX_SLOTFRAMES);
 /* List of slotframes (each slotframe holds its own list of links) */
 LIST(slotframe_list);
+/* Index of all links, grouped by slotframe in slotframe_list order and
+ * sorted by timeslot within each slotframe. Lets the slot operation find
+ * the next active link with a binary search per slotframe rather than by
+ * walking every link. Only modified with the TSCH lock taken. */
+static struct tsch_link *sorted_links[TSCH_SCHEDULE_MAX_LINKS];
+static uint16_t sorted_links_count;
+
+/*---------------------------------------------------------------------------*/
+/* Returns the index, relative to the slotframe's part of sorted_links, of
+ * its first link with a timeslot >= timeslot (sorted_count if none) */
+static uint16_t
+sorted_lower_bound(const struct tsch_slotframe *sf, uint16_t timeslot)
+{
+  uint16_t lo = 0;
+  uint16_t hi = sf->sorted_count;
+
+  while(lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if(sorted_links[sf->sorted_first + mid]->timeslot < timeslot) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+/*---------------------------------------------------------------------------*/
+/* Inserts a link in the sorted index. Call with the lock taken. */
+static void
+sorted_insert(struct tsch_slotframe *sf, struct tsch_link *l)
+{
+  struct tsch_slotframe *other;
+  uint16_t pos = sf->sorted_first + sorted_lower_bound(sf, l->timeslot);
+
+  memmove(&sorted_links[pos + 1], &sorted_links[pos],
+          (sorted_links_count - pos) * sizeof(sorted_links[0]));
+  sorted_links[pos] = l;
+  sorted_links_count++;
+  sf->sorted_count++;
+  /* The slotframes that follow are shifted by one */
+  for(other = list_item_next(sf); other != NULL; other = list_item_next(other)) {
+    other->sorted_first++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Removes a link from the sorted index. Call with the lock taken. */
+static void
+sorted_remove(struct tsch_slotframe *sf, struct tsch_link *l)
+{
+  struct tsch_slotframe *other;
+  uint16_t pos = sf->sorted_first + sorted_lower_bound(sf, l->timeslot);
+
+  if(pos >= sf->sorted_first + sf->sorted_count || sorted_links[pos] != l) {
+    LOG_ERR("! link index out of sync for ts=%u\n", l->timeslot);
+    return;
+  }
+  memmove(&sorted_links[pos], &sorted_links[pos + 1],
+          (sorted_links_count - pos - 1) * sizeof(sorted_links[0]));
+  sorted_links_count--;
+  sf->sorted_count--;
+  for(other = list_item_next(sf); other != NULL; other = list_item_next(other)) {
+    other->sorted_first--;
+  }
+}
 
 /* Adds and returns a slotframe (NULL if failure) */
 struct tsch_slotframe *
@@ -87,6 +151,9 @@ tsch_schedule_add_slotframe(uint16_t handle, uint16_t size)
       sf->handle = handle;
       TSCH_ASN_DIVISOR_INIT(sf->size, size);
       LIST_STRUCT_INIT(sf, links_list);
+      /* Appended last: its links go to the end of the sorted index */
+      sf->sorted_first = sorted_links_count;
+      sf->sorted_count = 0;
       /* Add the slotframe to the global list */
       list_add(slotframe_list, sf);
     }
@@ -253,6 +320,7 @@ tsch_schedule_add_link(struct tsch_slotframe *slotframe,
           address = &linkaddr_null;
         }
         linkaddr_copy(&l->addr, address);
+        sorted_insert(slotframe, l);
 
         LOG_INFO("add_link sf=%u opt=%s type=%s ts=%u ch=%u addr=",
                  slotframe->handle,
@@ -305,6 +373,7 @@ tsch_schedule_remove_link(struct tsch_slotframe *slotframe, struct tsch_link *l)
       LOG_INFO_LLADDR(&l->addr);
       LOG_INFO_("\n");
 
+      sorted_remove(slotframe, l);
       list_remove(slotframe->links_list, l);
       memb_free(&link_memb, l);
 
@@ -344,15 +413,14 @@ tsch_schedule_get_link_by_timeslot(struct tsch_slotframe *slotframe, uint16_t ti
 {
   if(!tsch_is_locked()) {
     if(slotframe != NULL) {
-      struct tsch_link *l = list_head(slotframe->links_list);
-      /* Loop over all items. Assume there is max one link per timeslot */
-      while(l != NULL) {
+      /* Assume there is max one link per timeslot */
+      uint16_t i = sorted_lower_bound(slotframe, timeslot);
+      if(i < slotframe->sorted_count) {
+        struct tsch_link *l = sorted_links[slotframe->sorted_first + i];
         if(l->timeslot == timeslot) {
           return l;
         }
-        l = list_item_next(l);
       }
-      return l;
     }
   }
   return NULL;
@@ -375,9 +443,18 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
     while(sf != NULL) {
       /* Get timeslot from ASN, given the slotframe length */
       uint16_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
-      struct tsch_link *l = list_head(sf->links_list);
-      while(l != NULL) {
-        uint16_t time_to_timeslot =
+      /* With at most one link per timeslot, the earliest link of this
+       * slotframe is the first one strictly after the current timeslot,
+       * wrapping around to the first link of the slotframe */
+      if(sf->sorted_count > 0) {
+        uint16_t i = sorted_lower_bound(sf, timeslot + 1);
+        struct tsch_link *l;
+        uint16_t time_to_timeslot;
+        if(i == sf->sorted_count) {
+          i = 0;
+        }
+        l = sorted_links[sf->sorted_first + i];
+        time_to_timeslot =
           l->timeslot > timeslot ?
           l->timeslot - timeslot :
           sf->size.val + l->timeslot - timeslot;
@@ -418,8 +495,6 @@ tsch_schedule_get_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset
             curr_best = new_best;
           }
         }
-
-        l = list_item_next(l);
       }
       sf = list_item_next(sf);
     }
@@ -441,6 +516,7 @@ tsch_schedule_init(void)
     memb_init(&link_memb);
     memb_init(&slotframe_memb);
     list_init(slotframe_list);
+    sorted_links_count = 0;
     tsch_release_lock();
     return 1;
   } else {
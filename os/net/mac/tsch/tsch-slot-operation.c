@@ -53,6 +53,7 @@
 #include "net/mac/framer/framer-802154.h"
 #include "net/mac/tsch/tsch.h"
 #include "sys/critical.h"
+#include <string.h>
 
 #include "sys/log.h"
 /* TSCH debug macros, i.e. to set LEDs or GPIOs on various TSCH
@@ -126,6 +127,10 @@ struct tsch_packet *dequeued_array[TSCH_DEQUEUED_ARRAY_SIZE];
  * Will be processed layer by tsch_rx_process_pending */
 struct ringbufindex input_ringbuf;
 struct input_packet input_array[TSCH_MAX_INCOMING_PACKETS];
+/* Overflows and peak occupancy of the two rings above */
+struct tsch_pending_stats tsch_pending_stats;
+/* Raised when an Rx slot was skipped for lack of an input buffer */
+volatile uint8_t tsch_rx_backpressure;
 
 /* Updates and reads of the next two variables must be atomic (i.e. both together) */
 /* Last time we received Sync-IE (ACK or data packet from a time source) */
@@ -177,6 +182,17 @@ static struct pt slot_operation_pt;
 static PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t));
 static PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t));
 
+/*---------------------------------------------------------------------------*/
+/* Keep track of the maximum occupancy of a pending ring */
+static void
+update_pending_peak(uint8_t *peak, const struct ringbufindex *r)
+{
+  int elements = ringbufindex_elements(r);
+  if(elements > *peak) {
+    *peak = elements;
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 /* TSCH locking system. TSCH is locked during slot operations */
 
@@ -279,6 +295,142 @@ check_timer_miss(rtimer_clock_t ref_time, rtimer_clock_t offset, rtimer_clock_t
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Slot profiler */
+
+#if TSCH_SLOT_PROFILER
+static struct tsch_slot_profile slot_profile;
+/* Start of the current slot's processing, and of the phase being measured */
+static rtimer_clock_t profiler_slot_wakeup;
+static rtimer_clock_t profiler_phase_start;
+#define PROFILER_MARK(t) ((t) = RTIMER_NOW())
+#define PROFILER_ADD(phase, start) \
+  profiler_add(&slot_profile.phases[phase], RTIMER_NOW() - (start))
+
+static const char *const phase_names[TSCH_SLOT_PHASE_COUNT] = {
+  "dequeue", "setup", "tx-prepare", "rx-to-ack", "schedule", "slot-end"
+};
+/*---------------------------------------------------------------------------*/
+static void
+profiler_add(struct tsch_slot_phase_stats *stats, rtimer_clock_t duration)
+{
+  rtimer_clock_t d = duration;
+  int bucket = 0;
+
+  /* Bucket i counts durations < 2^i */
+  while(d != 0 && bucket < TSCH_SLOT_PROFILER_BUCKETS - 1) {
+    d >>= 1;
+    bucket++;
+  }
+  stats->histogram[bucket]++;
+  stats->count++;
+  stats->total += duration;
+  if(duration > stats->max) {
+    stats->max = duration;
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct tsch_slot_profile *
+tsch_slot_profiler_get(void)
+{
+  return &slot_profile;
+}
+/*---------------------------------------------------------------------------*/
+const char *
+tsch_slot_profiler_phase_name(enum tsch_slot_phase phase)
+{
+  return phase < TSCH_SLOT_PHASE_COUNT ? phase_names[phase] : "?";
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_slot_profiler_reset(void)
+{
+  /* Not synchronized with the slot operation: a slot ending during the
+   * reset may leave one sample behind */
+  memset(&slot_profile, 0, sizeof(slot_profile));
+}
+#else /* TSCH_SLOT_PROFILER */
+#define PROFILER_MARK(t)
+#define PROFILER_ADD(phase, start)
+#endif /* TSCH_SLOT_PROFILER */
+/*---------------------------------------------------------------------------*/
+/* Aggregation */
+
+#if TSCH_WITH_AGGREGATION
+/* Packets sent in the current Tx slot, current_packet first */
+static struct tsch_packet *aggregated_packets[TSCH_AGGREGATION_MAX_PACKETS];
+static uint8_t aggregated_count = 1;
+static uint8_t aggregated_frame[TSCH_PACKET_MAX_LEN];
+/* Max length of an aggregated frame: what the radio accepts and MaxTx allows */
+static int aggregation_max_len;
+/*---------------------------------------------------------------------------*/
+static void
+aggregation_init(void)
+{
+  radio_value_t radio_max_payload_len;
+
+  aggregation_max_len = TSCH_PACKET_MAX_LEN;
+  if(NETSTACK_RADIO.get_value(RADIO_CONST_MAX_PAYLOAD_LEN,
+                              &radio_max_payload_len) == RADIO_RESULT_OK) {
+    aggregation_max_len = MIN(aggregation_max_len, radio_max_payload_len);
+  }
+  aggregation_max_len = MIN(aggregation_max_len,
+                            tsch_timeslot_timing_max_frame_len(tsch_timing_us));
+}
+/*---------------------------------------------------------------------------*/
+/* Pack the packets that follow current_packet in its queue into
+ * aggregated_frame. Returns the frame length, or 0 if there is nothing
+ * to aggregate */
+static int
+aggregate_packets(void)
+{
+  struct tsch_packet *p;
+  int max_count;
+  int len;
+  int new_len;
+
+  aggregated_packets[0] = current_packet;
+  aggregated_count = 1;
+
+  /* Each aggregated packet takes a slot in dequeued_ringbuf once sent */
+  max_count = ringbufindex_size(&dequeued_ringbuf) - 1
+    - ringbufindex_elements(&dequeued_ringbuf);
+  max_count = MIN(max_count, TSCH_AGGREGATION_MAX_PACKETS);
+  if(max_count < 2
+     || tsch_queue_get_packet_at(current_neighbor, 1, current_link) == NULL) {
+    return 0;
+  }
+
+  len = tsch_packet_aggregation_start(aggregated_frame, aggregation_max_len, current_packet);
+  while(len != 0 && aggregated_count < max_count) {
+    p = tsch_queue_get_packet_at(current_neighbor, aggregated_count, current_link);
+    /* Packets of an aggregate share its outcome, so that a retransmission
+     * carries the same packets under the same seqno. Members must also have
+     * the same transmission budget as the first packet, so that they all
+     * reach it together and are dropped in queue order */
+    if(p == NULL
+       || p->transmissions != current_packet->transmissions
+       || p->max_transmissions != current_packet->max_transmissions) {
+      break;
+    }
+    new_len = tsch_packet_aggregation_add(aggregated_frame, len, aggregation_max_len,
+                                          current_packet, p);
+    if(new_len == 0) {
+      break;
+    }
+    len = new_len;
+    aggregated_packets[aggregated_count++] = p;
+  }
+
+  if(aggregated_count < 2) {
+    aggregated_count = 1;
+    return 0;
+  }
+  return len;
+}
+#else /* TSCH_WITH_AGGREGATION */
+#define aggregated_count 1
+#endif /* TSCH_WITH_AGGREGATION */
+/*---------------------------------------------------------------------------*/
 /* Schedule a wakeup at a specified offset from a reference time.
  * Provides basic protection against missed deadlines and timer overflows
  * A return value of zero signals a missed deadline: no rtimer was scheduled. */
@@ -292,6 +444,10 @@ tsch_schedule_slot_operation(struct rtimer *tm, rtimer_clock_t ref_time, rtimer_
   int missed = check_timer_miss(ref_time, offset - RTIMER_GUARD, now);
 
   if(missed) {
+#if TSCH_SLOT_PROFILER
+    profiler_add(&slot_profile.deadline_misses,
+                 now - (ref_time + offset - RTIMER_GUARD));
+#endif /* TSCH_SLOT_PROFILER */
     TSCH_LOG_ADD(tsch_log_message,
                 snprintf(log->message, sizeof(log->message),
                     "!dl-miss %s %d %d",
@@ -463,12 +619,19 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
   static uint8_t mac_tx_status;
   /* is the packet in its neighbor's queue? */
   uint8_t in_queue;
+#if TSCH_WITH_AGGREGATION
+  int i;
+#endif /* TSCH_WITH_AGGREGATION */
   static int dequeued_index;
   static int packet_ready = 1;
 
   PT_BEGIN(pt);
 
   TSCH_DEBUG_TX_EVENT();
+  PROFILER_MARK(profiler_phase_start);
+#if TSCH_WITH_AGGREGATION
+  aggregated_count = 1;
+#endif /* TSCH_WITH_AGGREGATION */
 
   /* First check if we have space to store a newly dequeued packet (in case of
    * successful Tx or Drop) */
@@ -502,11 +665,21 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
       packet_len = queuebuf_datalen(current_packet->qb);
       /* if is this a broadcast packet, don't wait for ack */
       do_wait_for_ack = !current_neighbor->is_broadcast;
+#if TSCH_WITH_AGGREGATION
+      /* Unicast. Send the packets that follow in the same frame? */
+      if(do_wait_for_ack && !tsch_is_pan_secured) {
+        int aggregated_len = aggregate_packets();
+        if(aggregated_len > 0) {
+          packet = aggregated_frame;
+          packet_len = aggregated_len;
+        }
+      }
+#endif /* TSCH_WITH_AGGREGATION */
       /* Unicast. More packets in queue for the neighbor? */
       burst_link_requested = 0;
       if(do_wait_for_ack
              && tsch_current_burst_count + 1 < TSCH_BURST_MAX_LEN
-             && tsch_queue_packet_count(&current_neighbor->addr) > 1) {
+             && tsch_queue_packet_count(&current_neighbor->addr) > aggregated_count) {
         burst_link_requested = 1;
         tsch_packet_set_frame_pending(packet, packet_len);
       }
@@ -536,6 +709,8 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
       if(packet_ready && NETSTACK_RADIO.prepare(packet, packet_len) == 0) { /* 0 means success */
         static rtimer_clock_t tx_duration;
 
+        PROFILER_ADD(TSCH_SLOT_PHASE_TX_PREPARE, profiler_phase_start);
+
 #if TSCH_CCA_ENABLED
         cca_status = 1;
         /* delay before CCA */
@@ -696,10 +871,37 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
     if(in_queue == 0) {
       dequeued_array[dequeued_index] = current_packet;
       ringbufindex_put(&dequeued_ringbuf);
+      update_pending_peak(&tsch_pending_stats.dequeued_peak, &dequeued_ringbuf);
+    }
+
+#if TSCH_WITH_AGGREGATION
+    /* The other packets of an aggregated frame share its outcome. On
+     * success, each is in turn the head of the queue. On failure, they
+     * stay queued unless they reached their transmission limit, which
+     * happens along with the first packet: they are then dropped too, each
+     * in turn the head of the queue */
+    for(i = 1; i < aggregated_count; i++) {
+      struct tsch_packet *p = aggregated_packets[i];
+      p->transmissions++;
+      p->ret = mac_tx_status;
+      if(mac_tx_status == MAC_TX_OK) {
+        tsch_queue_packet_sent(current_neighbor, p, current_link, mac_tx_status);
+      } else if(p->transmissions >= p->max_transmissions) {
+        /* CSMA state was already updated for the first packet */
+        tsch_queue_drop_aggregated_packet(current_neighbor, p);
+      } else {
+        continue;
+      }
+      /* Space was reserved by aggregate_packets */
+      dequeued_array[ringbufindex_peek_put(&dequeued_ringbuf)] = p;
+      ringbufindex_put(&dequeued_ringbuf);
+      update_pending_peak(&tsch_pending_stats.dequeued_peak, &dequeued_ringbuf);
     }
+#endif /* TSCH_WITH_AGGREGATION */
 
-    /* If this is an unicast packet to timesource, update stats */
-    if(current_neighbor != NULL && current_neighbor->is_time_source) {
+    /* If this is an unicast packet, update stats (kept for the time source
+     * and, if configured, for other neighbors) */
+    if(current_neighbor != NULL && !current_neighbor->is_broadcast) {
       tsch_stats_tx_packet(current_neighbor, mac_tx_status, tsch_current_channel);
     }
 
@@ -722,6 +924,11 @@ PT_THREAD(tsch_tx_slot(struct pt *pt, struct rtimer *t))
 
     /* Poll process for later processing of packet sent events and logs */
     process_poll(&tsch_pending_events_process);
+  } else {
+    /* No room to pass the outcome to the pending events process, the
+     * packet stays queued */
+    tsch_pending_stats.dequeued_overflows++;
+    process_poll(&tsch_pending_events_process);
   }
 
   TSCH_DEBUG_TX_EVENT();
@@ -754,6 +961,10 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
   input_index = ringbufindex_peek_put(&input_ringbuf);
   if(input_index == -1) {
     input_queue_drop++;
+    tsch_pending_stats.input_overflows++;
+    /* Have the pending events process free input buffers first */
+    tsch_rx_backpressure = 1;
+    process_poll(&tsch_pending_events_process);
   } else {
     static struct input_packet *current_input;
     /* Estimated drift based on RX time */
@@ -795,6 +1006,7 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
           current_slot_start, tsch_timing[tsch_ts_rx_offset] + tsch_timing[tsch_ts_rx_wait] + tsch_timing[tsch_ts_max_tx]);
       TSCH_DEBUG_RX_EVENT();
       tsch_radio_off(TSCH_RADIO_CMD_OFF_WITHIN_TIMESLOT);
+      PROFILER_MARK(profiler_phase_start);
 
       if(NETSTACK_RADIO.pending_packet()) {
         static int frame_valid;
@@ -903,6 +1115,7 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
 
                 /* Copy to radio buffer */
                 NETSTACK_RADIO.prepare((const void *)ack_buf, ack_len);
+                PROFILER_ADD(TSCH_SLOT_PHASE_RX_TO_ACK, profiler_phase_start);
 
                 /* Wait for time to ACK and transmit ACK */
                 TSCH_SCHEDULE_AND_YIELD(pt, t, rx_start_time,
@@ -933,6 +1146,11 @@ PT_THREAD(tsch_rx_slot(struct pt *pt, struct rtimer *t))
 
             /* Add current input to ringbuf */
             ringbufindex_put(&input_ringbuf);
+            update_pending_peak(&tsch_pending_stats.input_peak, &input_ringbuf);
+            if(ringbufindex_elements(&input_ringbuf) >= TSCH_RX_BACKPRESSURE_LEVEL) {
+              /* Running out of input buffers: drain them before the next Rx slot */
+              tsch_rx_backpressure = 1;
+            }
 
             /* If the neighbor is known, update its stats */
             if(n != NULL) {
@@ -1001,6 +1219,7 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
     } else {
       int is_active_slot;
       TSCH_DEBUG_SLOT_START();
+      PROFILER_MARK(profiler_slot_wakeup);
       tsch_in_slot_operation = 1;
       /* Measure on-air noise level while TSCH is idle */
       tsch_stats_sample_rssi();
@@ -1008,6 +1227,7 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
       drift_correction = 0;
       is_drift_correction_used = 0;
       /* Get a packet ready to be sent */
+      PROFILER_MARK(profiler_phase_start);
       current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
       /* There is no packet to send, and this link does not have Rx flag. Instead of doing
        * nothing, switch to the backup link (has Rx flag) if any. */
@@ -1015,6 +1235,25 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
         current_link = backup_link;
         current_packet = get_packet_and_neighbor_for_link(current_link, &current_neighbor);
       }
+#ifdef TSCH_CALLBACK_SKIP_TX_CHANNEL
+      /* Defer a unicast transmission when its channel is known to be bad
+       * towards the neighbor. The receiver listens as it would otherwise,
+       * so the two ends need not agree on anything. A neighbor's traffic
+       * is deferred at most TSCH_MAX_TX_CHANNEL_SKIPS times in a row */
+      if(current_packet != NULL && !burst_link_scheduled
+         && current_neighbor != NULL && !current_neighbor->is_broadcast) {
+        if(current_neighbor->tx_channel_skips < TSCH_MAX_TX_CHANNEL_SKIPS
+           && TSCH_CALLBACK_SKIP_TX_CHANNEL(current_neighbor,
+                tsch_calculate_channel(&tsch_current_asn,
+                                       current_link->channel_offset, current_packet))) {
+          current_neighbor->tx_channel_skips++;
+          current_packet = NULL;
+        } else {
+          current_neighbor->tx_channel_skips = 0;
+        }
+      }
+#endif /* TSCH_CALLBACK_SKIP_TX_CHANNEL */
+      PROFILER_ADD(TSCH_SLOT_PHASE_DEQUEUE, profiler_phase_start);
       is_active_slot = current_packet != NULL || (current_link->link_options & LINK_OPTION_RX);
       if(is_active_slot) {
         /* If we are in a burst, we stick to current channel instead of
@@ -1030,6 +1269,7 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
         NETSTACK_RADIO.set_value(RADIO_PARAM_CHANNEL, tsch_current_channel);
         /* Turn the radio on already here if configured so; necessary for radios with slow startup */
         tsch_radio_on(TSCH_RADIO_CMD_ON_START_OF_TIMESLOT);
+        PROFILER_ADD(TSCH_SLOT_PHASE_SETUP, profiler_slot_wakeup);
         /* Decide whether it is a TX/RX/IDLE or OFF slot */
         /* Actual slot operation */
         if(current_packet != NULL) {
@@ -1050,6 +1290,7 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
          * in a burst but now without any more packet to send. */
         burst_link_scheduled = 0;
       }
+      PROFILER_ADD(TSCH_SLOT_PHASE_SLOT_END, current_slot_start);
       TSCH_DEBUG_SLOT_END();
     }
 
@@ -1097,7 +1338,9 @@ PT_THREAD(tsch_slot_operation(struct rtimer *t, void *ptr))
           tsch_current_burst_count++;
         } else {
           /* Get next active link */
+          PROFILER_MARK(profiler_phase_start);
           current_link = tsch_schedule_get_next_active_link(&tsch_current_asn, &timeslot_diff, &backup_link);
+          PROFILER_ADD(TSCH_SLOT_PHASE_SCHEDULE, profiler_phase_start);
           if(current_link == NULL) {
             /* There is no next link. Fall back to default
              * behavior: wake up at the next slot. */
@@ -1138,6 +1381,9 @@ tsch_slot_operation_start(void)
   rtimer_clock_t time_to_next_active_slot;
   rtimer_clock_t prev_slot_start;
   TSCH_DEBUG_INIT();
+#if TSCH_WITH_AGGREGATION
+  aggregation_init();
+#endif /* TSCH_WITH_AGGREGATION */
   do {
     uint16_t timeslot_diff;
     /* Get next active link */
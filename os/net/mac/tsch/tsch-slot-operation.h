@@ -60,6 +60,48 @@ extern clock_time_t tsch_last_sync_time;
 /* Counts the length of the current burst */
 extern int tsch_current_burst_count;
 
+/** \brief Statistics on the rings passing packets from the slot operation
+ * to the TSCH pending events process */
+struct tsch_pending_stats {
+  uint16_t input_overflows;    /* Rx slots skipped for lack of an input buffer */
+  uint16_t dequeued_overflows; /* Tx slots skipped for lack of a dequeued entry */
+  uint8_t input_peak;          /* Max number of input packets pending at once */
+  uint8_t dequeued_peak;       /* Max number of sent packets pending at once */
+};
+extern struct tsch_pending_stats tsch_pending_stats;
+/* Set by the slot operation when the input ring reaches
+ * TSCH_RX_BACKPRESSURE_LEVEL or overflows, so that the pending events
+ * process drains the input ring before anything else */
+extern volatile uint8_t tsch_rx_backpressure;
+
+#if TSCH_SLOT_PROFILER
+/** \brief Phases of the slot operation measured by the slot profiler */
+enum tsch_slot_phase {
+  TSCH_SLOT_PHASE_DEQUEUE,     /* Selecting the packet and neighbor for a link */
+  TSCH_SLOT_PHASE_SETUP,       /* Wakeup to start of Tx/Rx: dequeue, hopping, radio on */
+  TSCH_SLOT_PHASE_TX_PREPARE,  /* Start of Tx to frame in radio buffer (incl. security) */
+  TSCH_SLOT_PHASE_RX_TO_ACK,   /* End of reception to ACK in radio buffer */
+  TSCH_SLOT_PHASE_SCHEDULE,    /* Next active link lookup */
+  TSCH_SLOT_PHASE_SLOT_END,    /* Slot start to end of the slot's processing */
+  TSCH_SLOT_PHASE_COUNT,       /* Not a phase */
+};
+
+/** \brief Duration statistics of a slot operation phase, in rtimer ticks */
+struct tsch_slot_phase_stats {
+  uint32_t count;
+  uint32_t total;
+  rtimer_clock_t max;
+  uint16_t histogram[TSCH_SLOT_PROFILER_BUCKETS];
+};
+
+/** \brief Slot profiler results */
+struct tsch_slot_profile {
+  struct tsch_slot_phase_stats phases[TSCH_SLOT_PHASE_COUNT];
+  /* Deadlines missed by tsch_schedule_slot_operation, and by how much */
+  struct tsch_slot_phase_stats deadline_misses;
+};
+#endif /* TSCH_SLOT_PROFILER */
+
 /********** Functions *********/
 
 /**
@@ -104,5 +146,20 @@ void tsch_slot_operation_sync(rtimer_clock_t next_slot_start,
  */
 void tsch_slot_operation_start(void);
 
+#if TSCH_SLOT_PROFILER
+/**
+ * Returns the slot profiler results
+ */
+const struct tsch_slot_profile *tsch_slot_profiler_get(void);
+/**
+ * Returns a printable name for a slot operation phase
+ */
+const char *tsch_slot_profiler_phase_name(enum tsch_slot_phase phase);
+/**
+ * Clears the slot profiler results
+ */
+void tsch_slot_profiler_reset(void);
+#endif /* TSCH_SLOT_PROFILER */
+
 #endif /* __TSCH_SLOT_OPERATION_H__ */
 /** @} */
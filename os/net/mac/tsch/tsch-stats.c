@@ -51,6 +51,16 @@
 struct tsch_global_stats tsch_stats;
 struct tsch_neighbor_stats tsch_neighbor_stats;
 
+#if TSCH_STATS_NUM_NEIGHBORS
+/* Stats of other unicast neighbors; unused entries have a null address */
+static struct {
+  linkaddr_t addr;
+  struct tsch_neighbor_stats stats;
+} other_neighbor_stats[TSCH_STATS_NUM_NEIGHBORS];
+/* The entry to recycle next */
+static uint8_t next_recycled;
+#endif /* TSCH_STATS_NUM_NEIGHBORS */
+
 /* Called every TSCH_STATS_DECAY_INTERVAL ticks */
 static struct ctimer periodic_timer;
 
@@ -75,13 +85,11 @@ tsch_stats_init(void)
   ctimer_set(&periodic_timer, TSCH_STATS_DECAY_INTERVAL / 10, periodic, NULL);
 }
 /*---------------------------------------------------------------------------*/
-void
-tsch_stats_reset_neighbor_stats(void)
+static void
+reset_channel_stats(struct tsch_channel_stats *ch_stats)
 {
   int i;
-  struct tsch_channel_stats *ch_stats;
 
-  ch_stats = tsch_neighbor_stats.channel_stats;
   for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
     ch_stats[i].rssi = TSCH_STATS_DEFAULT_RSSI;
     ch_stats[i].lqi = TSCH_STATS_DEFAULT_LQI;
@@ -89,22 +97,62 @@ tsch_stats_reset_neighbor_stats(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+tsch_stats_reset_neighbor_stats(void)
+{
+  reset_channel_stats(tsch_neighbor_stats.channel_stats);
+}
+/*---------------------------------------------------------------------------*/
 struct tsch_neighbor_stats *
 tsch_stats_get_from_neighbor(struct tsch_neighbor *n)
 {
-  /* Due to RAM limitations, this module only collects neighbor stats about the time source */
-  if(n != NULL && n->is_time_source) {
+#if TSCH_STATS_NUM_NEIGHBORS
+  int i;
+#endif /* TSCH_STATS_NUM_NEIGHBORS */
+
+  if(n == NULL) {
+    return NULL;
+  }
+  if(n->is_time_source) {
     return &tsch_neighbor_stats;
   }
+#if TSCH_STATS_NUM_NEIGHBORS
+  for(i = 0; i < TSCH_STATS_NUM_NEIGHBORS; ++i) {
+    if(linkaddr_cmp(&other_neighbor_stats[i].addr, &n->addr)) {
+      return &other_neighbor_stats[i].stats;
+    }
+  }
+#endif /* TSCH_STATS_NUM_NEIGHBORS */
+  /* Due to RAM limitations, stats are only collected about the time source
+   * and up to TSCH_STATS_NUM_NEIGHBORS other neighbors */
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Get the stats of a neighbor, allocating an entry for it if needed */
+static struct tsch_neighbor_stats *
+get_or_add_neighbor_stats(struct tsch_neighbor *n)
+{
+  struct tsch_neighbor_stats *stats;
+
+  stats = tsch_stats_get_from_neighbor(n);
+#if TSCH_STATS_NUM_NEIGHBORS
+  if(stats == NULL && n != NULL && !n->is_broadcast) {
+    /* Recycle the oldest entry */
+    linkaddr_copy(&other_neighbor_stats[next_recycled].addr, &n->addr);
+    stats = &other_neighbor_stats[next_recycled].stats;
+    reset_channel_stats(stats->channel_stats);
+    next_recycled = (next_recycled + 1) % TSCH_STATS_NUM_NEIGHBORS;
+  }
+#endif /* TSCH_STATS_NUM_NEIGHBORS */
+  return stats;
+}
+/*---------------------------------------------------------------------------*/
 void
 tsch_stats_tx_packet(struct tsch_neighbor *n, uint8_t mac_status, uint8_t channel)
 {
   struct tsch_neighbor_stats *stats;
 
-  stats = tsch_stats_get_from_neighbor(n);
+  stats = get_or_add_neighbor_stats(n);
   if(stats != NULL) {
     uint8_t index = tsch_stats_channel_to_index(channel);
     uint16_t new_tx_value = (mac_status == MAC_TX_OK ? 1 : 0);
@@ -187,6 +235,20 @@ tsch_stats_sample_rssi(void)
 #endif /* TSCH_STATS_SAMPLE_NOISE_RSSI */
 }
 /*---------------------------------------------------------------------------*/
+static void
+decay_channel_stats(struct tsch_channel_stats *stats)
+{
+  int i;
+
+  for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
+    /* decay Rx stats */
+    TSCH_STATS_EWMA_UPDATE(stats[i].rssi, TSCH_STATS_DEFAULT_RSSI);
+    TSCH_STATS_EWMA_UPDATE(stats[i].lqi, TSCH_STATS_DEFAULT_LQI);
+    /* decay Tx stats */
+    TSCH_STATS_EWMA_UPDATE(stats[i].p_tx_success, TSCH_STATS_DEFAULT_P_TX);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* Periodic timer called every TSCH_STATS_DECAY_INTERVAL ticks */
 static void
 periodic(void *ptr)
@@ -221,13 +283,14 @@ periodic(void *ptr)
   }
 
   /* Do not decay the periodic global stats, as they are updated independely of packet rate */
-  for(i = 0; i < TSCH_STATS_NUM_CHANNELS; ++i) {
-    /* decay Rx stats */
-    TSCH_STATS_EWMA_UPDATE(stats[i].rssi, TSCH_STATS_DEFAULT_RSSI);
-    TSCH_STATS_EWMA_UPDATE(stats[i].lqi, TSCH_STATS_DEFAULT_LQI);
-    /* decay Tx stats */
-    TSCH_STATS_EWMA_UPDATE(stats[i].p_tx_success, TSCH_STATS_DEFAULT_P_TX);
+  decay_channel_stats(stats);
+#if TSCH_STATS_NUM_NEIGHBORS
+  for(i = 0; i < TSCH_STATS_NUM_NEIGHBORS; ++i) {
+    if(!linkaddr_cmp(&other_neighbor_stats[i].addr, &linkaddr_null)) {
+      decay_channel_stats(other_neighbor_stats[i].stats.channel_stats);
+    }
   }
+#endif /* TSCH_STATS_NUM_NEIGHBORS */
 
   ctimer_set(&periodic_timer, TSCH_STATS_DECAY_INTERVAL, periodic, NULL);
 }
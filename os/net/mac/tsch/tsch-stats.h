@@ -85,6 +85,17 @@
 #define TSCH_STATS_BUSY_CHANNEL_RSSI -85
 #endif
 
+/*
+ * The number of unicast neighbors, besides the time source, whose per-channel
+ * stats are collected. The entries are recycled in the order they were
+ * allocated. Zero by default, as each entry takes about 100 bytes of RAM.
+ */
+#ifdef TSCH_STATS_CONF_NUM_NEIGHBORS
+#define TSCH_STATS_NUM_NEIGHBORS TSCH_STATS_CONF_NUM_NEIGHBORS
+#else
+#define TSCH_STATS_NUM_NEIGHBORS 0
+#endif
+
 /* The period after which stat values are decayed towards the default values */
 #ifdef TSCH_STATS_CONF_DECAY_INTERVAL
 #define TSCH_STATS_DECAY_INTERVAL TSCH_STATS_CONF_DECAY_INTERVAL
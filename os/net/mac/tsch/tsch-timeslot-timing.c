@@ -46,6 +46,11 @@
 #include "contiki.h"
 #include "net/mac/tsch/tsch.h"
 
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "TSCH"
+#define LOG_LEVEL LOG_LEVEL_MAC
+
 /**
  * \brief The default timeslot timing in the standard is a guard time of
  * 2200 us, a Tx offset of 2120 us and a Rx offset of 1120 us.
@@ -76,4 +81,114 @@ const tsch_timeslot_timing_usec tsch_timeslot_timing_us_10000 = {
   10000, /* TimeslotLength */
 };
 
+/**
+ * \brief A 5 ms timeslot timing, for high-rate deployments that exchange
+ * short frames. It doubles the number of cells per second compared to the
+ * 10 ms template at the cost of:
+ * - frames of at most 2400 us on air (72 bytes at 250 kbps, see
+ *   tsch_timeslot_timing_max_frame_len(). TSCH reports the reduced limit
+ *   through max_payload(), so that 6LoWPAN fragments larger packets);
+ * - a smaller Rx guard time (TSCH_CONF_RX_WAIT_5000, 800 us by default),
+ *   i.e. tighter synchronization;
+ * - shorter ACK turnarounds, which the radio and MCU must sustain.
+ * Use tsch_timeslot_timing_validate() (with TSCH_CONF_SLOT_PROFILER enabled
+ * for the processing times) to check that a platform keeps up.
+ */
+const tsch_timeslot_timing_usec tsch_timeslot_timing_us_5000 = {
+    480, /* CCAOffset */
+    128, /* CCA */
+    800, /* TxOffset */
+  (800 - (TSCH_CONF_RX_WAIT_5000 / 2)), /* RxOffset */
+    500, /* RxAckDelay */
+    700, /* TxAckDelay */
+  TSCH_CONF_RX_WAIT_5000, /* RxWait */
+    400, /* AckWait */
+    192, /* RxTx */
+   1000, /* MaxAck */
+   2400, /* MaxTx */
+   5000, /* TimeslotLength */
+};
+/*---------------------------------------------------------------------------*/
+int
+tsch_timeslot_timing_max_frame_len(const uint16_t *timing_us)
+{
+  int byte_air_time = RADIO_BYTE_AIR_TIME;
+  int len;
+
+  if(byte_air_time <= 0) {
+    /* Unknown bit rate, do not restrict */
+    return TSCH_PACKET_MAX_LEN;
+  }
+  len = timing_us[tsch_ts_max_tx] / byte_air_time - (int)RADIO_PHY_OVERHEAD;
+  return len > 0 ? len : 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+check_fits(const char *phase, uint32_t needed_us, uint32_t available_us)
+{
+  if(needed_us > available_us) {
+    LOG_WARN("! timing: %s needs %lu us, template allows %lu us\n",
+             phase, (unsigned long)needed_us, (unsigned long)available_us);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+#if TSCH_SLOT_PROFILER
+/* Worst processing time measured so far for a phase of the slot operation */
+static uint32_t
+measured_us(enum tsch_slot_phase phase)
+{
+  return RTIMERTICKS_TO_US(tsch_slot_profiler_get()->phases[phase].max);
+}
+#else /* TSCH_SLOT_PROFILER */
+#define measured_us(phase) 0
+#endif /* TSCH_SLOT_PROFILER */
+/*---------------------------------------------------------------------------*/
+int
+tsch_timeslot_timing_validate(const uint16_t *timing_us)
+{
+  int ok = 1;
+  uint32_t delay_tx = RTIMERTICKS_TO_US(RADIO_DELAY_BEFORE_TX);
+  uint32_t delay_rx = RTIMERTICKS_TO_US(RADIO_DELAY_BEFORE_RX);
+  uint32_t setup = measured_us(TSCH_SLOT_PHASE_SETUP);
+
+  /* CCA, then Rx-to-Tx turnaround, must complete before the frame starts */
+  ok &= check_fits("CCA", (uint32_t)timing_us[tsch_ts_cca_offset]
+                   + timing_us[tsch_ts_cca] + timing_us[tsch_ts_rx_tx],
+                   timing_us[tsch_ts_tx_offset]);
+  /* Wakeup, frame preparation and radio Tx delay before TxOffset */
+  ok &= check_fits("Tx setup",
+                   setup + measured_us(TSCH_SLOT_PHASE_TX_PREPARE) + delay_tx,
+                   timing_us[tsch_ts_tx_offset]);
+  /* Wakeup and radio Rx delay before RxOffset */
+  ok &= check_fits("Rx setup", setup + delay_rx, timing_us[tsch_ts_rx_offset]);
+  /* The Rx guard time must cover the expected start of the frame */
+  ok &= check_fits("Rx guard", timing_us[tsch_ts_tx_offset],
+                   (uint32_t)timing_us[tsch_ts_rx_offset] + timing_us[tsch_ts_rx_wait]);
+  /* The receiver turns the frame into an ACK in TxAckDelay */
+  ok &= check_fits("ACK preparation",
+                   measured_us(TSCH_SLOT_PHASE_RX_TO_ACK) + delay_tx,
+                   timing_us[tsch_ts_tx_ack_delay]);
+  /* The sender switches to Rx in RxAckDelay, then listens for the ACK
+   * to start during AckWait */
+  ok &= check_fits("ACK listen", delay_rx, timing_us[tsch_ts_rx_ack_delay]);
+  ok &= check_fits("ACK wait start", timing_us[tsch_ts_rx_ack_delay],
+                   timing_us[tsch_ts_tx_ack_delay]);
+  ok &= check_fits("ACK wait end", timing_us[tsch_ts_tx_ack_delay],
+                   (uint32_t)timing_us[tsch_ts_rx_ack_delay] + timing_us[tsch_ts_ack_wait]);
+  /* A full-length exchange must end within the timeslot */
+  ok &= check_fits("Tx exchange", (uint32_t)timing_us[tsch_ts_tx_offset]
+                   + timing_us[tsch_ts_max_tx] + timing_us[tsch_ts_tx_ack_delay]
+                   + timing_us[tsch_ts_max_ack],
+                   timing_us[tsch_ts_timeslot_length]);
+  /* The slot's processing, including finding the next active link, must be
+   * over before the next slot starts */
+  ok &= check_fits("slot processing", measured_us(TSCH_SLOT_PHASE_SLOT_END)
+                   + measured_us(TSCH_SLOT_PHASE_SCHEDULE),
+                   timing_us[tsch_ts_timeslot_length]);
+
+  return ok;
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -91,6 +91,10 @@ struct tsch_slotframe {
   struct tsch_asn_divisor_t size;
   /* List of links belonging to this slotframe */
   LIST_STRUCT(links_list);
+  /* Position and number of this slotframe's links in the schedule's
+   * timeslot-sorted link index */
+  uint16_t sorted_first;
+  uint16_t sorted_count;
 };
 
 /** \brief TSCH packet information */
@@ -103,6 +107,7 @@ struct tsch_packet {
   uint8_t ret; /* status -- MAC return code */
   uint8_t header_len; /* length of header and header IEs (needed for link-layer security) */
   uint8_t tsch_sync_ie_offset; /* Offset within the frame used for quick update of EB ASN and join priority */
+  uint8_t queue_class; /* Traffic class, i.e. the neighbor ringbuf holding the packet */
 };
 
 /** \brief TSCH neighbor information */
@@ -117,11 +122,18 @@ struct tsch_neighbor {
   uint8_t last_backoff_window; /* Last CSMA backoff window */
   uint8_t tx_links_count; /* How many links do we have to this neighbor? */
   uint8_t dedicated_tx_links_count; /* How many dedicated links do we have to this neighbor? */
-  /* Array for the ringbuf. Contains pointers to packets.
-   * Its size must be a power of two to allow for atomic put */
-  struct tsch_packet *tx_array[TSCH_QUEUE_NUM_PER_NEIGHBOR];
-  /* Circular buffer of pointers to packet. */
-  struct ringbufindex tx_ringbuf;
+  /* Arrays for the ringbufs, one per traffic class. Contain pointers to packets.
+   * Their size must be a power of two to allow for atomic put */
+  struct tsch_packet *tx_array[TSCH_QUEUE_NUM_CLASSES][TSCH_QUEUE_NUM_PER_NEIGHBOR];
+  /* Circular buffers of pointers to packet, one per traffic class */
+  struct ringbufindex tx_ringbuf[TSCH_QUEUE_NUM_CLASSES];
+#if TSCH_QUEUE_NUM_CLASSES > 1 && TSCH_QUEUE_SERVICE == TSCH_QUEUE_SERVICE_WEIGHTED
+  uint8_t wrr_class; /* Class currently served */
+  uint8_t wrr_credit; /* Packets the class may still send in this round */
+#endif
+#ifdef TSCH_CALLBACK_SKIP_TX_CHANNEL
+  uint8_t tx_channel_skips; /* Transmissions deferred in a row due to a bad channel */
+#endif
 };
 
 /** \brief TSCH timeslot timing elements. Used to index timeslot timing
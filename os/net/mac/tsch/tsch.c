@@ -92,6 +92,14 @@ NBR_TABLE(struct eb_stat, eb_stats);
 uint8_t tsch_hopping_sequence[TSCH_HOPPING_SEQUENCE_MAX_LEN];
 struct tsch_asn_divisor_t tsch_hopping_sequence_length;
 
+#if TSCH_SCAN_WITH_HINTS
+/* Where the network was when we last associated: the channel we received
+ * its EB on, and its hopping sequence. Survives leaving the network. */
+static uint8_t scan_hint_channel;
+static uint8_t scan_hint_sequence[TSCH_HOPPING_SEQUENCE_MAX_LEN];
+static uint8_t scan_hint_sequence_len;
+#endif /* TSCH_SCAN_WITH_HINTS */
+
 /* Default TSCH timeslot timing (in micro-second) */
 static const uint16_t *tsch_default_timing_us;
 /* TSCH timeslot timing (in micro-second) */
@@ -199,13 +207,41 @@ tsch_set_eb_period(uint32_t period)
   tsch_current_eb_period = MIN(period, TSCH_MAX_EB_PERIOD);
 }
 /*---------------------------------------------------------------------------*/
+int
+tsch_set_timeslot_timing(const uint16_t *timing_us)
+{
+  static tsch_timeslot_timing_usec custom_timing_us;
+  int i;
+
+  if(tsch_is_associated) {
+    LOG_WARN("! can't change timeslot timing while associated\n");
+    return 0;
+  }
+  if(!tsch_timeslot_timing_validate(timing_us)) {
+    return 0;
+  }
+  memcpy(custom_timing_us, timing_us, sizeof(custom_timing_us));
+  tsch_default_timing_us = custom_timing_us;
+  for(i = 0; i < tsch_ts_elements_count; i++) {
+    tsch_timing_us[i] = tsch_default_timing_us[i];
+    tsch_timing[i] = US_TO_RTIMERTICKS(tsch_timing_us[i]);
+  }
+  LOG_INFO("timeslot length set to %u us, max frame length %d\n",
+           tsch_timing_us[tsch_ts_timeslot_length],
+           tsch_timeslot_timing_max_frame_len(tsch_timing_us));
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static void
 tsch_reset(void)
 {
   int i;
   frame802154_set_pan_id(0xffff);
   /* First make sure pending packet callbacks are sent etc */
-  process_post_synch(&tsch_pending_events_process, PROCESS_EVENT_POLL, NULL);
+  do {
+    process_post_synch(&tsch_pending_events_process, PROCESS_EVENT_POLL, NULL);
+  } while(!ringbufindex_empty(&input_ringbuf)
+          || !ringbufindex_empty(&dequeued_ringbuf));
   /* Reset neighbor queues */
   tsch_queue_reset();
   /* Remove unused neighbors */
@@ -216,7 +252,6 @@ tsch_reset(void)
   TSCH_ASN_INIT(tsch_current_asn, 0, 0);
   current_link = NULL;
   /* Reset timeslot timing to defaults */
-  tsch_default_timing_us = TSCH_DEFAULT_TIMESLOT_TIMING;
   for(i = 0; i < tsch_ts_elements_count; i++) {
     tsch_timing_us[i] = tsch_default_timing_us[i];
     tsch_timing[i] = US_TO_RTIMERTICKS(tsch_timing_us[i]);
@@ -316,6 +351,7 @@ keepalive_send(void *ptr)
         /* Simply send an empty packet */
         packetbuf_clear();
         packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &n->addr);
+        packetbuf_set_attr(PACKETBUF_ATTR_PRIORITY, PACKETBUF_ATTR_PRIORITY_CONTROL);
         NETSTACK_MAC.send(keepalive_packet_sent, NULL);
         LOG_INFO("sending KA to ");
         LOG_INFO_LLADDR(&n->addr);
@@ -480,13 +516,14 @@ eb_input(struct input_packet *current_input)
   }
 }
 /*---------------------------------------------------------------------------*/
-/* Process pending input packet(s) */
-static void
-tsch_rx_process_pending()
+/* Process up to max pending input packets. Returns the number of packets
+ * left in the ring */
+static int
+tsch_rx_process_pending(int max)
 {
   int16_t input_index;
   /* Loop on accessing (without removing) a pending input packet */
-  while((input_index = ringbufindex_peek_get(&input_ringbuf)) != -1) {
+  while(max-- > 0 && (input_index = ringbufindex_peek_get(&input_ringbuf)) != -1) {
     struct input_packet *current_input = &input_array[input_index];
     frame802154_t frame;
     uint8_t ret = frame802154_parse(current_input->payload, current_input->len, &frame);
@@ -513,15 +550,17 @@ tsch_rx_process_pending()
     /* Remove input from ringbuf */
     ringbufindex_get(&input_ringbuf);
   }
+  return ringbufindex_elements(&input_ringbuf);
 }
 /*---------------------------------------------------------------------------*/
-/* Pass sent packets to upper layer */
-static void
-tsch_tx_process_pending(void)
+/* Pass up to max sent packets to upper layer. Returns the number of packets
+ * left in the ring */
+static int
+tsch_tx_process_pending(int max)
 {
   int16_t dequeued_index;
   /* Loop on accessing (without removing) a pending input packet */
-  while((dequeued_index = ringbufindex_peek_get(&dequeued_ringbuf)) != -1) {
+  while(max-- > 0 && (dequeued_index = ringbufindex_peek_get(&dequeued_ringbuf)) != -1) {
     struct tsch_packet *p = dequeued_array[dequeued_index];
     /* Put packet into packetbuf for packet_sent callback */
     queuebuf_to_packetbuf(p->qb);
@@ -538,6 +577,56 @@ tsch_tx_process_pending(void)
     /* Remove dequeued packet from ringbuf */
     ringbufindex_get(&dequeued_ringbuf);
   }
+  return ringbufindex_elements(&dequeued_ringbuf);
+}
+/*---------------------------------------------------------------------------*/
+void
+tsch_set_scan_hints(uint8_t channel, const uint8_t *hopping_sequence, uint8_t len)
+{
+#if TSCH_SCAN_WITH_HINTS
+  scan_hint_channel = channel;
+  if(hopping_sequence == NULL || len > sizeof(scan_hint_sequence)) {
+    len = 0;
+  }
+  if(len > 0) {
+    memcpy(scan_hint_sequence, hopping_sequence, len);
+  }
+  scan_hint_sequence_len = len;
+#endif /* TSCH_SCAN_WITH_HINTS */
+}
+/*---------------------------------------------------------------------------*/
+int
+tsch_get_scan_hints(uint8_t *channel, uint8_t *hopping_sequence, uint8_t max_len)
+{
+#if TSCH_SCAN_WITH_HINTS
+  if(scan_hint_channel == 0 || scan_hint_sequence_len > max_len) {
+    return 0;
+  }
+  *channel = scan_hint_channel;
+  memcpy(hopping_sequence, scan_hint_sequence, scan_hint_sequence_len);
+  return scan_hint_sequence_len;
+#else /* TSCH_SCAN_WITH_HINTS */
+  return 0;
+#endif /* TSCH_SCAN_WITH_HINTS */
+}
+/*---------------------------------------------------------------------------*/
+/* Pick the next channel to scan. 'tries' counts the channel switches since
+ * we started scanning. */
+static uint8_t
+tsch_scan_next_channel(unsigned tries)
+{
+#if TSCH_SCAN_WITH_HINTS
+  if(scan_hint_channel != 0 && tries < TSCH_SCAN_HINT_TRIES) {
+    if(tries == 0 || scan_hint_sequence_len == 0) {
+      /* Where we last heard the network */
+      return scan_hint_channel;
+    }
+    /* Any channel the network hops over */
+    return scan_hint_sequence[random_rand() % scan_hint_sequence_len];
+  }
+#endif /* TSCH_SCAN_WITH_HINTS */
+  /* Pick a channel at random in TSCH_JOIN_HOPPING_SEQUENCE */
+  return TSCH_JOIN_HOPPING_SEQUENCE[random_rand() % sizeof(TSCH_JOIN_HOPPING_SEQUENCE)];
 }
 /*---------------------------------------------------------------------------*/
 /* Setup TSCH as a coordinator */
@@ -760,15 +849,19 @@ PT_THREAD(tsch_scan(struct pt *pt))
   static struct etimer scan_timer;
   /* Time when we started scanning on current_channel */
   static clock_time_t current_channel_since;
+  /* Number of channel switches since we started scanning */
+  static unsigned scan_tries;
+  /* Hop to any channel offset */
+  static uint8_t current_channel;
 
   TSCH_ASN_INIT(tsch_current_asn, 0, 0);
 
   etimer_set(&scan_timer, CLOCK_SECOND / TSCH_ASSOCIATION_POLL_FREQUENCY);
   current_channel_since = clock_time();
+  current_channel = 0;
+  scan_tries = 0;
 
   while(!tsch_is_associated && !tsch_is_coordinator) {
-    /* Hop to any channel offset */
-    static uint8_t current_channel = 0;
 
     /* We are not coordinator, try to associate */
     rtimer_clock_t t0;
@@ -777,9 +870,7 @@ PT_THREAD(tsch_scan(struct pt *pt))
 
     /* Switch to a (new) channel for scanning */
     if(current_channel == 0 || now_time - current_channel_since > TSCH_CHANNEL_SCAN_DURATION) {
-      /* Pick a channel at random in TSCH_JOIN_HOPPING_SEQUENCE */
-      uint8_t scan_channel = TSCH_JOIN_HOPPING_SEQUENCE[
-          random_rand() % sizeof(TSCH_JOIN_HOPPING_SEQUENCE)];
+      uint8_t scan_channel = tsch_scan_next_channel(scan_tries++);
 
       NETSTACK_RADIO.set_value(RADIO_PARAM_CHANNEL, scan_channel);
       current_channel = scan_channel;
@@ -826,6 +917,11 @@ PT_THREAD(tsch_scan(struct pt *pt))
     if(tsch_is_associated) {
       /* End of association, turn the radio off */
       NETSTACK_RADIO.off();
+#if TSCH_SCAN_WITH_HINTS
+      /* Remember where we found the network, for the next time */
+      tsch_set_scan_hints(current_channel, tsch_hopping_sequence,
+                          tsch_hopping_sequence_length.val);
+#endif /* TSCH_SCAN_WITH_HINTS */
     } else if(!tsch_is_coordinator) {
       /* Go back to scanning */
       etimer_reset(&scan_timer);
@@ -943,11 +1039,23 @@ PROCESS_THREAD(tsch_send_eb_process, ev, data)
  * callbacks, outputs pending logs. */
 PROCESS_THREAD(tsch_pending_events_process, ev, data)
 {
+  static int pending;
+
   PROCESS_BEGIN();
   while(1) {
     PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
-    tsch_rx_process_pending();
-    tsch_tx_process_pending();
+    if(tsch_rx_backpressure) {
+      /* The slot operation is running out of input buffers: free them all */
+      tsch_rx_backpressure = 0;
+      pending = tsch_rx_process_pending(TSCH_MAX_INCOMING_PACKETS);
+    } else {
+      pending = tsch_rx_process_pending(TSCH_PENDING_BATCH_SIZE);
+    }
+    pending += tsch_tx_process_pending(TSCH_PENDING_BATCH_SIZE);
+    if(pending > 0) {
+      /* Let other processes run before the next batch */
+      process_poll(&tsch_pending_events_process);
+    }
     tsch_log_process_pending();
     tsch_keepalive_process_pending();
 #ifdef TSCH_CALLBACK_SELECT_CHANNELS
@@ -974,6 +1082,13 @@ tsch_init(void)
     LOG_ERR("! platform does not provide a timeslot timing template.\n");
     return;
   }
+  /* Keep a template set with tsch_set_timeslot_timing before init */
+  if(tsch_default_timing_us == NULL) {
+    tsch_default_timing_us = TSCH_DEFAULT_TIMESLOT_TIMING;
+  }
+  if(!tsch_timeslot_timing_validate(tsch_default_timing_us)) {
+    LOG_WARN("! timeslot timing template does not fit this platform\n");
+  }
 
   /* Check that the radio can correctly report its max supported payload */
   if(NETSTACK_RADIO.get_value(RADIO_CONST_MAX_PAYLOAD_LEN, &radio_max_payload_len) != RADIO_RESULT_OK) {
@@ -1135,6 +1250,34 @@ send_packet(mac_callback_t sent, void *ptr)
     mac_call_sent_callback(sent, ptr, ret, 1);
   }
 }
+#if TSCH_WITH_AGGREGATION
+/*---------------------------------------------------------------------------*/
+/* Pass each packet of an aggregated frame in packetbuf to the upper layer,
+ * with the attributes of the frame */
+static void
+aggregated_input(void)
+{
+  static uint8_t payload[TSCH_PACKET_MAX_LEN];
+  static struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  static struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+  const uint8_t *entry;
+  int payload_len;
+  int offset = 0;
+  int len;
+
+  payload_len = MIN(packetbuf_datalen(), sizeof(payload));
+  memcpy(payload, packetbuf_dataptr(), payload_len);
+  packetbuf_attr_copyto(attrs, addrs);
+
+  while((len = tsch_packet_aggregation_next(payload, payload_len, &offset, &entry)) > 0) {
+    packetbuf_clear();
+    packetbuf_attr_copyfrom(attrs, addrs);
+    memcpy(packetbuf_dataptr(), entry, len);
+    packetbuf_set_datalen(len);
+    NETSTACK_NETWORK.input();
+  }
+}
+#endif /* TSCH_WITH_AGGREGATION */
 /*---------------------------------------------------------------------------*/
 static void
 packet_input(void)
@@ -1166,6 +1309,13 @@ packet_input(void)
       LOG_INFO("received from ");
       LOG_INFO_LLADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
       LOG_INFO_(" with seqno %u\n", packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO));
+#if TSCH_WITH_AGGREGATION
+      if(packetbuf_datalen() > 0
+         && *(uint8_t *)packetbuf_dataptr() == TSCH_AGGREGATION_DISPATCH) {
+        aggregated_input();
+        return;
+      }
+#endif /* TSCH_WITH_AGGREGATION */
 #if TSCH_WITH_SIXTOP
       sixtop_input();
 #endif /* TSCH_WITH_SIXTOP */
@@ -1221,6 +1371,10 @@ max_payload(void)
     return 0;
   }
 
+  /* Frames must also fit the timeslot's MaxTx */
+  max_radio_payload_len = MIN(max_radio_payload_len,
+                              tsch_timeslot_timing_max_frame_len(tsch_timing_us));
+
   /* Setup security... before. */
   return MIN(max_radio_payload_len, TSCH_PACKET_MAX_LEN)
     - framer_hdrlen
@@ -132,6 +132,13 @@ int TSCH_RPL_CHECK_DODAG_JOINED();
 int TSCH_CALLBACK_DO_NACK(struct tsch_link *link, linkaddr_t *src, linkaddr_t *dst);
 #endif
 
+/* Called by TSCH from interrupt before a unicast transmission, enables
+ * deferring it when the channel is known to be bad towards the neighbor */
+#ifdef TSCH_CALLBACK_SKIP_TX_CHANNEL
+struct tsch_neighbor;
+int TSCH_CALLBACK_SKIP_TX_CHANNEL(struct tsch_neighbor *n, uint8_t channel);
+#endif
+
 /* Called by TSCH when switching time source */
 #ifdef TSCH_CALLBACK_NEW_TIME_SOURCE
 struct tsch_neighbor;
@@ -178,6 +185,8 @@ extern int32_t min_drift_seen;
 extern int32_t max_drift_seen;
 /* The TSCH standard 10ms timeslot timing */
 extern const tsch_timeslot_timing_usec tsch_timeslot_timing_us_10000;
+/* A 5ms timeslot timing for short frames, see tsch-timeslot-timing.c */
+extern const tsch_timeslot_timing_usec tsch_timeslot_timing_us_5000;
 
 /* TSCH processes */
 PROCESS_NAME(tsch_process);
@@ -244,6 +253,49 @@ uint64_t tsch_get_network_uptime_ticks(void);
   * Leave the TSCH network we are currently in
   */
 void tsch_disassociate(void);
+/**
+ * Set the timeslot timing template used when not joining through an EB
+ * that carries its own timing (and the one a coordinator advertises).
+ * Only possible while not associated; the template is copied.
+ *
+ * \param timing_us The timing template, in micro-seconds
+ * \return 1 if the template was applied, 0 if associated or invalid
+ */
+int tsch_set_timeslot_timing(const uint16_t *timing_us);
+/**
+ * Check that each phase of a timeslot timing template fits the radio
+ * turnaround delays (RADIO_DELAY_BEFORE_*) and, with TSCH_SLOT_PROFILER
+ * enabled, the worst processing times measured so far. Violations are logged.
+ *
+ * \param timing_us The timing template, in micro-seconds
+ * \return 1 if every phase fits, 0 otherwise
+ */
+int tsch_timeslot_timing_validate(const uint16_t *timing_us);
+/**
+ * Get the longest frame that fits a timing template's MaxTx
+ *
+ * \param timing_us The timing template, in micro-seconds
+ * \return The maximum frame length in bytes
+ */
+int tsch_timeslot_timing_max_frame_len(const uint16_t *timing_us);
+/**
+ * Set the scan hints used with TSCH_SCAN_WITH_HINTS, e.g. to restore
+ * hints saved to persistent storage before a reboot
+ *
+ * \param channel The channel to scan first, 0 for none
+ * \param hopping_sequence The hopping sequence of the network, may be NULL
+ * \param len The length of the hopping sequence
+ */
+void tsch_set_scan_hints(uint8_t channel, const uint8_t *hopping_sequence, uint8_t len);
+/**
+ * Get the current scan hints, i.e. those of the last association
+ *
+ * \param channel Where to store the channel the last EB was received on
+ * \param hopping_sequence Where to store the hopping sequence
+ * \param max_len The size of hopping_sequence
+ * \return The length of the hopping sequence, 0 if there are no hints
+ */
+int tsch_get_scan_hints(uint8_t *channel, uint8_t *hopping_sequence, uint8_t max_len);
 
 #endif /* __TSCH_H__ */
 /** @} */
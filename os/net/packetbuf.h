@@ -209,6 +209,11 @@ struct packetbuf_addr {
 #define PACKETBUF_ATTR_PACKET_TYPE_STREAM_END 3
 #define PACKETBUF_ATTR_PACKET_TYPE_TIMESTAMP 4
 
+/* Values of PACKETBUF_ATTR_PRIORITY, used by MAC layers to queue packets */
+#define PACKETBUF_ATTR_PRIORITY_BEST_EFFORT  0
+#define PACKETBUF_ATTR_PRIORITY_HIGH         1
+#define PACKETBUF_ATTR_PRIORITY_CONTROL      2
+
 enum {
   PACKETBUF_ATTR_NONE,
 
@@ -221,9 +226,11 @@ enum {
   PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
   PACKETBUF_ATTR_MAC_SEQNO,
   PACKETBUF_ATTR_MAC_ACK,
+  PACKETBUF_ATTR_MAC_PENDING,
   PACKETBUF_ATTR_MAC_METADATA,
   PACKETBUF_ATTR_MAC_NO_SRC_ADDR,
   PACKETBUF_ATTR_MAC_NO_DEST_ADDR,
+  PACKETBUF_ATTR_PRIORITY,
 #if TSCH_WITH_LINK_SELECTOR
   PACKETBUF_ATTR_TSCH_SLOTFRAME,
   PACKETBUF_ATTR_TSCH_TIMESLOT,
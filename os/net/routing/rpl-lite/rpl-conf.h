@@ -284,6 +284,16 @@
 #define RPL_PROBING_INTERVAL (90 * CLOCK_SECOND)
 #endif
 
+/*
+ * RPL probing interval while a neighbor is in its probing burst, i.e. while
+ * its link is new (see LINK_STATS_CONF_PROBE_BURST)
+ */
+#ifdef RPL_CONF_PROBING_BURST_INTERVAL
+#define RPL_PROBING_BURST_INTERVAL RPL_CONF_PROBING_BURST_INTERVAL
+#else
+#define RPL_PROBING_BURST_INTERVAL (2 * CLOCK_SECOND)
+#endif
+
 /*
  * Function used to calculate next RPL probing interval
  */
@@ -326,6 +336,81 @@
 #define RPL_DAO_RETRANSMISSION_TIMEOUT    (5 * CLOCK_SECOND)
 #endif /* RPL_CONF_DAO_RETRANSMISSION_TIMEOUT */
 
+/*
+ * DAO aggregation, for non-storing mode. When enabled, nodes send their DAO
+ * to their preferred parent instead of the root. Non-root nodes acknowledge
+ * the targets they receive and buffer them (up to
+ * RPL_DAO_AGGREGATION_MAX_TARGETS), then advertise them along with their own
+ * target in a single DAO sent within RPL_DAO_AGGREGATION_DELAY. The root
+ * processes all targets of a DAO at once and acknowledges them with a single
+ * DAO-ACK. Must be enabled on all nodes of the network.
+ */
+#ifdef RPL_CONF_WITH_DAO_AGGREGATION
+#define RPL_WITH_DAO_AGGREGATION RPL_CONF_WITH_DAO_AGGREGATION
+#else /* RPL_CONF_WITH_DAO_AGGREGATION */
+#define RPL_WITH_DAO_AGGREGATION 0
+#endif /* RPL_CONF_WITH_DAO_AGGREGATION */
+
+#ifdef RPL_CONF_DAO_AGGREGATION_MAX_TARGETS
+#define RPL_DAO_AGGREGATION_MAX_TARGETS RPL_CONF_DAO_AGGREGATION_MAX_TARGETS
+#else /* RPL_CONF_DAO_AGGREGATION_MAX_TARGETS */
+#define RPL_DAO_AGGREGATION_MAX_TARGETS 8
+#endif /* RPL_CONF_DAO_AGGREGATION_MAX_TARGETS */
+
+#ifdef RPL_CONF_DAO_AGGREGATION_DELAY
+#define RPL_DAO_AGGREGATION_DELAY RPL_CONF_DAO_AGGREGATION_DELAY
+#else /* RPL_CONF_DAO_AGGREGATION_DELAY */
+#define RPL_DAO_AGGREGATION_DELAY (CLOCK_SECOND * 2)
+#endif /* RPL_CONF_DAO_AGGREGATION_DELAY */
+
+/*
+ * Projected routes, for non-storing mode. When enabled, the root counts the
+ * packets it forwards between pairs of nodes of the DODAG. A pair exceeding
+ * RPL_PROJECTED_ROUTE_THRESHOLD packets per minute, and whose path does not
+ * need to go through the root, gets a projected route: the root sends the
+ * source a projected DAO listing the hops up to the common ancestor and
+ * down to the destination. The source then inserts this source route in
+ * its packets, which bypass the root, for RPL_PROJECTED_ROUTE_LIFETIME
+ * seconds. The root tracks up to RPL_PROJECTED_ROUTE_FLOWS pairs, and
+ * every node stores up to RPL_PROJECTED_ROUTE_NUM projected routes of up
+ * to RPL_PROJECTED_ROUTE_MAX_HOPS hops.
+ */
+#ifdef RPL_CONF_WITH_PROJECTED_ROUTES
+#define RPL_WITH_PROJECTED_ROUTES RPL_CONF_WITH_PROJECTED_ROUTES
+#else /* RPL_CONF_WITH_PROJECTED_ROUTES */
+#define RPL_WITH_PROJECTED_ROUTES 0
+#endif /* RPL_CONF_WITH_PROJECTED_ROUTES */
+
+#ifdef RPL_CONF_PROJECTED_ROUTE_THRESHOLD
+#define RPL_PROJECTED_ROUTE_THRESHOLD RPL_CONF_PROJECTED_ROUTE_THRESHOLD
+#else /* RPL_CONF_PROJECTED_ROUTE_THRESHOLD */
+#define RPL_PROJECTED_ROUTE_THRESHOLD 10
+#endif /* RPL_CONF_PROJECTED_ROUTE_THRESHOLD */
+
+#ifdef RPL_CONF_PROJECTED_ROUTE_LIFETIME
+#define RPL_PROJECTED_ROUTE_LIFETIME RPL_CONF_PROJECTED_ROUTE_LIFETIME
+#else /* RPL_CONF_PROJECTED_ROUTE_LIFETIME */
+#define RPL_PROJECTED_ROUTE_LIFETIME (5 * 60)
+#endif /* RPL_CONF_PROJECTED_ROUTE_LIFETIME */
+
+#ifdef RPL_CONF_PROJECTED_ROUTE_FLOWS
+#define RPL_PROJECTED_ROUTE_FLOWS RPL_CONF_PROJECTED_ROUTE_FLOWS
+#else /* RPL_CONF_PROJECTED_ROUTE_FLOWS */
+#define RPL_PROJECTED_ROUTE_FLOWS 8
+#endif /* RPL_CONF_PROJECTED_ROUTE_FLOWS */
+
+#ifdef RPL_CONF_PROJECTED_ROUTE_NUM
+#define RPL_PROJECTED_ROUTE_NUM RPL_CONF_PROJECTED_ROUTE_NUM
+#else /* RPL_CONF_PROJECTED_ROUTE_NUM */
+#define RPL_PROJECTED_ROUTE_NUM 4
+#endif /* RPL_CONF_PROJECTED_ROUTE_NUM */
+
+#ifdef RPL_CONF_PROJECTED_ROUTE_MAX_HOPS
+#define RPL_PROJECTED_ROUTE_MAX_HOPS RPL_CONF_PROJECTED_ROUTE_MAX_HOPS
+#else /* RPL_CONF_PROJECTED_ROUTE_MAX_HOPS */
+#define RPL_PROJECTED_ROUTE_MAX_HOPS 8
+#endif /* RPL_CONF_PROJECTED_ROUTE_MAX_HOPS */
+
 /******************************************************************************/
 /************************** More parameterization *****************************/
 /******************************************************************************/
@@ -360,6 +445,39 @@
 #define RPL_SIGNIFICANT_CHANGE_THRESHOLD             RPL_CONF_SIGNIFICANT_CHANGE_THRESHOLD
 #endif /* RPL_CONF_SIGNIFICANT_CHANGE_THRESHOLD */
 
+/*
+ * The number of DODAGs of our instance a node keeps track of. A node is
+ * part of one DODAG at a time. With a value above 1, it also remembers the
+ * best DIO recently heard from up to RPL_MAX_DAG_PER_INSTANCE - 1 other
+ * DODAGs, e.g. rooted at redundant border routers. It moves to one of them
+ * as soon as it loses its preferred parent, or when one offers a better
+ * rank by more than RPL_DAG_SWITCH_THRESHOLD, at most once every five
+ * minutes. Ranks in other DODAGs are estimated with their OF.
+ */
+#ifndef RPL_CONF_MAX_DAG_PER_INSTANCE
+#define RPL_MAX_DAG_PER_INSTANCE             1
+#else /* RPL_CONF_MAX_DAG_PER_INSTANCE */
+#define RPL_MAX_DAG_PER_INSTANCE             RPL_CONF_MAX_DAG_PER_INSTANCE
+#endif /* RPL_CONF_MAX_DAG_PER_INSTANCE */
+
+#ifndef RPL_CONF_DAG_SWITCH_THRESHOLD
+#define RPL_DAG_SWITCH_THRESHOLD             (RPL_MIN_HOPRANKINC / 2)
+#else /* RPL_CONF_DAG_SWITCH_THRESHOLD */
+#define RPL_DAG_SWITCH_THRESHOLD             RPL_CONF_DAG_SWITCH_THRESHOLD
+#endif /* RPL_CONF_DAG_SWITCH_THRESHOLD */
+
+/*
+ * When comparing DODAGs, a node adds to the rank of each a bias in
+ * [0, RPL_DAG_LOAD_SPLIT_BIAS[, derived from its own link-layer address and
+ * the DODAG ID. Nodes at similar distances from several roots thereby
+ * spread over them, splitting the upward traffic. 0 disables the bias.
+ */
+#ifndef RPL_CONF_DAG_LOAD_SPLIT_BIAS
+#define RPL_DAG_LOAD_SPLIT_BIAS              (2 * RPL_MIN_HOPRANKINC)
+#else /* RPL_CONF_DAG_LOAD_SPLIT_BIAS */
+#define RPL_DAG_LOAD_SPLIT_BIAS              RPL_CONF_DAG_LOAD_SPLIT_BIAS
+#endif /* RPL_CONF_DAG_LOAD_SPLIT_BIAS */
+
 /* This value decides which DAG instance we should participate in by default. */
 #ifdef RPL_CONF_DEFAULT_INSTANCE
 #define RPL_DEFAULT_INSTANCE RPL_CONF_DEFAULT_INSTANCE
@@ -112,12 +112,15 @@
 #define RPL_OPTION_SOLICITED_INFO        7
 #define RPL_OPTION_PREFIX_INFO           8
 #define RPL_OPTION_TARGET_DESC           9
+#define RPL_OPTION_SR_VIO                0x0F /* Source-routed Via Information (projected routes) */
 
 #define RPL_DAO_K_FLAG                   0x80 /* DAO-ACK requested */
 #define RPL_DAO_D_FLAG                   0x40 /* DODAG ID present */
+#define RPL_DAO_P_FLAG                   0x20 /* Projected DAO, sent by the root */
 
 #define RPL_DAO_ACK_UNCONDITIONAL_ACCEPT 0
 #define RPL_DAO_ACK_ACCEPT               1   /* 1 - 127 is OK but not good */
+#define RPL_DAO_ACK_TRY_LATER            2   /* Parent out of DAO aggregation room: send the DAO again later */
 #define RPL_DAO_ACK_UNABLE_TO_ACCEPT     128 /* >127 is fail */
 #define RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT 255 /* root can not accept */
 #define RPL_DAO_ACK_TIMEOUT              -1
@@ -56,6 +56,13 @@
 extern rpl_of_t rpl_of0, rpl_mrhof;
 static rpl_of_t * const objective_functions[] = RPL_SUPPORTED_OFS;
 static int process_dio_init_dag(rpl_dio_t *dio);
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+static void switch_to_alt_dag(int failover);
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
+#if RPL_WITH_DAO_AGGREGATION
+/* Targets received from children, to be advertised in our next DAO */
+static rpl_dao_agg_target_t dao_agg_targets[RPL_DAO_AGGREGATION_MAX_TARGETS];
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
 /*---------------------------------------------------------------------------*/
 /* Allocate instance table. */
@@ -95,8 +102,8 @@ rpl_dag_get_root_ipaddr(uip_ipaddr_t *ipaddr)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
-void
-rpl_dag_leave(void)
+static void
+leave_dag(int forget_links)
 {
   LOG_INFO("leaving DAG ");
   LOG_INFO_6ADDR(&curr_instance.dag.dag_id);
@@ -109,11 +116,19 @@ rpl_dag_leave(void)
   }
 
   /* Forget past link statistics */
-  link_stats_reset();
+  if(forget_links) {
+    link_stats_reset();
+  }
 
   /* Remove all neighbors, links and default route */
   rpl_neighbor_remove_all();
   uip_sr_free_all();
+#if RPL_WITH_DAO_AGGREGATION
+  memset(dao_agg_targets, 0, sizeof(dao_agg_targets));
+#endif /* RPL_WITH_DAO_AGGREGATION */
+#if RPL_WITH_PROJECTED_ROUTES
+  rpl_projected_reset();
+#endif /* RPL_WITH_PROJECTED_ROUTES */
 
   /* Stop all timers */
   rpl_timers_stop_dag_timers();
@@ -128,6 +143,12 @@ rpl_dag_leave(void)
 }
 /*---------------------------------------------------------------------------*/
 void
+rpl_dag_leave(void)
+{
+  leave_dag(1);
+}
+/*---------------------------------------------------------------------------*/
+void
 rpl_dag_poison_and_leave(void)
 {
   curr_instance.dag.state = DAG_POISONING;
@@ -151,6 +172,12 @@ rpl_dag_periodic(unsigned seconds)
         rpl_icmp6_dis_output(rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent));
       }
     }
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+    /* Move to another DODAG if it offers a significantly better rank */
+    if(curr_instance.dag.preferred_parent != NULL) {
+      switch_to_alt_dag(0);
+    }
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -185,6 +212,177 @@ find_objective_function(rpl_ocp_t ocp)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+/* The best DIO recently heard from other DODAGs of our instance */
+struct alt_dag {
+  uip_ipaddr_t from;
+  rpl_dio_t dio;
+  rpl_rank_t rank; /* Estimated rank if joining through 'from' */
+  clock_time_t last_heard;
+  uint8_t used;
+};
+static struct alt_dag alt_dags[RPL_MAX_DAG_PER_INSTANCE - 1];
+/* After moving to another DODAG, stay there at least this long unless the
+ * preferred parent is lost, so that rank estimates can settle */
+#define DAG_SWITCH_HOLDDOWN (5 * 60 * CLOCK_SECOND)
+static struct timer switch_holddown;
+/*---------------------------------------------------------------------------*/
+static int
+alt_dag_is_fresh(const struct alt_dag *alt)
+{
+  /* Fresh until two maximum DIO intervals have elapsed. The interval comes
+   * from the network: clamp its exponent to keep the shift defined. */
+  unsigned exp = MIN(alt->dio.dag_intmin + alt->dio.dag_intdoubl, 31);
+  uint64_t max_interval = ((uint64_t)(1UL << exp) * CLOCK_SECOND) / 1000;
+  return alt->used && (uint64_t)(clock_time() - alt->last_heard) <= 2 * max_interval;
+}
+/*---------------------------------------------------------------------------*/
+/* The bias added to the rank of a DODAG, pseudo-random but stable for a
+ * given node and DODAG ID */
+static uint16_t
+dag_bias(const uip_ipaddr_t *dag_id)
+{
+  uint16_t hash = 0;
+  int i;
+
+  if(RPL_DAG_LOAD_SPLIT_BIAS == 0) {
+    return 0;
+  }
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    hash = hash * 31 + linkaddr_node_addr.u8[i];
+  }
+  for(i = 0; i < sizeof(uip_ipaddr_t); i++) {
+    hash = hash * 31 + dag_id->u8[i];
+  }
+  return hash % RPL_DAG_LOAD_SPLIT_BIAS;
+}
+/*---------------------------------------------------------------------------*/
+static rpl_rank_t
+estimate_rank_via(uip_ipaddr_t *from, rpl_dio_t *dio)
+{
+  const uip_lladdr_t *lladdr = uip_ds6_nbr_lladdr_from_ipaddr(from);
+  const struct link_stats *stats = link_stats_from_lladdr((const linkaddr_t *)lladdr);
+  rpl_of_t *of = find_objective_function(dio->ocp);
+
+  /* The rank the DODAG's OF would give us, on the scale of our own rank.
+   * Without link statistics yet, assume a perfect link. */
+  return of->rank_via_link(dio->rank, dio->dag_min_hoprankinc,
+                           stats != NULL ? stats->etx : LINK_STATS_ETX_DIVISOR);
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_alt_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
+{
+  struct alt_dag *alt = NULL;
+  struct alt_dag *replaced = NULL;
+  rpl_rank_t rank;
+  int i;
+
+  if(rpl_dag_root_is_root()
+     || (dio->mop != RPL_MOP_NO_DOWNWARD_ROUTES && dio->mop != RPL_MOP_NON_STORING)
+     || find_objective_function(dio->ocp) == NULL) {
+    return;
+  }
+
+  for(i = 0; i < RPL_MAX_DAG_PER_INSTANCE - 1; i++) {
+    if(alt_dags[i].used && uip_ipaddr_cmp(&alt_dags[i].dio.dag_id, &dio->dag_id)) {
+      alt = &alt_dags[i];
+      break;
+    }
+    /* Otherwise, replace an unused or stale entry, else the worst one */
+    if(replaced == NULL || !alt_dag_is_fresh(&alt_dags[i])
+       || (alt_dag_is_fresh(replaced) && alt_dags[i].rank > replaced->rank)) {
+      replaced = &alt_dags[i];
+    }
+  }
+
+  if(dio->rank == RPL_INFINITE_RANK || dio->rank < ROOT_RANK) {
+    /* Forget the DODAG if this was the node we would join through */
+    if(alt != NULL && uip_ipaddr_cmp(&alt->from, from)) {
+      alt->used = 0;
+    }
+    return;
+  }
+
+  /* The sender must be in the IPv6 neighbor cache for us to join through it */
+  if(!rpl_icmp6_update_nbr_table(from, NBR_TABLE_REASON_RPL_DIO, dio)) {
+    return;
+  }
+  rank = estimate_rank_via(from, dio);
+
+  if(alt != NULL) {
+    /* Keep the best sender of this DODAG */
+    if(!uip_ipaddr_cmp(&alt->from, from) && alt_dag_is_fresh(alt)
+       && rank >= alt->rank) {
+      return;
+    }
+  } else {
+    if(alt_dag_is_fresh(replaced) && rank >= replaced->rank) {
+      return;
+    }
+    alt = replaced;
+    LOG_INFO("tracking alternative DAG ");
+    LOG_INFO_6ADDR(&dio->dag_id);
+    LOG_INFO_(", rank %u\n", rank);
+  }
+
+  uip_ipaddr_copy(&alt->from, from);
+  memcpy(&alt->dio, dio, sizeof(alt->dio));
+  alt->rank = rank;
+  alt->last_heard = clock_time();
+  alt->used = 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Move to the best alternative DODAG. Unless failing over, only if its
+ * rank is better than ours by RPL_DAG_SWITCH_THRESHOLD */
+static void
+switch_to_alt_dag(int failover)
+{
+  struct alt_dag *best = NULL;
+  struct alt_dag alt;
+  uint32_t best_rank = 0;
+  int i;
+
+  if(!curr_instance.used || rpl_dag_root_is_root()) {
+    return;
+  }
+
+  for(i = 0; i < RPL_MAX_DAG_PER_INSTANCE - 1; i++) {
+    uint32_t rank = (uint32_t)alt_dags[i].rank + dag_bias(&alt_dags[i].dio.dag_id);
+    if(alt_dag_is_fresh(&alt_dags[i])
+       && alt_dags[i].dio.instance_id == curr_instance.instance_id
+       && uip_ds6_nbr_lookup(&alt_dags[i].from) != NULL
+       && (best == NULL || rank < best_rank)) {
+      best = &alt_dags[i];
+      best_rank = rank;
+    }
+  }
+
+  if(best == NULL) {
+    return;
+  }
+  if(!failover
+     && (!timer_expired(&switch_holddown)
+         || best_rank + RPL_DAG_SWITCH_THRESHOLD
+            >= (uint32_t)curr_instance.dag.rank + dag_bias(&curr_instance.dag.dag_id))) {
+    return;
+  }
+  timer_set(&switch_holddown, DAG_SWITCH_HOLDDOWN);
+
+  LOG_WARN("%s to DAG ", failover ? "failing over" : "switching");
+  LOG_WARN_6ADDR(&best->dio.dag_id);
+  LOG_WARN_(", rank %u (was %u)\n", best->rank, curr_instance.dag.rank);
+
+  /* The entry is about to describe our current DODAG */
+  memcpy(&alt, best, sizeof(alt));
+  best->used = 0;
+
+  /* Leave without forgetting link statistics, then join as on a new DIO */
+  leave_dag(0);
+  rpl_process_dio(&alt.from, &alt.dio);
+}
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
+/*---------------------------------------------------------------------------*/
 void
 rpl_refresh_routes(const char *str)
 {
@@ -266,6 +464,9 @@ void
 rpl_dag_update_state(void)
 {
   rpl_rank_t old_rank;
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+  int lost_parent = 0;
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
 
   if(!curr_instance.used) {
     return;
@@ -296,7 +497,7 @@ rpl_dag_update_state(void)
     /* Update better_parent_since flag for each neighbor */
     nbr = nbr_table_head(rpl_neighbors);
     while(nbr != NULL) {
-      if(rpl_neighbor_rank_via_nbr(nbr) < curr_instance.dag.rank) {
+      if(nbr->rank_via < curr_instance.dag.rank) {
         /* This neighbor would be a better parent than our current.
         Set 'better_parent_since' if not already set. */
         if(nbr->better_parent_since == 0) {
@@ -347,6 +548,9 @@ rpl_dag_update_state(void)
         rpl_timers_dio_reset("Poison routes");
         rpl_timers_schedule_periodic_dis();
         rpl_timers_schedule_leaving();
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+        lost_parent = 1;
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
       }
 
       if(LOG_INFO_ENABLED) {
@@ -360,6 +564,13 @@ rpl_dag_update_state(void)
 
   /* Finally, update metric container */
   curr_instance.of->update_metric_container();
+
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+  if(lost_parent) {
+    /* Fail over to another DODAG rather than waiting for this one to recover */
+    switch_to_alt_dag(1);
+  }
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
 }
 /*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
@@ -385,6 +596,12 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
       LOG_ERR("failed to add neighbor\n");
       return NULL;
     }
+#if RPL_WITH_PROBING
+    if(link_stats_in_probe_burst(rpl_neighbor_get_link_stats(nbr))) {
+      /* Bootstrap the link estimate of the new neighbor quickly */
+      rpl_schedule_probing_burst();
+    }
+#endif /* RPL_WITH_PROBING */
   }
 
   /* Update neighbor info from DIO */
@@ -393,6 +610,7 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 #if RPL_WITH_MC
   memcpy(&nbr->mc, &dio->mc, sizeof(nbr->mc));
 #endif /* RPL_WITH_MC */
+  rpl_neighbor_update(nbr);
 
   return nbr;
 }
@@ -613,6 +831,12 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     process_dio_from_current_dag(from, dio);
     rpl_dag_update_state();
   }
+#if RPL_MAX_DAG_PER_INSTANCE > 1
+  else if(curr_instance.used && curr_instance.instance_id == dio->instance_id) {
+    /* Another DODAG of our instance: remember it for failover */
+    record_alt_dio(from, dio);
+  }
+#endif /* RPL_MAX_DAG_PER_INSTANCE > 1 */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -629,21 +853,99 @@ rpl_process_dis(uip_ipaddr_t *from, int is_multicast)
   }
 }
 /*---------------------------------------------------------------------------*/
-void
-rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao)
+#if RPL_WITH_DAO_AGGREGATION
+rpl_dao_agg_target_t *
+rpl_dag_dao_agg_next(rpl_dao_agg_target_t *prev)
+{
+  rpl_dao_agg_target_t *t = prev == NULL ? dao_agg_targets : prev + 1;
+
+  for(; t < dao_agg_targets + RPL_DAO_AGGREGATION_MAX_TARGETS; t++) {
+    if(t->state != RPL_DAO_AGG_FREE) {
+      return t;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+aggregate_dao_target(rpl_dao_t *dao)
+{
+  rpl_dao_agg_target_t *t = NULL;
+  int i;
+
+  if(curr_instance.dag.preferred_parent == NULL || dao->prefixlen != 128) {
+    return RPL_DAO_ACK_UNABLE_TO_ACCEPT;
+  }
+
+  /* Update the entry of this target if any, else use a free one */
+  for(i = 0; i < RPL_DAO_AGGREGATION_MAX_TARGETS; i++) {
+    if(dao_agg_targets[i].state == RPL_DAO_AGG_FREE) {
+      if(t == NULL) {
+        t = &dao_agg_targets[i];
+      }
+    } else if(uip_ipaddr_cmp(&dao_agg_targets[i].target, &dao->prefix)) {
+      t = &dao_agg_targets[i];
+      break;
+    }
+  }
+
+  /* Send our next DAO soon, coalescing targets received in the meantime */
+  rpl_timers_schedule_aggregated_dao();
+
+  if(t == NULL) {
+    /* No room left: have the child send its DAO again later rather than
+       let it time out and detach */
+    LOG_WARN("no room left to aggregate DAO target ");
+    LOG_WARN_6ADDR(&dao->prefix);
+    LOG_WARN_("\n");
+    return RPL_DAO_ACK_TRY_LATER;
+  }
+
+  uip_ipaddr_copy(&t->target, &dao->prefix);
+  uip_ipaddr_copy(&t->parent, &dao->parent_addr);
+  t->lifetime = dao->lifetime;
+  t->state = RPL_DAO_AGG_PENDING;
+  return RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+uint8_t
+rpl_process_dao_target(uip_ipaddr_t *from, rpl_dao_t *dao)
 {
+  const uip_ipaddr_t *node = from;
+
+#if RPL_WITH_DAO_AGGREGATION
+  if(!rpl_dag_root_is_root()) {
+    /* Not the root: buffer the target for our next DAO */
+    return aggregate_dao_target(dao);
+  }
+  /* The DAO may have been aggregated by a child: the target is the node */
+  if(dao->prefixlen == 128) {
+    node = &dao->prefix;
+  }
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
   if(dao->lifetime == 0) {
-    uip_sr_expire_parent(NULL, from, &dao->parent_addr);
+    uip_sr_expire_parent(NULL, node, &dao->parent_addr);
   } else {
-    if(!uip_sr_update_node(NULL, from, &dao->parent_addr, RPL_LIFETIME(dao->lifetime))) {
+    if(!uip_sr_update_node(NULL, node, &dao->parent_addr, RPL_LIFETIME(dao->lifetime))) {
       LOG_ERR("failed to add link on incoming DAO\n");
-      return;
+      return RPL_DAO_ACK_UNABLE_TO_ACCEPT;
     }
   }
+  return RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao, uint8_t status)
+{
+  if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
+    return;
+  }
 
 #if RPL_WITH_DAO_ACK
   if(dao->flags & RPL_DAO_K_FLAG) {
-    rpl_timers_schedule_dao_ack(from, dao->sequence);
+    rpl_timers_schedule_dao_ack(from, dao->sequence, status);
   }
 #endif /* RPL_WITH_DAO_ACK */
 }
@@ -659,12 +961,51 @@ rpl_process_dao_ack(uint8_t sequence, uint8_t status)
   /* Is this an ACK for our last DAO? */
   if(sequence == curr_instance.dag.dao_last_seqno) {
     int status_ok = status < RPL_DAO_ACK_UNABLE_TO_ACCEPT;
+#if RPL_WITH_DAO_AGGREGATION
+    rpl_dao_agg_target_t *t;
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
+    if(status == RPL_DAO_ACK_TRY_LATER) {
+      /* Our parent is alive but could not take all targets of this DAO:
+         keep them, and send them again after a delay */
+      LOG_INFO("DAO-ACK with seqno %u asks to try later\n", sequence);
+#if RPL_WITH_DAO_AGGREGATION
+      for(t = rpl_dag_dao_agg_next(NULL); t != NULL; t = rpl_dag_dao_agg_next(t)) {
+        if(t->state == RPL_DAO_AGG_SENT && t->seqno == sequence) {
+          t->state = RPL_DAO_AGG_PENDING;
+        }
+      }
+#endif /* RPL_WITH_DAO_AGGREGATION */
+      rpl_timers_schedule_dao();
+      return;
+    }
+
     if(curr_instance.dag.state == DAG_JOINED && status_ok) {
       curr_instance.dag.state = DAG_REACHABLE;
       rpl_timers_dio_reset("Reachable");
     }
+#if RPL_WITH_DAO_AGGREGATION
+    if(status_ok) {
+      /* The targets sent in this DAO are now our parent's business */
+      for(t = rpl_dag_dao_agg_next(NULL); t != NULL; t = rpl_dag_dao_agg_next(t)) {
+        if(t->state == RPL_DAO_AGG_SENT && t->seqno == sequence) {
+          t->state = RPL_DAO_AGG_FREE;
+        }
+      }
+    }
+#endif /* RPL_WITH_DAO_AGGREGATION */
     /* Let the rpl-timers module know that we got an ACK for the last DAO */
     rpl_timers_notify_dao_ack();
+#if RPL_WITH_DAO_AGGREGATION
+    /* Targets that did not fit in this DAO go in the next one, now */
+    for(t = rpl_dag_dao_agg_next(NULL); status_ok && t != NULL;
+        t = rpl_dag_dao_agg_next(t)) {
+      if(t->state == RPL_DAO_AGG_PENDING) {
+        rpl_timers_schedule_aggregated_dao();
+        break;
+      }
+    }
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
     if(!status_ok) {
       /* We got a NACK, start poisoning and leave */
@@ -159,12 +159,46 @@ void rpl_process_dis(uip_ipaddr_t *from, int is_multicast);
 void rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio);
 
 /**
- * Processes incoming DAO
+ * Processes one target of an incoming DAO, along with its transit information
+ *
+ * \param from The IPv6 address of the originator
+ * \param dao A pointer to a parsed DAO, holding the target and transit
+ * \return The DAO-ACK status for the target: RPL_DAO_ACK_UNCONDITIONAL_ACCEPT,
+ * RPL_DAO_ACK_TRY_LATER, or RPL_DAO_ACK_UNABLE_TO_ACCEPT if rejected
+*/
+uint8_t rpl_process_dao_target(uip_ipaddr_t *from, rpl_dao_t *dao);
+
+/**
+ * Processes incoming DAO, once all its targets have been processed
  *
  * \param from The IPv6 address of the originator
  * \param dao A pointer to a parsed DAO
+ * \param status The highest DAO-ACK status of its targets
+*/
+void rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao, uint8_t status);
+
+#if RPL_WITH_DAO_AGGREGATION
+/* A target received from a child, to be advertised in our next DAO */
+typedef struct rpl_dao_agg_target {
+  uip_ipaddr_t target;
+  uip_ipaddr_t parent;
+  uint8_t lifetime;
+  uint8_t state; /* One of RPL_DAO_AGG_* */
+  uint8_t seqno; /* Sequence number of the DAO it was last sent in */
+} rpl_dao_agg_target_t;
+
+#define RPL_DAO_AGG_FREE    0
+#define RPL_DAO_AGG_PENDING 1
+#define RPL_DAO_AGG_SENT    2
+
+/**
+ * Iterates over the targets buffered for our next DAO
+ *
+ * \param prev The previous target, or NULL to get the first one
+ * \return The next target, or NULL if none is left
 */
-void rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao);
+rpl_dao_agg_target_t *rpl_dag_dao_agg_next(rpl_dao_agg_target_t *prev);
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
 /**
  * Processes incoming DAO-ACK
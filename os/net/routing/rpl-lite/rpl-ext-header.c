@@ -83,6 +83,18 @@ rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
     return 1;
   }
 
+#if RPL_WITH_PROJECTED_ROUTES
+  if(uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)) {
+    const rpl_projected_route_t *route = rpl_projected_route_lookup(&UIP_IP_BUF->destipaddr);
+    if(route != NULL && route->num_hops == 0) {
+      /* Projected route to a child of ours, send directly */
+      uip_ipaddr_copy(ipaddr, &UIP_IP_BUF->destipaddr);
+      uip_create_linklocal_prefix(ipaddr);
+      return 1;
+    }
+  }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
   LOG_DBG("no SRH found\n");
   return 0;
 }
@@ -216,6 +228,17 @@ insert_srh_header(void)
     return 0;
   }
 
+#if RPL_WITH_PROJECTED_ROUTES
+  if(!uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)
+     && rpl_is_addr_in_our_dag(&UIP_IP_BUF->srcipaddr)
+     && !uipbuf_is_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FRAG_PROBED)) {
+    /* Peer-to-peer traffic through the root, may deserve a projected route.
+     * A datagram reassembled after a fragment forwarding decision was
+     * already counted then. */
+    rpl_projected_observe(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+  }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
   /* Compute path length and compression factors (we use cmpri == cmpre) */
   path_len = 0;
   node = dest_node->parent;
@@ -302,6 +325,76 @@ insert_srh_header(void)
   return 1;
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_PROJECTED_ROUTES
+/* Used by rpl_ext_header_update to insert a RPL SRH extension header
+ * following a projected route, at the source of a packet. Returns 1 on
+ * success, 0 on failure.
+*/
+static int
+insert_projected_srh(const rpl_projected_route_t *route)
+{
+  uint8_t ext_len;
+  uint8_t cmpri;
+  uint8_t padding;
+  uint8_t *hop_ptr;
+  int i;
+
+  struct uip_routing_hdr *rh_hdr = (struct uip_routing_hdr *)UIP_IP_PAYLOAD(0);
+  struct uip_rpl_srh_hdr *srh_hdr = (struct uip_rpl_srh_hdr *)(UIP_IP_PAYLOAD(0) + RPL_RH_LEN);
+
+  /* The addresses field holds all hops but the first, and the target. We
+   * use cmpri = cmpre, the bytes in common between all of them. */
+  cmpri = 15;
+  for(i = 0; i < route->num_hops; i++) {
+    cmpri = MIN(cmpri, count_matching_bytes(&route->hops[i], &route->target, 16));
+  }
+
+  ext_len = RPL_RH_LEN + RPL_SRH_LEN + route->num_hops * (16 - cmpri);
+  padding = ext_len % 8 == 0 ? 0 : (8 - (ext_len % 8));
+  ext_len += padding;
+
+  LOG_INFO("SRH projected route to ");
+  LOG_INFO_6ADDR(&route->target);
+  LOG_INFO_(", path len %u, Cmpr %u, ext len %u (padding %u)\n",
+      route->num_hops, cmpri, ext_len, padding);
+
+  if(uip_len + ext_len > UIP_LINK_MTU) {
+    LOG_ERR("packet too long: impossible to add source routing header (%u bytes)\n", ext_len);
+    return 0;
+  }
+
+  /* Move existing ext headers and payload ext_len further */
+  memmove(UIP_IP_PAYLOAD(ext_len), UIP_IP_PAYLOAD(0), uip_len - UIP_IPH_LEN);
+  memset(UIP_IP_PAYLOAD(0), 0, ext_len);
+
+  /* Insert source routing header (as first ext header) */
+  rh_hdr->next = UIP_IP_BUF->proto;
+  UIP_IP_BUF->proto = UIP_PROTO_ROUTING;
+
+  rh_hdr->len = (ext_len - 8) / 8;
+  rh_hdr->routing_type = RPL_RH_TYPE_SRH;
+  rh_hdr->seg_left = route->num_hops;
+
+  srh_hdr->cmpr = (cmpri << 4) + cmpri;
+  srh_hdr->pad = padding << 4;
+
+  hop_ptr = ((uint8_t *)rh_hdr) + RPL_RH_LEN + RPL_SRH_LEN;
+  for(i = 1; i < route->num_hops; i++) {
+    memcpy(hop_ptr, ((const uint8_t *)&route->hops[i]) + cmpri, 16 - cmpri);
+    hop_ptr += 16 - cmpri;
+  }
+  memcpy(hop_ptr, ((const uint8_t *)&route->target) + cmpri, 16 - cmpri);
+
+  /* The first hop is placed as the current IPv6 destination */
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &route->hops[0]);
+
+  uipbuf_add_ext_hdr(ext_len);
+  uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
+
+  return 1;
+}
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+/*---------------------------------------------------------------------------*/
 int
 rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
 {
@@ -445,6 +538,20 @@ rpl_ext_header_update(void)
         && UIP_IP_BUF->ttl == uip_ds6_if.cur_hop_limit) {
       /* Insert HBH option at source. Checking the address is not sufficient because
        * in non-storing mode, a packet may go up and then down the same path again */
+#if RPL_WITH_PROJECTED_ROUTES
+      const rpl_projected_route_t *route = rpl_projected_route_lookup(&UIP_IP_BUF->destipaddr);
+      if(route != NULL) {
+        if(route->num_hops > 0) {
+          return insert_projected_srh(route);
+        }
+        /* Direct child: the packet is going down */
+        if(!insert_hbh_header()) {
+          return 0;
+        }
+        ((struct uip_ext_hdr_opt_rpl *)UIP_IP_PAYLOAD(2))->flags |= RPL_HDR_OPT_DOWN;
+        return 1;
+      }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
       return insert_hbh_header();
     } else {
       /* Update HBH option at forwarders */
@@ -62,6 +62,14 @@
 #define RPL_DIO_MOP_MASK                 0x38
 #define RPL_DIO_PREFERENCE_MASK          0x07
 
+/* Length of a target and transit information sub-option pair in a DAO */
+#define DAO_TARGET_TRANSIT_LEN           (4 + 16 + 6 + 16)
+/* Maximum DAO length, leaving room for the RPL hop-by-hop option, so that
+ * the receiver gets and parses the whole DAO. No point in going beyond our
+ * own target plus all the aggregated ones. */
+#define DAO_MAX_LEN                      MIN(UIP_BUFSIZE - UIP_IPH_LEN - UIP_ICMPH_LEN - RPL_HOP_BY_HOP_LEN, \
+                                             4 + (1 + RPL_DAO_AGGREGATION_MAX_TARGETS) * DAO_TARGET_TRANSIT_LEN)
+
 /*---------------------------------------------------------------------------*/
 static void dis_input(void);
 static void dio_input(void);
@@ -451,16 +459,98 @@ rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr)
   uip_icmp6_send(addr, ICMP6_RPL, RPL_CODE_DIO, pos);
 }
 /*---------------------------------------------------------------------------*/
+static uint8_t
+process_dao_target(uip_ipaddr_t *from, rpl_dao_t *dao)
+{
+  /* Destination Advertisement Object */
+  LOG_INFO("received a %sDAO from ", dao->lifetime == 0 ? "No-path " : "");
+  LOG_INFO_6ADDR(from);
+  LOG_INFO_(", seqno %u, lifetime %u, prefix ", dao->sequence, dao->lifetime);
+  LOG_INFO_6ADDR(&dao->prefix);
+  LOG_INFO_(", prefix length %u, parent ", dao->prefixlen);
+  LOG_INFO_6ADDR(&dao->parent_addr);
+  LOG_INFO_(" \n");
+
+  return rpl_process_dao_target(from, dao);
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_PROJECTED_ROUTES
+static void
+pdao_input(uip_ipaddr_t *from, const unsigned char *buffer, int pos, int buffer_length)
+{
+  uip_ipaddr_t target;
+  uint8_t prefixlen;
+  uint8_t lifetime;
+  uint8_t num_hops;
+  const unsigned char *hops;
+  int has_target;
+  int has_via;
+  int len;
+  int i;
+
+  has_target = 0;
+  has_via = 0;
+  lifetime = 0;
+  num_hops = 0;
+  hops = NULL;
+  for(i = pos; i < buffer_length; i += len) {
+    if(buffer[i] == RPL_OPTION_PAD1) {
+      len = 1;
+      continue;
+    }
+    len = 2 + buffer[i + 1];
+    if(i + len > buffer_length) {
+      break;
+    }
+
+    switch(buffer[i]) {
+      case RPL_OPTION_TARGET:
+        prefixlen = buffer[i + 3];
+        if(prefixlen != sizeof(target) * CHAR_BIT || len < 4 + (int)sizeof(target)) {
+          LOG_ERR("pdao_input: unsupported target, discard\n");
+          return;
+        }
+        memcpy(&target, buffer + i + 4, sizeof(target));
+        has_target = 1;
+        break;
+      case RPL_OPTION_SR_VIO:
+        /* Flags, lifetime, then the hops */
+        lifetime = buffer[i + 3];
+        num_hops = (len - 4) / sizeof(uip_ipaddr_t);
+        hops = buffer + i + 4;
+        has_via = 1;
+        break;
+    }
+  }
+
+  if(!has_target || !has_via) {
+    LOG_ERR("pdao_input: missing target or via information, discard\n");
+    return;
+  }
+
+  LOG_INFO("received a projected DAO from ");
+  LOG_INFO_6ADDR(from);
+  LOG_INFO_(", target ");
+  LOG_INFO_6ADDR(&target);
+  LOG_INFO_(", %u hops, lifetime %u\n", num_hops, lifetime);
+
+  rpl_projected_process_pdao(from, &target, (const uip_ipaddr_t *)hops,
+                             num_hops, lifetime);
+}
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+/*---------------------------------------------------------------------------*/
 static void
 dao_input(void)
 {
   struct rpl_dao dao;
   uint8_t subopt_type;
   unsigned char *buffer;
-  uint8_t buffer_length;
+  int buffer_length;
   int pos;
   int len;
   int i;
+  int has_target;
+  uint8_t status;
   uip_ipaddr_t from;
 
   memset(&dao, 0, sizeof(dao));
@@ -495,7 +585,17 @@ dao_input(void)
     pos += 16;
   }
 
-  /* Check if there are any RPL options present. */
+#if RPL_WITH_PROJECTED_ROUTES
+  if(dao.flags & RPL_DAO_P_FLAG) {
+    pdao_input(&from, buffer, pos, buffer_length);
+    goto discard;
+  }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
+  /* Check if there are any RPL options present. Every target is processed
+   * along with the transit information that follows it */
+  has_target = 0;
+  status = RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
   for(i = pos; i < buffer_length; i += len) {
     subopt_type = buffer[i];
     if(subopt_type == RPL_OPTION_PAD1) {
@@ -511,6 +611,7 @@ dao_input(void)
         dao.prefixlen = buffer[i + 3];
         memset(&dao.prefix, 0, sizeof(dao.prefix));
         memcpy(&dao.prefix, buffer + i + 4, (dao.prefixlen + 7) / CHAR_BIT);
+        has_target = 1;
         break;
       case RPL_OPTION_TRANSIT:
         /* The path sequence and control are ignored. */
@@ -520,33 +621,64 @@ dao_input(void)
         if(len >= 20) {
           memcpy(&dao.parent_addr, buffer + i + 6, 16);
         }
+        if(has_target) {
+          status = MAX(status, process_dao_target(&from, &dao));
+          has_target = 0;
+        }
         break;
     }
   }
 
-  /* Destination Advertisement Object */
-  LOG_INFO("received a %sDAO from ", dao.lifetime == 0 ? "No-path " : "");
-  LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
-  LOG_INFO_(", seqno %u, lifetime %u, prefix ", dao.sequence, dao.lifetime);
-  LOG_INFO_6ADDR(&dao.prefix);
-  LOG_INFO_(", prefix length %u, parent ", dao.prefixlen);
-  LOG_INFO_6ADDR(&dao.parent_addr);
-  LOG_INFO_(" \n");
+  if(has_target) {
+    /* A target with no transit information */
+    status = MAX(status, process_dao_target(&from, &dao));
+  }
 
-  rpl_process_dao(&from, &dao);
+  rpl_process_dao(&from, &dao, status);
 
   discard:
     uipbuf_clear();
 }
 /*---------------------------------------------------------------------------*/
+static int
+add_target_transit(unsigned char *buffer, int pos, const uip_ipaddr_t *target,
+                   const uip_ipaddr_t *parent, uint8_t lifetime)
+{
+  uint8_t prefixlen = sizeof(*target) * CHAR_BIT;
+
+  /* create target subopt */
+  buffer[pos++] = RPL_OPTION_TARGET;
+  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = prefixlen;
+  memcpy(buffer + pos, target, (prefixlen + 7) / CHAR_BIT);
+  pos += ((prefixlen + 7) / CHAR_BIT);
+
+  /* Create a transit information sub-option. */
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 20;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = lifetime;
+  memcpy(buffer + pos, parent, 16);
+  pos += 16;
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
 void
 rpl_icmp6_dao_output(uint8_t lifetime)
 {
   unsigned char *buffer;
-  uint8_t prefixlen;
   int pos;
   const uip_ipaddr_t *prefix = rpl_get_global_address();
   uip_ipaddr_t *parent_ipaddr = rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent);
+  uip_ipaddr_t parent_global;
+#if RPL_WITH_DAO_AGGREGATION
+  rpl_dao_agg_target_t *t;
+  unsigned aggregated = 0;
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
   /* Make sure we're up-to-date before sending data out */
   rpl_dag_update_state();
@@ -581,28 +713,36 @@ rpl_icmp6_dao_output(uint8_t lifetime)
   buffer[pos++] = 0; /* reserved */
   buffer[pos++] = curr_instance.dag.dao_last_seqno;
 
-  /* create target subopt */
-  prefixlen = sizeof(*prefix) * CHAR_BIT;
-  buffer[pos++] = RPL_OPTION_TARGET;
-  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = prefixlen;
-  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
-  pos += ((prefixlen + 7) / CHAR_BIT);
-
-  /* Create a transit information sub-option. */
-  buffer[pos++] = RPL_OPTION_TRANSIT;
-  buffer[pos++] = 20;
-  buffer[pos++] = 0; /* flags - ignored */
-  buffer[pos++] = 0; /* path control - ignored */
-  buffer[pos++] = 0; /* path seq - ignored */
-  buffer[pos++] = lifetime;
-
-  /* Include parent global IP address */
-  memcpy(buffer + pos, &curr_instance.dag.dag_id, 8); /* Prefix */
-  pos += 8;
-  memcpy(buffer + pos, ((const unsigned char *)parent_ipaddr) + 8, 8); /* Interface identifier */
-  pos += 8;
+  /* Create target and transit information sub-options, including our
+   * parent's global IP address */
+  memcpy(&parent_global, &curr_instance.dag.dag_id, 8); /* Prefix */
+  memcpy(((unsigned char *)&parent_global) + 8, ((const unsigned char *)parent_ipaddr) + 8, 8); /* Interface identifier */
+  pos = add_target_transit(buffer, pos, prefix, &parent_global, lifetime);
+
+#if RPL_WITH_DAO_AGGREGATION
+  /* Add the targets received from our children, unless we are leaving */
+  for(t = rpl_dag_dao_agg_next(NULL); t != NULL; t = rpl_dag_dao_agg_next(t)) {
+    if(lifetime == 0 || pos + DAO_TARGET_TRANSIT_LEN > DAO_MAX_LEN) {
+      break;
+    }
+    pos = add_target_transit(buffer, pos, &t->target, &t->parent, t->lifetime);
+#if RPL_WITH_DAO_ACK
+    /* Kept until this DAO is ACKed */
+    t->state = RPL_DAO_AGG_SENT;
+    t->seqno = curr_instance.dag.dao_last_seqno;
+#else /* RPL_WITH_DAO_ACK */
+    t->state = RPL_DAO_AGG_FREE;
+#endif /* RPL_WITH_DAO_ACK */
+    aggregated++;
+  }
+#if !RPL_WITH_DAO_ACK
+  if(t != NULL && lifetime != 0) {
+    /* Send the targets that did not fit in a next DAO. With DAO-ACKs,
+       this is done once the present DAO is ACKed */
+    rpl_timers_schedule_aggregated_dao();
+  }
+#endif /* !RPL_WITH_DAO_ACK */
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
   LOG_INFO("sending a %sDAO seqno %u, tx count %u, lifetime %u, prefix ",
          lifetime == 0 ? "No-path " : "",
@@ -612,11 +752,63 @@ rpl_icmp6_dao_output(uint8_t lifetime)
   LOG_INFO_6ADDR(&curr_instance.dag.dag_id);
   LOG_INFO_(", parent ");
   LOG_INFO_6ADDR(parent_ipaddr);
+#if RPL_WITH_DAO_AGGREGATION
+  LOG_INFO_(", %u aggregated targets\n", aggregated);
+
+  /* Send DAO to our parent, which forwards the targets to the root */
+  uip_icmp6_send(parent_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
+#else /* RPL_WITH_DAO_AGGREGATION */
   LOG_INFO_("\n");
 
   /* Send DAO to root (IPv6 address is DAG ID) */
   uip_icmp6_send(&curr_instance.dag.dag_id, ICMP6_RPL, RPL_CODE_DAO, pos);
+#endif /* RPL_WITH_DAO_AGGREGATION */
+}
+#if RPL_WITH_PROJECTED_ROUTES
+/*---------------------------------------------------------------------------*/
+void
+rpl_icmp6_pdao_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *target,
+                      const uip_ipaddr_t *hops, uint8_t num_hops, uint8_t lifetime)
+{
+  static uint8_t pdao_seqno = RPL_LOLLIPOP_INIT;
+  unsigned char *buffer;
+  int pos;
+
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+
+  RPL_LOLLIPOP_INCREMENT(pdao_seqno);
+
+  buffer[pos++] = curr_instance.instance_id;
+  buffer[pos++] = RPL_DAO_P_FLAG;
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = pdao_seqno;
+
+  /* Target sub-option */
+  buffer[pos++] = RPL_OPTION_TARGET;
+  buffer[pos++] = 2 + sizeof(*target);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = sizeof(*target) * CHAR_BIT;
+  memcpy(buffer + pos, target, sizeof(*target));
+  pos += sizeof(*target);
+
+  /* Source-routed via information sub-option */
+  buffer[pos++] = RPL_OPTION_SR_VIO;
+  buffer[pos++] = 2 + num_hops * sizeof(uip_ipaddr_t);
+  buffer[pos++] = 0; /* flags */
+  buffer[pos++] = lifetime;
+  memcpy(buffer + pos, hops, num_hops * sizeof(uip_ipaddr_t));
+  pos += num_hops * sizeof(uip_ipaddr_t);
+
+  LOG_INFO("sending a projected DAO seqno %u to ", pdao_seqno);
+  LOG_INFO_6ADDR(dest);
+  LOG_INFO_(", target ");
+  LOG_INFO_6ADDR(target);
+  LOG_INFO_(", %u hops, lifetime %u\n", num_hops, lifetime);
+
+  uip_icmp6_send(dest, ICMP6_RPL, RPL_CODE_DAO, pos);
 }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
 #if RPL_WITH_DAO_ACK
 /*---------------------------------------------------------------------------*/
 static void
@@ -114,7 +114,9 @@ void rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr);
 
 /**
  * Creates an ICMPv6 DAO packet and sends it to the root, advertising the
- * current preferred parent, and with our global address as prefix.
+ * current preferred parent, and with our global address as prefix. With
+ * RPL_WITH_DAO_AGGREGATION, the DAO is sent to the preferred parent instead,
+ * and also carries the targets received from our children.
  *
  * \param lifetime The DAO lifetime. Use 0 to send a No-path DAO
 */
@@ -130,6 +132,21 @@ void rpl_icmp6_dao_output(uint8_t lifetime);
 */
 void rpl_icmp6_dao_ack_output(uip_ipaddr_t *dest, uint8_t sequence, uint8_t status);
 
+#if RPL_WITH_PROJECTED_ROUTES
+/**
+ * Creates an ICMPv6 projected DAO packet and sends it. Used by the root
+ * to install a source route towards target at the node dest.
+ *
+ * \param dest The IPv6 address of the node that installs the route
+ * \param target The destination of the projected route
+ * \param hops The hops between dest and target, in order
+ * \param num_hops The number of hops
+ * \param lifetime The route lifetime, in lifetime units
+*/
+void rpl_icmp6_pdao_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *target,
+                           const uip_ipaddr_t *hops, uint8_t num_hops, uint8_t lifetime);
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
 /**
  * Initializes rpl-icmp6 module, registers ICMPv6 handlers for all
  * RPL ICMPv6 messages: DIO, DIS, DAO and DAO-ACK
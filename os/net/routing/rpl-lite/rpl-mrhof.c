@@ -175,6 +175,15 @@ rank_via_nbr(rpl_nbr_t *nbr)
   return MAX(MIN((uint32_t)nbr->rank + min_hoprankinc, RPL_INFINITE_RANK), path_cost);
 }
 /*---------------------------------------------------------------------------*/
+static rpl_rank_t
+rank_via_link(rpl_rank_t rank, uint16_t min_hoprankinc, uint16_t link_metric)
+{
+  /* As rank_via_nbr, with the rank as path cost: the metric container of
+   * a node we do not track is not known */
+  uint32_t path_cost = MIN((uint32_t)rank + link_metric_to_rank(link_metric), 0xffff);
+  return MAX(MIN((uint32_t)rank + min_hoprankinc, RPL_INFINITE_RANK), path_cost);
+}
+/*---------------------------------------------------------------------------*/
 static int
 nbr_has_usable_link(rpl_nbr_t *nbr)
 {
@@ -297,6 +306,7 @@ rpl_of_t rpl_mrhof = {
   nbr_is_acceptable_parent,
   nbr_path_cost,
   rank_via_nbr,
+  rank_via_link,
   best_parent,
   update_metric_container,
   RPL_OCP_MRHOF
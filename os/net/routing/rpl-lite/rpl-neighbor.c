@@ -64,6 +64,10 @@ static rpl_nbr_t * best_parent(int fresh_only);
 /* Per-neighbor RPL information */
 NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
 
+/* All neighbors, sorted by increasing cached path cost. Parent selection
+walks the head of this list instead of querying the OF for every neighbor. */
+static rpl_nbr_t *candidates;
+
 /*---------------------------------------------------------------------------*/
 static int
 max_acceptable_rank(void)
@@ -191,6 +195,63 @@ rpl_get_ds6_nbr(rpl_nbr_t *nbr)
 #endif /* UIP_ND6_SEND_NS */
 /*---------------------------------------------------------------------------*/
 static void
+candidate_remove(rpl_nbr_t *nbr)
+{
+  rpl_nbr_t **curr;
+
+  for(curr = &candidates; *curr != NULL; curr = &(*curr)->next_candidate) {
+    if(*curr == nbr) {
+      *curr = nbr->next_candidate;
+      nbr->next_candidate = NULL;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+candidate_insert(rpl_nbr_t *nbr)
+{
+  rpl_nbr_t **curr;
+
+  /* Insert after the neighbors with the same path cost */
+  for(curr = &candidates;
+      *curr != NULL && (*curr)->path_cost <= nbr->path_cost;
+      curr = &(*curr)->next_candidate);
+  nbr->next_candidate = *curr;
+  *curr = nbr;
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update(rpl_nbr_t *nbr)
+{
+  if(nbr == NULL || !curr_instance.used) {
+    return;
+  }
+  candidate_remove(nbr);
+  nbr->path_cost = curr_instance.of->nbr_path_cost(nbr);
+  nbr->rank_via = rpl_neighbor_rank_via_nbr(nbr);
+  candidate_insert(nbr);
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_update_all(void)
+{
+  rpl_nbr_t *nbr;
+
+  if(!curr_instance.used) {
+    return;
+  }
+  candidates = NULL;
+  for(nbr = nbr_table_head(rpl_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    nbr->path_cost = curr_instance.of->nbr_path_cost(nbr);
+    nbr->rank_via = rpl_neighbor_rank_via_nbr(nbr);
+    candidate_insert(nbr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
 remove_neighbor(rpl_nbr_t *nbr)
 {
   /* Make sure we don't point to a removed neighbor. Note that we do not need
@@ -205,6 +266,7 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
+  candidate_remove(nbr);
   nbr_table_remove(rpl_neighbors, nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
@@ -353,6 +415,37 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
   return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_usable_parent(rpl_nbr_t *nbr, int fresh_only)
+{
+  if(nbr == NULL) {
+    return 0;
+  }
+
+  if(!acceptable_rank(nbr->rank_via)
+    || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+    /* Exclude neighbors with a rank that is not acceptable */
+    return 0;
+  }
+
+  if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
+    /* Filter out non-fresh nerighbors if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  {
+  uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
+    return 0;
+  }
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
 best_parent(int fresh_only)
 {
@@ -363,30 +456,20 @@ best_parent(int fresh_only)
     return NULL;
   }
 
-  /* Search for the best parent according to the OF */
-  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+  /* Start from the preferred parent, so that the OF applies its hysteresis */
+  if(is_usable_parent(curr_instance.dag.preferred_parent, fresh_only)) {
+    best = curr_instance.dag.preferred_parent;
+  }
 
-    if(!acceptable_rank(rpl_neighbor_rank_via_nbr(nbr))
-      || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
-      /* Exclude neighbors with a rank that is not acceptable */
-      continue;
+  /* Candidates are sorted by path cost: only those not more costly than the
+  current best may replace it, the rest of the list is not visited */
+  for(nbr = candidates; nbr != NULL; nbr = nbr->next_candidate) {
+    if(best != NULL && nbr->path_cost > best->path_cost) {
+      break;
     }
-
-    if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
-      /* Filter out non-fresh nerighbors if fresh_only is set */
+    if(nbr == best || !is_usable_parent(nbr, fresh_only)) {
       continue;
     }
-
-#if UIP_ND6_SEND_NS
-    {
-    uip_ds6_nbr_t *ds6_nbr = rpl_get_ds6_nbr(nbr);
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(ds6_nbr == NULL || ds6_nbr->state != NBR_REACHABLE) {
-      continue;
-    }
-    }
-#endif /* UIP_ND6_SEND_NS */
-
     /* Now we have an acceptable parent, check if it is the new best */
     best = curr_instance.of->best_parent(best, nbr);
   }
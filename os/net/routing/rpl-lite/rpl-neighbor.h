@@ -192,6 +192,21 @@ void rpl_neighbor_remove_all(void);
 */
 rpl_nbr_t *rpl_neighbor_select_best(void);
 
+/**
+ * Recomputes the path cost and rank via a neighbor and updates its position
+ * among the parent candidates. To be called whenever the neighbor's rank,
+ * metric container or link metric changes.
+ *
+ * \param nbr The neighbor
+*/
+void rpl_neighbor_update(rpl_nbr_t *nbr);
+
+/**
+ * Recomputes the path cost and rank via all neighbors, e.g. when metrics
+ * may have changed without rpl_neighbor_update being called
+*/
+void rpl_neighbor_update_all(void);
+
 /**
 * Print a textual description of RPL neighbor into a string
 *
@@ -74,13 +74,13 @@
 #endif /* RPL_OF0_CONF_SR */
 
 #if RPL_OF0_FIXED_SR
-#define STEP_OF_RANK(nbr)       (3)
+#define STEP_OF_RANK(etx)       (3)
 #endif /* RPL_OF0_FIXED_SR */
 
 #if RPL_OF0_ETX_BASED_SR
 /* Numbers suggested by P. Thubert for in the 6TiSCH WG. Anything that maps ETX to
  * a step between 1 and 9 works. */
-#define STEP_OF_RANK(nbr)       (((3 * nbr_link_metric(nbr)) / LINK_STATS_ETX_DIVISOR) - 2)
+#define STEP_OF_RANK(etx)       (((3 * (uint32_t)(etx)) / LINK_STATS_ETX_DIVISOR) - 2)
 #endif /* RPL_OF0_ETX_BASED_SR */
 
 /*---------------------------------------------------------------------------*/
@@ -106,7 +106,7 @@ nbr_rank_increase(rpl_nbr_t *nbr)
     return RPL_INFINITE_RANK;
   }
   min_hoprankinc = curr_instance.min_hoprankinc;
-  return (RANK_FACTOR * STEP_OF_RANK(nbr) + RANK_STRETCH) * min_hoprankinc;
+  return (RANK_FACTOR * STEP_OF_RANK(nbr_link_metric(nbr)) + RANK_STRETCH) * min_hoprankinc;
 }
 /*---------------------------------------------------------------------------*/
 static uint16_t
@@ -129,6 +129,14 @@ rank_via_nbr(rpl_nbr_t *nbr)
   }
 }
 /*---------------------------------------------------------------------------*/
+static rpl_rank_t
+rank_via_link(rpl_rank_t rank, uint16_t min_hoprankinc, uint16_t link_metric)
+{
+  uint32_t rank_increase = (RANK_FACTOR * STEP_OF_RANK(link_metric) + RANK_STRETCH)
+                           * (uint32_t)min_hoprankinc;
+  return MIN((uint32_t)rank + rank_increase, RPL_INFINITE_RANK);
+}
+/*---------------------------------------------------------------------------*/
 static int
 nbr_has_usable_link(rpl_nbr_t *nbr)
 {
@@ -138,8 +146,9 @@ nbr_has_usable_link(rpl_nbr_t *nbr)
 static int
 nbr_is_acceptable_parent(rpl_nbr_t *nbr)
 {
-  return STEP_OF_RANK(nbr) >= MIN_STEP_OF_RANK
-      && STEP_OF_RANK(nbr) <= MAX_STEP_OF_RANK;
+  uint16_t link_metric = nbr_link_metric(nbr);
+  return STEP_OF_RANK(link_metric) >= MIN_STEP_OF_RANK
+      && STEP_OF_RANK(link_metric) <= MAX_STEP_OF_RANK;
 }
 /*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
@@ -192,6 +201,7 @@ rpl_of_t rpl_of0 = {
   nbr_is_acceptable_parent,
   nbr_path_cost,
   rank_via_nbr,
+  rank_via_link,
   best_parent,
   update_metric_container,
   RPL_OCP_OF0
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup rpl-lite
+ * @{
+ *
+ * \file
+ *         Projected routes: the root detects heavy peer-to-peer flows
+ *         and installs a source route at the flow source, so that its
+ *         packets turn at the common ancestor instead of the root.
+ */
+
+#include "contiki.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/ipv6/uip-sr.h"
+#include "net/routing/routing.h"
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "RPL"
+#define LOG_LEVEL LOG_LEVEL_RPL
+
+#if RPL_WITH_PROJECTED_ROUTES
+
+/* Flows are counted over periods of this many seconds */
+#define FLOW_PERIOD_SECONDS 60
+
+/* A flow seen at the root */
+struct projected_flow {
+  uip_ipaddr_t src;
+  uip_ipaddr_t dest;
+  uint16_t count; /* Packets forwarded in the current period */
+  uint8_t used;
+  uint8_t project; /* Set when a projected DAO is due */
+};
+
+/* At the root: flows being counted */
+static struct projected_flow flows[RPL_PROJECTED_ROUTE_FLOWS];
+static struct ctimer project_timer;
+static unsigned flow_period_age;
+
+/* At other nodes: projected routes installed by the root */
+static rpl_projected_route_t routes[RPL_PROJECTED_ROUTE_NUM];
+
+/*---------------------------------------------------------------------------*/
+/* Computes the path from src to dest that turns at their lowest common
+ * ancestor. Writes the hops strictly between src and dest to 'hops', and
+ * returns their number, or -1 if there is no such path shorter than
+ * RPL_PROJECTED_ROUTE_MAX_HOPS, or if the common ancestor is the root. */
+static int
+compute_path(const uip_ipaddr_t *src, const uip_ipaddr_t *dest, uip_ipaddr_t *hops)
+{
+  uip_sr_node_t *root_node;
+  uip_sr_node_t *src_node;
+  uip_sr_node_t *dest_node;
+  uip_sr_node_t *lca;
+  uip_sr_node_t *node;
+  int up_len;
+  int down_len;
+  int num_hops;
+  int i;
+
+  root_node = uip_sr_get_node(NULL, &curr_instance.dag.dag_id);
+  src_node = uip_sr_get_node(NULL, src);
+  dest_node = uip_sr_get_node(NULL, dest);
+  if(root_node == NULL || src_node == NULL || dest_node == NULL) {
+    return -1;
+  }
+
+  /* Walk up from src until we find an ancestor of dest. up_len is the
+   * number of hops from src to that ancestor, down_len from the ancestor
+   * to dest. Both walks are bounded, which also protects from loops. */
+  up_len = 0;
+  down_len = 0;
+  for(lca = src_node; lca != NULL && lca != root_node; lca = lca->parent) {
+    down_len = 0;
+    for(node = dest_node; node != NULL && node != root_node && node != lca
+        && down_len <= RPL_PROJECTED_ROUTE_MAX_HOPS; node = node->parent) {
+      down_len++;
+    }
+    if(node == lca) {
+      break;
+    }
+    if(++up_len > RPL_PROJECTED_ROUTE_MAX_HOPS) {
+      return -1;
+    }
+  }
+
+  if(lca == NULL || lca == root_node || lca == dest_node) {
+    /* Either the path goes through the root anyway, or dest is an ancestor
+     * of src, which is reached without the root's help */
+    return -1;
+  }
+
+  num_hops = up_len + down_len - 1;
+  if(num_hops > RPL_PROJECTED_ROUTE_MAX_HOPS) {
+    return -1;
+  }
+
+  /* Up from src to the common ancestor, included */
+  node = src_node;
+  for(i = 0; i < up_len; i++) {
+    node = node->parent;
+    NETSTACK_ROUTING.get_sr_node_ipaddr(&hops[i], node);
+  }
+  /* Down to dest, filled from the end */
+  node = dest_node->parent;
+  for(i = num_hops - 1; i >= up_len; i--) {
+    NETSTACK_ROUTING.get_sr_node_ipaddr(&hops[i], node);
+    node = node->parent;
+  }
+
+  return num_hops;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_project_timer(void *ptr)
+{
+  static uip_ipaddr_t hops[RPL_PROJECTED_ROUTE_MAX_HOPS];
+  struct projected_flow *f;
+  uint16_t lifetime;
+  int num_hops;
+
+  if(!curr_instance.used || !rpl_dag_root_is_root()) {
+    return;
+  }
+
+  /* Lifetime in lifetime units, finite */
+  lifetime = RPL_PROJECTED_ROUTE_LIFETIME / MAX(1, curr_instance.lifetime_unit);
+  lifetime = MAX(1, MIN(lifetime, RPL_INFINITE_LIFETIME - 1));
+
+  for(f = flows; f < flows + RPL_PROJECTED_ROUTE_FLOWS; f++) {
+    if(!f->used || !f->project) {
+      continue;
+    }
+    f->project = 0;
+    num_hops = compute_path(&f->src, &f->dest, hops);
+    if(num_hops < 0) {
+      LOG_INFO("projected: no shortcut from ");
+      LOG_INFO_6ADDR(&f->src);
+      LOG_INFO_(" to ");
+      LOG_INFO_6ADDR(&f->dest);
+      LOG_INFO_("\n");
+      continue;
+    }
+    rpl_icmp6_pdao_output(&f->src, &f->dest, hops, num_hops, lifetime);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_projected_observe(const uip_ipaddr_t *src, const uip_ipaddr_t *dest)
+{
+  struct projected_flow *f;
+  struct projected_flow *found = NULL;
+  struct projected_flow *victim = NULL;
+
+  for(f = flows; f < flows + RPL_PROJECTED_ROUTE_FLOWS; f++) {
+    if(!f->used) {
+      if(victim == NULL || victim->used) {
+        victim = f;
+      }
+    } else if(uip_ipaddr_cmp(&f->src, src) && uip_ipaddr_cmp(&f->dest, dest)) {
+      found = f;
+      break;
+    } else if(victim == NULL || (victim->used && f->count < victim->count)) {
+      victim = f;
+    }
+  }
+
+  if(found == NULL) {
+    /* Start counting this flow, replacing the least active one if needed */
+    found = victim;
+    memset(found, 0, sizeof(*found));
+    uip_ipaddr_copy(&found->src, src);
+    uip_ipaddr_copy(&found->dest, dest);
+    found->used = 1;
+  }
+
+  if(found->count < 0xffff) {
+    found->count++;
+  }
+
+  if(found->count == RPL_PROJECTED_ROUTE_THRESHOLD) {
+    /* Not from here: we are in the middle of forwarding a packet */
+    found->project = 1;
+    ctimer_set(&project_timer, 0, handle_project_timer, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_projected_process_pdao(const uip_ipaddr_t *from, const uip_ipaddr_t *target,
+                           const uip_ipaddr_t *hops, uint8_t num_hops,
+                           uint8_t lifetime)
+{
+  rpl_projected_route_t *r;
+  rpl_projected_route_t *found = NULL;
+
+  if(rpl_dag_root_is_root() || !uip_ipaddr_cmp(from, &curr_instance.dag.dag_id)) {
+    LOG_WARN("projected DAO not from our root, discard\n");
+    return;
+  }
+
+  if(num_hops > RPL_PROJECTED_ROUTE_MAX_HOPS) {
+    LOG_WARN("projected DAO with %u hops, discard\n", num_hops);
+    return;
+  }
+
+  for(r = routes; r < routes + RPL_PROJECTED_ROUTE_NUM; r++) {
+    if(r->lifetime > 0 && uip_ipaddr_cmp(&r->target, target)) {
+      found = r;
+      break;
+    }
+    /* Otherwise, pick a free entry, or the one closest to expiration */
+    if(found == NULL || r->lifetime < found->lifetime) {
+      found = r;
+    }
+  }
+
+  if(lifetime == 0) {
+    if(found != NULL && found->lifetime > 0 && uip_ipaddr_cmp(&found->target, target)) {
+      found->lifetime = 0;
+    }
+    return;
+  }
+
+  uip_ipaddr_copy(&found->target, target);
+  memcpy(found->hops, hops, num_hops * sizeof(uip_ipaddr_t));
+  found->num_hops = num_hops;
+  found->lifetime = RPL_LIFETIME(lifetime);
+
+  LOG_INFO("projected route to ");
+  LOG_INFO_6ADDR(target);
+  LOG_INFO_(", %u hops, lifetime %lu\n", num_hops, (unsigned long)found->lifetime);
+}
+/*---------------------------------------------------------------------------*/
+const rpl_projected_route_t *
+rpl_projected_route_lookup(const uip_ipaddr_t *dest)
+{
+  rpl_projected_route_t *r;
+  uip_ipaddr_t next_hop;
+
+  for(r = routes; r < routes + RPL_PROJECTED_ROUTE_NUM; r++) {
+    if(r->lifetime > 0 && uip_ipaddr_cmp(&r->target, dest)) {
+      /* The first hop must still be our neighbor, else we fall back
+       * to routing through the root */
+      uip_ipaddr_copy(&next_hop, r->num_hops > 0 ? &r->hops[0] : &r->target);
+      uip_create_linklocal_prefix(&next_hop);
+      if(rpl_neighbor_get_from_ipaddr(&next_hop) == NULL) {
+        return NULL;
+      }
+      return r;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_projected_periodic(unsigned seconds)
+{
+  rpl_projected_route_t *r;
+  struct projected_flow *f;
+
+  for(r = routes; r < routes + RPL_PROJECTED_ROUTE_NUM; r++) {
+    if(r->lifetime != RPL_ROUTE_INFINITE_LIFETIME) {
+      r->lifetime = r->lifetime > seconds ? r->lifetime - seconds : 0;
+    }
+  }
+
+  flow_period_age += seconds;
+  if(flow_period_age >= FLOW_PERIOD_SECONDS) {
+    flow_period_age = 0;
+    /* Start a new period. Flows idle during the last one are forgotten. */
+    for(f = flows; f < flows + RPL_PROJECTED_ROUTE_FLOWS; f++) {
+      if(f->count == 0) {
+        f->used = 0;
+      }
+      f->count = 0;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_projected_reset(void)
+{
+  ctimer_stop(&project_timer);
+  memset(flows, 0, sizeof(flows));
+  memset(routes, 0, sizeof(routes));
+  flow_period_age = 0;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
+/** @}*/
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup rpl-lite
+ * @{
+ *
+ * \file
+ *	Header file for rpl-projected module: peer-to-peer shortcuts
+ *	projected by the root (see RPL_WITH_PROJECTED_ROUTES)
+ */
+
+#ifndef RPL_PROJECTED_H
+#define RPL_PROJECTED_H
+
+/********** Includes **********/
+
+#include "net/routing/rpl-lite/rpl.h"
+
+#if RPL_WITH_PROJECTED_ROUTES
+
+/********** Public symbols **********/
+
+/* A projected route, as installed at the source of a flow. Packets to
+ * 'target' are source-routed through 'hops' */
+typedef struct rpl_projected_route {
+  uip_ipaddr_t target;
+  uip_ipaddr_t hops[RPL_PROJECTED_ROUTE_MAX_HOPS];
+  uint32_t lifetime; /* In seconds, 0 if the entry is unused */
+  uint8_t num_hops;
+} rpl_projected_route_t;
+
+/********** Public functions **********/
+
+/**
+ * Called at the root for every packet it forwards between two nodes of
+ * the DODAG. Projects a route for the pair once it carries enough traffic.
+ *
+ * \param src The IPv6 source address of the packet
+ * \param dest The IPv6 destination address of the packet
+*/
+void rpl_projected_observe(const uip_ipaddr_t *src, const uip_ipaddr_t *dest);
+
+/**
+ * Processes an incoming projected DAO, installing or refreshing a
+ * projected route
+ *
+ * \param from The IPv6 address of the sender, must be the root
+ * \param target The destination of the route
+ * \param hops The hops to go through, in order
+ * \param num_hops The number of hops
+ * \param lifetime The route lifetime, in lifetime units
+*/
+void rpl_projected_process_pdao(const uip_ipaddr_t *from, const uip_ipaddr_t *target,
+                                const uip_ipaddr_t *hops, uint8_t num_hops,
+                                uint8_t lifetime);
+
+/**
+ * Looks up a projected route
+ *
+ * \param dest The destination IPv6 address
+ * \return The projected route towards dest if any, NULL otherwise
+*/
+const rpl_projected_route_t *rpl_projected_route_lookup(const uip_ipaddr_t *dest);
+
+/**
+ * A function called periodically. Used to age flows and projected routes.
+ *
+ * \param seconds The number of seconds elapsed since last call
+*/
+void rpl_projected_periodic(unsigned seconds);
+
+/**
+ * Flushes all flows and projected routes
+*/
+void rpl_projected_reset(void);
+
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
+ /** @} */
+
+#endif /* RPL_PROJECTED_H */
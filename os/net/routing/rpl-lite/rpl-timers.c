@@ -72,6 +72,9 @@ static void handle_dis_timer(void *ptr);
 static void handle_dio_timer(void *ptr);
 static void handle_unicast_dio_timer(void *ptr);
 static void send_new_dao(void *ptr);
+#if RPL_WITH_DAO_AGGREGATION
+static void send_aggregated_dao(void *ptr);
+#endif /* RPL_WITH_DAO_AGGREGATION */
 #if RPL_WITH_DAO_ACK
 static void resend_dao(void *ptr);
 static void handle_dao_ack_timer(void *ptr);
@@ -271,6 +274,50 @@ rpl_timers_schedule_dao(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_AGGREGATION
+void
+rpl_timers_schedule_aggregated_dao(void)
+{
+  if(curr_instance.used && curr_instance.mop != RPL_MOP_NO_DOWNWARD_ROUTES) {
+    clock_time_t remaining = etimer_expiration_time(&curr_instance.dag.dao_timer.etimer) - clock_time();
+    /* Coalesce with the next DAO if it is due within the aggregation delay.
+     * Otherwise, the new DAO replaces whatever was pending on dao_timer,
+     * including a retransmission: the new DAO has a new sequence number
+     * and carries the targets still waiting for an ACK. */
+    if(ctimer_expired(&curr_instance.dag.dao_timer) || remaining > RPL_DAO_AGGREGATION_DELAY) {
+      ctimer_set(&curr_instance.dag.dao_timer, RPL_DAO_AGGREGATION_DELAY, send_aggregated_dao, NULL);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_aggregated_dao(void *ptr)
+{
+#if RPL_WITH_DAO_ACK
+  uint8_t transmissions = curr_instance.dag.dao_transmissions;
+
+  if(transmissions > 0 &&
+     curr_instance.dag.dao_last_acked_seqno != curr_instance.dag.dao_last_seqno) {
+    /* Our last DAO is still unacked: this one counts as its retransmission,
+       so that children sending DAOs do not hide a dead parent */
+    curr_instance.dag.dao_transmissions = transmissions + 1;
+    RPL_LOLLIPOP_INCREMENT(curr_instance.dag.dao_last_seqno);
+    rpl_icmp6_dao_output(curr_instance.default_lifetime);
+
+    /* Schedule next retransmission, or abort */
+    if(curr_instance.dag.dao_transmissions < RPL_DAO_MAX_RETRANSMISSIONS) {
+      schedule_dao_retransmission();
+    } else {
+      /* No more retransmissions. Perform local repair. */
+      rpl_local_repair("DAO max rtx");
+    }
+    return;
+  }
+#endif /* RPL_WITH_DAO_ACK */
+  send_new_dao(ptr);
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
 static void
 send_new_dao(void *ptr)
 {
@@ -300,11 +347,13 @@ send_new_dao(void *ptr)
 /*---------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 void
-rpl_timers_schedule_dao_ack(uip_ipaddr_t *target, uint16_t sequence)
+rpl_timers_schedule_dao_ack(uip_ipaddr_t *target, uint16_t sequence,
+                            uint8_t status)
 {
   if(curr_instance.used) {
     uip_ipaddr_copy(&curr_instance.dag.dao_ack_target, target);
     curr_instance.dag.dao_ack_sequence = sequence;
+    curr_instance.dag.dao_ack_status = status;
     ctimer_set(&curr_instance.dag.dao_ack_timer, 0, handle_dao_ack_timer, NULL);
   }
 }
@@ -313,7 +362,7 @@ static void
 handle_dao_ack_timer(void *ptr)
 {
   rpl_icmp6_dao_ack_output(&curr_instance.dag.dao_ack_target,
-    curr_instance.dag.dao_ack_sequence, RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+    curr_instance.dag.dao_ack_sequence, curr_instance.dag.dao_ack_status);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -346,9 +395,35 @@ resend_dao(void *ptr)
 /*------------------------------- Probing----------------------------------- */
 /*---------------------------------------------------------------------------*/
 #if RPL_WITH_PROBING
+/* Returns the neighbor in its probing burst with the best rank, if any */
+static rpl_nbr_t *
+get_probe_burst_target(void)
+{
+  rpl_nbr_t *nbr;
+  rpl_nbr_t *target = NULL;
+  rpl_rank_t target_rank = RPL_INFINITE_RANK;
+  rpl_rank_t nbr_rank;
+
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    if(link_stats_in_probe_burst(rpl_neighbor_get_link_stats(nbr))) {
+      nbr_rank = rpl_neighbor_rank_via_nbr(nbr);
+      if(target == NULL || nbr_rank < target_rank) {
+        target = nbr;
+        target_rank = nbr_rank;
+      }
+    }
+  }
+  return target;
+}
+/*---------------------------------------------------------------------------*/
 clock_time_t
 get_probing_delay(void)
 {
+  if(get_probe_burst_target() != NULL) {
+    /* New links get probed at a short interval */
+    return ((RPL_PROBING_BURST_INTERVAL) / 2) + random_rand() % (RPL_PROBING_BURST_INTERVAL);
+  }
   return ((RPL_PROBING_INTERVAL) / 2) + random_rand() % (RPL_PROBING_INTERVAL);
 }
 /*---------------------------------------------------------------------------*/
@@ -382,6 +457,12 @@ get_probing_target(void)
     return curr_instance.dag.preferred_parent;
   }
 
+  /* A new link is in its probing burst */
+  probing_target = get_probe_burst_target();
+  if(probing_target != NULL) {
+    return probing_target;
+  }
+
   /* Now consider probing other non-fresh neighbors. With 2/3 proabability,
   pick the best non-fresh. Otherwise, pick the lest recently updated non-fresh. */
 
@@ -460,6 +541,19 @@ rpl_schedule_probing(void)
 }
 /*---------------------------------------------------------------------------*/
 void
+rpl_schedule_probing_burst(void)
+{
+  /* Bring the next probe forward, unless it is due soon anyway */
+  if(curr_instance.used
+     && (ctimer_expired(&curr_instance.dag.probing_timer)
+         || etimer_expiration_time(&curr_instance.dag.probing_timer.etimer) - clock_time()
+         > RPL_PROBING_BURST_INTERVAL)) {
+    ctimer_set(&curr_instance.dag.probing_timer,
+               random_rand() % (RPL_PROBING_BURST_INTERVAL), handle_probing_timer, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
 rpl_schedule_probing_now(void)
 {
   if(curr_instance.used) {
@@ -514,6 +608,9 @@ handle_periodic_timer(void *ptr)
   if(curr_instance.used) {
     rpl_dag_periodic(PERIODIC_DELAY_SECONDS);
     uip_sr_periodic(PERIODIC_DELAY_SECONDS);
+#if RPL_WITH_PROJECTED_ROUTES
+    rpl_projected_periodic(PERIODIC_DELAY_SECONDS);
+#endif /* RPL_WITH_PROJECTED_ROUTES */
   }
 
   if(!curr_instance.used ||
@@ -522,6 +619,9 @@ handle_periodic_timer(void *ptr)
     rpl_timers_schedule_periodic_dis(); /* Schedule DIS if needed */
   }
 
+  /* Resynchronize the cached path costs, in case link metrics changed
+  without notice, e.g. link stats were evicted */
+  rpl_neighbor_update_all();
   /* Useful because part of the state update is time-dependent, e.g.,
   the meaning of last_advertised_rank changes with time */
   rpl_dag_update_state();
@@ -94,10 +94,25 @@ void rpl_timers_schedule_unicast_dio(rpl_nbr_t *target);
 */
 void rpl_timers_schedule_dao(void);
 
+#if RPL_WITH_DAO_AGGREGATION
+/**
+ * Schedule a DAO within RPL_DAO_AGGREGATION_DELAY, to advertise targets
+ * received from children, unless one is due earlier anyway. Replaces a
+ * pending DAO retransmission, as the new DAO also carries the unacked targets,
+ * and then counts as a retransmission towards RPL_DAO_MAX_RETRANSMISSIONS
+*/
+void rpl_timers_schedule_aggregated_dao(void);
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
 /**
  * Schedule a DAO-ACK with no delay
+ *
+ * \param target The originator of the DAO
+ * \param sequence The sequence number of the DAO
+ * \param status The DAO-ACK status, one of RPL_DAO_ACK_*
 */
-void rpl_timers_schedule_dao_ack(uip_ipaddr_t *target, uint16_t sequence);
+void rpl_timers_schedule_dao_ack(uip_ipaddr_t *target, uint16_t sequence,
+                                 uint8_t status);
 
 /**
  * Let the rpl-timers module know that the last DAO was ACKed
@@ -114,6 +129,12 @@ void rpl_schedule_probing(void);
 */
 void rpl_schedule_probing_now(void);
 
+/**
+ * Schedule probing within RPL_PROBING_BURST_INTERVAL, unless it is due
+ * earlier. Used when a new link enters its probing burst.
+*/
+void rpl_schedule_probing_burst(void);
+
 /**
  * Schedule a state update ASAP. Useful to force an update from a context
  * where updating directly would be unsafe.
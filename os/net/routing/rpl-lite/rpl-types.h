@@ -142,6 +142,12 @@ struct rpl_nbr {
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
   uint8_t dtsn;
+  /* Path cost and rank via the neighbor, as last computed by the OF. Updated
+  by rpl_neighbor_update() whenever the neighbor's rank or link changes. */
+  uint16_t path_cost;
+  rpl_rank_t rank_via;
+  /* Next in the list of parent candidates, sorted by path cost */
+  struct rpl_nbr *next_candidate;
 };
 typedef struct rpl_nbr rpl_nbr_t;
 
@@ -156,6 +162,9 @@ typedef struct rpl_nbr rpl_nbr_t;
   * - nbr_is_acceptable_parent(n) Returns 1 iff the neighbor has a usable rank/link as defined by the OF
   * - nbr_path_cost(n) Returns the path cost of a neighbor
   * - rank_via_nbr(n) Returns our rank if we select a given neighbor as preferred parent
+  * - rank_via_link(r, m, l) Returns our rank if we join, through a link of metric l, a
+  *            node that is not in our neighbor table, of rank r in a DAG with
+  *            MinHopRankIncrease m. Used to compare with other DAGs.
   * - best_parent(n1, n2) Compares two neighbors and returns the best one, according to the OF.
   * - update_metric_container() Updated the DAG metric container from the current OF state
   */
@@ -166,6 +175,7 @@ typedef struct rpl_nbr rpl_nbr_t;
    int (*nbr_is_acceptable_parent)(rpl_nbr_t *);
    uint16_t (*nbr_path_cost)(rpl_nbr_t *);
    rpl_rank_t (*rank_via_nbr)(rpl_nbr_t *);
+   rpl_rank_t (*rank_via_link)(rpl_rank_t, uint16_t, uint16_t);
    rpl_nbr_t *(*best_parent)(rpl_nbr_t *, rpl_nbr_t *);
    void (*update_metric_container)(void);
    rpl_ocp_t ocp;
@@ -217,6 +227,7 @@ struct rpl_dag {
 #if RPL_WITH_DAO_ACK
   uip_ipaddr_t dao_ack_target;
   uint16_t dao_ack_sequence;
+  uint8_t dao_ack_status;
   struct ctimer dao_ack_timer;
 #endif /* RPL_WITH_DAO_ACK */
 };
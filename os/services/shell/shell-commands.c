@@ -52,6 +52,9 @@
 #include "net/ipv6/uiplib.h"
 #include "net/ipv6/uip-icmp6.h"
 #include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/multicast/uip-mcast6-route.h"
 #if BUILD_WITH_RESOLV
 #include "resolv.h"
 #endif /* BUILD_WITH_RESOLV */
@@ -63,6 +66,7 @@
 #endif /* MAC_CONF_WITH_TSCH */
 #if MAC_CONF_WITH_CSMA
 #include "net/mac/csma/csma.h"
+#include "net/mac/csma/csma-output.h"
 #endif
 #include "net/routing/routing.h"
 #include "net/mac/llsec802154.h"
@@ -531,6 +535,62 @@ PT_THREAD(cmd_ip_neighbors(struct pt *pt, shell_output_func output, char *args))
   PT_END(pt);
 
 }
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_nd_stats(struct pt *pt, shell_output_func output, char *args))
+{
+#if UIP_CONF_IPV6_QUEUE_PKT
+  const struct uip_packetqueue_stats *queue_stats;
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+
+  PT_BEGIN(pt);
+
+  SHELL_OUTPUT(output, "Neighbor discovery:\n");
+  SHELL_OUTPUT(output, "-- NS sent: %lu, rate limited: %lu\n",
+               (unsigned long)uip_nd6_stats.ns_sent,
+               (unsigned long)uip_nd6_stats.ns_rate_limited);
+  SHELL_OUTPUT(output, "-- Cache scans: %lu, skipped: %lu, entries visited: %lu\n",
+               (unsigned long)uip_nd6_stats.nbr_scans,
+               (unsigned long)uip_nd6_stats.nbr_scans_skipped,
+               (unsigned long)uip_nd6_stats.nbr_visited);
+#if UIP_CONF_IPV6_QUEUE_PKT
+  queue_stats = uip_packetqueue_get_stats();
+  SHELL_OUTPUT(output, "-- Queued during resolution: %lu, sent: %lu, timed out: %lu\n",
+               (unsigned long)queue_stats->queued, (unsigned long)queue_stats->sent,
+               (unsigned long)queue_stats->timed_out);
+  SHELL_OUTPUT(output, "-- Queue drops: full %lu, evicted %lu, flushed %lu\n",
+               (unsigned long)queue_stats->dropped, (unsigned long)queue_stats->evicted,
+               (unsigned long)queue_stats->flushed);
+#endif /* UIP_CONF_IPV6_QUEUE_PKT */
+
+  PT_END(pt);
+}
+/*---------------------------------------------------------------------------*/
+#if SICSLOWPAN_CONF_FRAG
+static
+PT_THREAD(cmd_6lo_stats(struct pt *pt, shell_output_func output, char *args))
+{
+  const struct sicslowpan_reass_stats *stats;
+
+  PT_BEGIN(pt);
+
+  stats = sicslowpan_get_reass_stats();
+  SHELL_OUTPUT(output, "6LoWPAN reassembly:\n");
+  SHELL_OUTPUT(output, "-- Started: %lu, completed: %lu\n",
+               (unsigned long)stats->started, (unsigned long)stats->completed);
+  SHELL_OUTPUT(output, "-- Timed out: %lu, evicted: %lu\n",
+               (unsigned long)stats->timed_out, (unsigned long)stats->evicted);
+  SHELL_OUTPUT(output, "-- Dropped: no context %lu, no session %lu, no buffer %lu\n",
+               (unsigned long)stats->no_context, (unsigned long)stats->no_session,
+               (unsigned long)stats->no_buffer);
+  SHELL_OUTPUT(output, "-- Ignored: duplicates %lu, invalid %lu\n",
+               (unsigned long)stats->duplicates, (unsigned long)stats->invalid);
+  SHELL_OUTPUT(output, "-- Forwarded fragment by fragment: %lu\n",
+               (unsigned long)stats->forwarded);
+
+  PT_END(pt);
+}
+#endif /* SICSLOWPAN_CONF_FRAG */
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 #if MAC_CONF_WITH_TSCH
 /*---------------------------------------------------------------------------*/
@@ -614,6 +674,12 @@ PT_THREAD(cmd_tsch_status(struct pt *pt, shell_output_func output, char *args))
     SHELL_OUTPUT(output, "-- Network uptime: %lu seconds\n",
                  (unsigned long)(tsch_get_network_uptime_ticks() / CLOCK_SECOND));
   }
+  SHELL_OUTPUT(output, "-- Input ring: peak %u/%u, overflows %u\n",
+               tsch_pending_stats.input_peak, TSCH_MAX_INCOMING_PACKETS - 1,
+               tsch_pending_stats.input_overflows);
+  SHELL_OUTPUT(output, "-- Dequeued ring: peak %u/%u, overflows %u\n",
+               tsch_pending_stats.dequeued_peak, TSCH_DEQUEUED_ARRAY_SIZE - 1,
+               tsch_pending_stats.dequeued_overflows);
 
   PT_END(pt);
 }
@@ -682,6 +748,29 @@ PT_THREAD(cmd_routes(struct pt *pt, shell_output_func output, char *args))
   }
 #endif /* (UIP_MAX_ROUTES != 0) */
 
+#if UIP_MCAST6_ENGINE == UIP_MCAST6_ENGINE_SMRF || UIP_MCAST6_ENGINE == UIP_MCAST6_ENGINE_ESMRF
+  if(uip_mcast6_route_count() > 0) {
+    uip_mcast6_route_t *mcast_route;
+    /* Our multicast forwarding entries */
+    SHELL_OUTPUT(output, "Multicast routes (%u in total):\n", uip_mcast6_route_count());
+    mcast_route = uip_mcast6_route_list_head();
+    while(mcast_route != NULL) {
+      SHELL_OUTPUT(output, "-- ");
+      shell_output_6addr(output, &mcast_route->group);
+#if UIP_MCAST6_STATS
+      SHELL_OUTPUT(output, " (in: %lu, fwd: %lu, dup: %lu)",
+                   (unsigned long)mcast_route->stats.in,
+                   (unsigned long)mcast_route->stats.fwd,
+                   (unsigned long)mcast_route->stats.dup);
+#endif /* UIP_MCAST6_STATS */
+      SHELL_OUTPUT(output, "\n");
+      mcast_route = list_item_next(mcast_route);
+    }
+  } else {
+    SHELL_OUTPUT(output, "No multicast routes\n");
+  }
+#endif /* UIP_MCAST6_ENGINE */
+
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
@@ -833,7 +922,86 @@ PT_THREAD(cmd_tsch_schedule(struct pt *pt, shell_output_func output, char *args)
   }
   PT_END(pt);
 }
+#if TSCH_SLOT_PROFILER
+/*---------------------------------------------------------------------------*/
+static void
+output_slot_phase_stats(shell_output_func output, const char *name,
+                        const struct tsch_slot_phase_stats *stats)
+{
+  int i;
+
+  SHELL_OUTPUT(output, "-- %s: count %lu, avg %lu, max %lu\n", name,
+               (unsigned long)stats->count,
+               stats->count ? (unsigned long)(stats->total / stats->count) : 0ul,
+               (unsigned long)stats->max);
+  SHELL_OUTPUT(output, "---- histogram (<2^i):");
+  for(i = 0; i < TSCH_SLOT_PROFILER_BUCKETS; i++) {
+    SHELL_OUTPUT(output, " %u", stats->histogram[i]);
+  }
+  SHELL_OUTPUT(output, "\n");
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_tsch_profile(struct pt *pt, shell_output_func output, char *args))
+{
+  const struct tsch_slot_profile *profile;
+  int i;
+
+  PT_BEGIN(pt);
+
+  if(args != NULL && !strcmp(args, "reset")) {
+    tsch_slot_profiler_reset();
+    SHELL_OUTPUT(output, "TSCH slot profile cleared\n");
+    PT_EXIT(pt);
+  }
+
+  profile = tsch_slot_profiler_get();
+  SHELL_OUTPUT(output, "TSCH slot profile (rtimer ticks, timeslot %u):\n",
+               (unsigned)tsch_timing[tsch_ts_timeslot_length]);
+  for(i = 0; i < TSCH_SLOT_PHASE_COUNT; i++) {
+    output_slot_phase_stats(output, tsch_slot_profiler_phase_name(i),
+                            &profile->phases[i]);
+  }
+  output_slot_phase_stats(output, "deadline misses (lateness)",
+                          &profile->deadline_misses);
+  SHELL_OUTPUT(output, "-- Timing template check: %s\n",
+               tsch_timeslot_timing_validate(tsch_timing_us) ? "ok" : "failed (see log)");
+
+  PT_END(pt);
+}
+#endif /* TSCH_SLOT_PROFILER */
 #endif /* MAC_CONF_WITH_TSCH */
+#if MAC_CONF_WITH_CSMA
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_csma_stats(struct pt *pt, shell_output_func output, char *args))
+{
+  const struct csma_output_stats *stats;
+  struct csma_neighbor_stats nbr_stats;
+  linkaddr_t addr;
+  int i;
+
+  PT_BEGIN(pt);
+
+  stats = csma_output_get_stats();
+  SHELL_OUTPUT(output, "CSMA: enqueued %lu, recycled queues %lu, burst frames %lu\n",
+               (unsigned long)stats->enqueued, (unsigned long)stats->recycled,
+               (unsigned long)stats->burst_frames);
+  SHELL_OUTPUT(output, "-- Drops: queue full %lu, no buffer %lu, no neighbor queue %lu\n",
+               (unsigned long)stats->dropped_queue_full,
+               (unsigned long)stats->dropped_no_buffer,
+               (unsigned long)stats->dropped_no_neighbor);
+  for(i = 0; csma_output_get_neighbor_stats(i, &addr, &nbr_stats); i++) {
+    SHELL_OUTPUT(output, "-- ");
+    shell_output_lladdr(output, &addr);
+    SHELL_OUTPUT(output, ": backlog %u (max %u), sent %u, failed %u, dropped %u\n",
+                 nbr_stats.backlog, nbr_stats.max_backlog,
+                 nbr_stats.sent, nbr_stats.failed, nbr_stats.dropped);
+  }
+
+  PT_END(pt);
+}
+#endif /* MAC_CONF_WITH_CSMA */
 /*---------------------------------------------------------------------------*/
 #if TSCH_WITH_SIXTOP
 void
@@ -986,6 +1154,10 @@ const struct shell_command_t builtin_shell_commands[] = {
   { "ip-nbr",               cmd_ip_neighbors,         "'> ip-nbr': Shows all IPv6 neighbors" },
   { "ping",                 cmd_ping,                 "'> ping addr': Pings the IPv6 address 'addr'" },
   { "routes",               cmd_routes,               "'> routes': Shows the route entries" },
+  { "nd-stats",             cmd_nd_stats,             "'> nd-stats': Shows neighbor discovery statistics" },
+#if SICSLOWPAN_CONF_FRAG
+  { "6lo-stats",            cmd_6lo_stats,            "'> 6lo-stats': Shows 6LoWPAN reassembly statistics" },
+#endif /* SICSLOWPAN_CONF_FRAG */
 #if BUILD_WITH_RESOLV
   { "nslookup",             cmd_resolv,               "'> nslookup': Lookup IPv6 address of host" },
 #endif /* BUILD_WITH_RESOLV */
@@ -1007,7 +1179,13 @@ const struct shell_command_t builtin_shell_commands[] = {
   { "tsch-set-coordinator", cmd_tsch_set_coordinator, "'> tsch-set-coordinator 0/1 [0/1]': Sets node as coordinator (1) or not (0). Second, optional parameter: enable (1) or disable (0) security." },
   { "tsch-schedule",        cmd_tsch_schedule,        "'> tsch-schedule': Shows the current TSCH schedule" },
   { "tsch-status",          cmd_tsch_status,          "'> tsch-status': Shows a summary of the current TSCH state" },
+#if TSCH_SLOT_PROFILER
+  { "tsch-profile",         cmd_tsch_profile,         "'> tsch-profile [reset]': Shows (or clears) the TSCH slot operation timing profile" },
+#endif /* TSCH_SLOT_PROFILER */
 #endif /* MAC_CONF_WITH_TSCH */
+#if MAC_CONF_WITH_CSMA
+  { "csma-stats",           cmd_csma_stats,           "'> csma-stats': Shows CSMA queue statistics" },
+#endif /* MAC_CONF_WITH_CSMA */
 #if TSCH_WITH_SIXTOP
   { "6top",                 cmd_6top,                 "'> 6top help': Shows 6top command usage" },
 #endif /* TSCH_WITH_SIXTOP */
@@ -48,15 +48,9 @@
 /* Allow to change only 1 channel at once */
 #define TSCH_CS_MAX_CHANNELS_CHANGED 1
 
-/* Do not up change channels more frequently than this */
-#define TSCH_CS_MIN_UPDATE_INTERVAL_SEC 60
-
 /* Do not change channels if the difference in qualities is below this */
 #define TSCH_CS_HYSTERESIS (TSCH_STATS_BINARY_SCALING_FACTOR / 10)
 
-/* After removing a channel from the sequence, do not add it back at least this time */
-#define TSCH_CS_BLACKLIST_DURATION_SEC (5 * 60)
-
 /* A potential for change detected? */
 static bool recaculation_requested;
 
@@ -326,3 +320,40 @@ tsch_cs_channel_stats_updated(uint8_t updated_channel, uint16_t old_busyness_met
     }
   }
 }
+/*---------------------------------------------------------------------------*/
+int
+tsch_cs_skip_tx_channel(struct tsch_neighbor *n, uint8_t channel)
+{
+  int i;
+  int max_blacklisted;
+  int num_worse;
+  tsch_stat_t p_tx;
+  struct tsch_channel_stats *stats;
+  struct tsch_neighbor_stats *nbr_stats = tsch_stats_get_from_neighbor(n);
+
+  if(nbr_stats == NULL) {
+    return 0;
+  }
+  stats = nbr_stats->channel_stats;
+
+  p_tx = stats[tsch_stats_channel_to_index(channel)].p_tx_success;
+  if(p_tx >= TSCH_CS_NEIGHBOR_P_TX_THRESHOLD) {
+    return 0;
+  }
+
+  max_blacklisted = MIN(TSCH_CS_NEIGHBOR_MAX_BLACKLISTED,
+                        tsch_hopping_sequence_length.val / 2);
+
+  /* Blacklisted iff among the max_blacklisted worst channels of the
+   * sequence; ties are broken by channel number */
+  num_worse = 0;
+  for(i = 0; i < tsch_hopping_sequence_length.val; ++i) {
+    uint8_t other = tsch_hopping_sequence[i];
+    tsch_stat_t other_p_tx = stats[tsch_stats_channel_to_index(other)].p_tx_success;
+    if(other_p_tx < p_tx || (other_p_tx == p_tx && other < channel)) {
+      num_worse++;
+    }
+  }
+
+  return num_worse < max_blacklisted;
+}
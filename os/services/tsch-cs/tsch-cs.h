@@ -48,7 +48,47 @@
 #define TSCH_CS_FREE_THRESHOLD ((tsch_stat_t)(85ul * TSCH_STATS_BINARY_SCALING_FACTOR / 100))
 #endif
 
+/* Do not adapt the hopping sequence before stats were learned for this long */
+#ifdef TSCH_CS_CONF_LEARNING_PERIOD_SEC
+#define TSCH_CS_LEARNING_PERIOD_SEC TSCH_CS_CONF_LEARNING_PERIOD_SEC
+#else
 #define TSCH_CS_LEARNING_PERIOD_SEC 30
+#endif
+
+/* Do not change the hopping sequence more frequently than this */
+#ifdef TSCH_CS_CONF_MIN_UPDATE_INTERVAL_SEC
+#define TSCH_CS_MIN_UPDATE_INTERVAL_SEC TSCH_CS_CONF_MIN_UPDATE_INTERVAL_SEC
+#else
+#define TSCH_CS_MIN_UPDATE_INTERVAL_SEC 60
+#endif
+
+/* After removing a channel from the sequence, do not add it back at least this time */
+#ifdef TSCH_CS_CONF_BLACKLIST_DURATION_SEC
+#define TSCH_CS_BLACKLIST_DURATION_SEC TSCH_CS_CONF_BLACKLIST_DURATION_SEC
+#else
+#define TSCH_CS_BLACKLIST_DURATION_SEC (5 * 60)
+#endif
+
+/*
+ * Per-neighbor blacklisting, enabled by defining TSCH_CALLBACK_SKIP_TX_CHANNEL
+ * as tsch_cs_skip_tx_channel: a channel is blacklisted towards a neighbor
+ * while the P_tx learned by TSCH stats on it is below this threshold.
+ * Stats are kept for the time source and TSCH_STATS_CONF_NUM_NEIGHBORS others.
+ */
+#ifdef TSCH_CS_CONF_NEIGHBOR_P_TX_THRESHOLD
+#define TSCH_CS_NEIGHBOR_P_TX_THRESHOLD TSCH_CS_CONF_NEIGHBOR_P_TX_THRESHOLD
+#else
+/* < 30% of transmissions successful */
+#define TSCH_CS_NEIGHBOR_P_TX_THRESHOLD ((tsch_stat_t)(30ul * TSCH_STATS_BINARY_SCALING_FACTOR / 100))
+#endif
+
+/* The maximum number of channels blacklisted towards a neighbor. Never more
+ * than half of the hopping sequence is blacklisted */
+#ifdef TSCH_CS_CONF_NEIGHBOR_MAX_BLACKLISTED
+#define TSCH_CS_NEIGHBOR_MAX_BLACKLISTED TSCH_CS_CONF_NEIGHBOR_MAX_BLACKLISTED
+#else
+#define TSCH_CS_NEIGHBOR_MAX_BLACKLISTED 4
+#endif
 
 /**
  * \brief Initializes the TSCH hopping sequence selection module.
@@ -68,6 +108,19 @@ void tsch_cs_channel_stats_updated(uint8_t updated_channel, uint16_t old_busynes
  */
 bool tsch_cs_process(void);
 
+struct tsch_neighbor;
+
+/**
+ * \brief Check whether a channel is blacklisted towards a neighbor
+ * \param n       The neighbor a unicast packet is to be sent to
+ * \param channel The channel of the current slot
+ * \return 1 if the transmission should be deferred, 0 otherwise
+ *
+ * The worst channels of the hopping sequence, by P_tx towards the
+ * neighbor, are blacklisted. Called from interrupt context.
+ */
+int tsch_cs_skip_tx_channel(struct tsch_neighbor *n, uint8_t channel);
+
 
 /* A bit corresponds to a channel; `uint16_t` value is OK for up to 16 channels. */
 typedef uint16_t tsch_cs_bitmap_t;
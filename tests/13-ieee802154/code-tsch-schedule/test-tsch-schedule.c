@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2026, The Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the timeslot-sorted link index of tsch-schedule.c against a plain
+ * linear search over all links, on randomised schedules built with link
+ * additions, replacements and removals, and slotframe removals.
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/random.h"
+
+#include "net/linkaddr.h"
+#include "net/mac/tsch/tsch.h"
+
+#include "unit-test/unit-test.h"
+
+#include "lib/simEnvChange.h"
+#include "sys/cooja_mt.h"
+
+PROCESS(test_process, "TSCH schedule link index test");
+AUTOSTART_PROCESSES(&test_process);
+
+#define TEST_ROUNDS     1000
+#define TEST_ASNS       16
+
+static const uint16_t test_sizes[] = { 1, 2, 7, 17, 31, 101, 397 };
+static const uint8_t test_options[] = {
+  LINK_OPTION_TX,
+  LINK_OPTION_RX,
+  LINK_OPTION_TX | LINK_OPTION_RX | LINK_OPTION_SHARED,
+  LINK_OPTION_TX | LINK_OPTION_SHARED,
+  LINK_OPTION_RX | LINK_OPTION_TIME_KEEPING,
+};
+static const linkaddr_t test_addrs[] = {
+  {{ 0x01 }},
+  {{ 0x02 }},
+};
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof(a[0]))
+/*---------------------------------------------------------------------------*/
+void
+test_print_report(const unit_test_t *utp)
+{
+  printf("=check-me= ");
+  if(utp->result == unit_test_failure) {
+    printf("FAILED   - %s: exit at L%u\n", utp->descr, utp->exit_line);
+  } else {
+    printf("SUCCEEDED - %s\n", utp->descr);
+  }
+
+  /* give up the CPU so that the mote can output messages in the serial buffer */
+  simProcessRunValue = 1;
+  cooja_mt_yield();
+}
+/*---------------------------------------------------------------------------*/
+/* The lookup as done before the sorted index: walk every link */
+static struct tsch_link *
+linear_next_active_link(struct tsch_asn_t *asn, uint16_t *time_offset,
+                        struct tsch_link **backup_link)
+{
+  uint16_t time_to_curr_best = 0;
+  struct tsch_link *curr_best = NULL;
+  struct tsch_link *curr_backup = NULL;
+  struct tsch_slotframe *sf;
+  struct tsch_link *l;
+
+  for(sf = tsch_schedule_slotframe_head(); sf != NULL;
+      sf = tsch_schedule_slotframe_next(sf)) {
+    uint16_t timeslot = TSCH_ASN_MOD(*asn, sf->size);
+    for(l = list_head(sf->links_list); l != NULL; l = list_item_next(l)) {
+      uint16_t time_to_timeslot =
+        l->timeslot > timeslot ?
+        l->timeslot - timeslot :
+        sf->size.val + l->timeslot - timeslot;
+      if(curr_best == NULL || time_to_timeslot < time_to_curr_best) {
+        time_to_curr_best = time_to_timeslot;
+        curr_best = l;
+        curr_backup = NULL;
+      } else if(time_to_timeslot == time_to_curr_best) {
+        struct tsch_link *new_best = NULL;
+        if((curr_best->link_options & LINK_OPTION_TX) == (l->link_options & LINK_OPTION_TX)) {
+          if(l->slotframe_handle < curr_best->slotframe_handle) {
+            new_best = l;
+          }
+        } else {
+          if(l->link_options & LINK_OPTION_TX) {
+            new_best = l;
+          }
+        }
+        if(curr_backup == NULL) {
+          if(new_best != l && (l->link_options & LINK_OPTION_RX)) {
+            curr_backup = l;
+          }
+          if(new_best != curr_best && (curr_best->link_options & LINK_OPTION_RX)) {
+            curr_backup = curr_best;
+          }
+        }
+        if(new_best != NULL) {
+          curr_best = new_best;
+        }
+      }
+    }
+  }
+  *time_offset = time_to_curr_best;
+  *backup_link = curr_backup;
+  return curr_best;
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+linear_link_by_timeslot(struct tsch_slotframe *sf, uint16_t timeslot)
+{
+  struct tsch_link *l;
+
+  for(l = list_head(sf->links_list); l != NULL; l = list_item_next(l)) {
+    if(l->timeslot == timeslot) {
+      return l;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+random_below(uint16_t n)
+{
+  return random_rand() % n;
+}
+/*---------------------------------------------------------------------------*/
+/* Applies one random change to the schedule */
+static void
+random_schedule_change(void)
+{
+  uint16_t handle = random_below(TSCH_SCHEDULE_MAX_SLOTFRAMES);
+  struct tsch_slotframe *sf = tsch_schedule_get_slotframe_by_handle(handle);
+  uint16_t op = random_below(16);
+
+  if(sf == NULL) {
+    tsch_schedule_add_slotframe(handle, test_sizes[random_below(ARRAY_LEN(test_sizes))]);
+  } else if(op == 0) {
+    tsch_schedule_remove_slotframe(sf);
+  } else if(op < 10) {
+    /* Adds a link, or replaces the one in place at this timeslot */
+    tsch_schedule_add_link(sf,
+                           test_options[random_below(ARRAY_LEN(test_options))],
+                           LINK_TYPE_NORMAL,
+                           &test_addrs[random_below(ARRAY_LEN(test_addrs))],
+                           random_below(sf->size.val), 0);
+  } else {
+    int count = list_length(sf->links_list);
+    if(count > 0) {
+      struct tsch_link *l = list_head(sf->links_list);
+      int i = random_below(count);
+      while(i-- > 0) {
+        l = list_item_next(l);
+      }
+      tsch_schedule_remove_link(sf, l);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_next_active_link,
+                   "get_next_active_link() matches a linear search");
+UNIT_TEST(test_next_active_link)
+{
+  static struct tsch_asn_t asn;
+  static int round;
+  static int i;
+  struct tsch_link *link;
+  struct tsch_link *backup;
+  uint16_t offset;
+  struct tsch_link *expected_link;
+  struct tsch_link *expected_backup;
+  uint16_t expected_offset;
+
+  UNIT_TEST_BEGIN();
+
+  tsch_schedule_remove_all_slotframes();
+  random_init(0x3131);
+
+  for(round = 0; round < TEST_ROUNDS; round++) {
+    random_schedule_change();
+    for(i = 0; i < TEST_ASNS; i++) {
+      TSCH_ASN_INIT(asn, random_below(4),
+                    ((uint32_t)random_rand() << 16) | random_rand());
+      link = tsch_schedule_get_next_active_link(&asn, &offset, &backup);
+      expected_link = linear_next_active_link(&asn, &expected_offset,
+                                              &expected_backup);
+      UNIT_TEST_ASSERT(link == expected_link);
+      UNIT_TEST_ASSERT(link == NULL || offset == expected_offset);
+      UNIT_TEST_ASSERT(backup == expected_backup);
+    }
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_link_by_timeslot,
+                   "get_link_by_timeslot() matches a linear search");
+UNIT_TEST(test_link_by_timeslot)
+{
+  static int round;
+  struct tsch_slotframe *sf;
+  uint16_t timeslot;
+
+  UNIT_TEST_BEGIN();
+
+  tsch_schedule_remove_all_slotframes();
+  random_init(0x3131);
+
+  for(round = 0; round < TEST_ROUNDS; round++) {
+    random_schedule_change();
+    for(sf = tsch_schedule_slotframe_head(); sf != NULL;
+        sf = tsch_schedule_slotframe_next(sf)) {
+      for(timeslot = 0; timeslot < sf->size.val; timeslot++) {
+        UNIT_TEST_ASSERT(tsch_schedule_get_link_by_timeslot(sf, timeslot) ==
+                         linear_link_by_timeslot(sf, timeslot));
+      }
+    }
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(test_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  printf("Run unit-test\n");
+  printf("---\n");
+
+  UNIT_TEST_RUN(test_next_active_link);
+  UNIT_TEST_RUN(test_link_by_timeslot);
+
+  printf("=check-me= DONE\n");
+  PROCESS_END();
+}